@@ -3,9 +3,18 @@
 #include <opencv2/imgproc.hpp>
 #include <opencv2/highgui.hpp>
 #include <iostream>
+#include <cstdio>
+#include <sstream>
 #include <vector>
 #include <filesystem>
 #include <unordered_map>
+#include <fstream>
+#include <algorithm>
+#include <cmath>
+#include "hog_features.hpp"
+#include "linear_svm.hpp"
+#include "logo_detector.hpp"
+#include "../comun/traza.hpp"
 
 using namespace cv;
 using namespace std;
@@ -21,30 +30,10 @@ unordered_map<int, string> categoryNames = {
     {5, "Instagram"}
 };
 
-// Función para calcular el descriptor HOG con normalización
-void computeHOG(Mat img, vector<float> &descriptors) {
-    HOGDescriptor hog(
-        Size(128, 128), 
-        Size(16, 16),    
-        Size(4, 4),     
-        Size(8, 8),     
-        18             
-    );
-
-    resize(img, img, Size(128, 128));
-    GaussianBlur(img, img, Size(3, 3), 0);
-    adaptiveThreshold(img, img, 255, ADAPTIVE_THRESH_GAUSSIAN_C, THRESH_BINARY, 11, 2);
-    equalizeHist(img, img);
-
-    vector<Point> locations;
-    hog.compute(img, descriptors, Size(8, 8), Size(0, 0), locations);
-
-    // Normalizar las características HOG
-    normalize(descriptors, descriptors, 0, 1, NORM_MINMAX);
-}
-
 // Función para obtener el bounding box dinámicamente
 Rect getBoundingBoxForLogo(const Mat& img) {
+    TRAZA_AMBITO("contornos");
+
     // Realizar la detección de bordes usando Canny (puedes usar otro método según tu necesidad)
     Mat edges;
     Canny(img, edges, 100, 200);
@@ -76,54 +65,64 @@ Rect getBoundingBoxForLogo(const Mat& img) {
     return Rect(0, 0, 0, 0);
 }
 
-// Función para realizar la predicción con el modelo SVM
-string predictSVM(const Ptr<SVM>& svm, const vector<float>& descriptor, Rect& boundingBox, const Mat& img) {
-    Mat testSample(1, descriptor.size(), CV_32F);
-    for (size_t i = 0; i < descriptor.size(); i++) {
-        testSample.at<float>(0, i) = descriptor[i];
+// Función para decidir la etiqueta a partir de la puntuación del SVM
+string labelForScore(const LinearSVM::Score& score) {
+    // Si la confianza es baja, consideramos que la clase es desconocida
+    if (fabs(score.raw) < 2) {  // Ajusta el umbral según sea necesario
+        return "desconocido";
     }
 
-    // Obtener la respuesta del SVM (predicción)
-    Mat response;
-    svm->predict(testSample, response);
+    // De lo contrario, retornamos el nombre de la categoría
+    auto it = categoryNames.find(score.label);
+    return it != categoryNames.end() ? it->second : "desconocido";
+}
 
-    // Obtener la distancia al hiperplano
-    Mat dist;
-    svm->predict(testSample, dist, StatModel::RAW_OUTPUT);
+// Función para realizar la predicción con el modelo SVM
+string predictSVM(const LinearSVM& svm, const vector<float>& descriptor, Rect& boundingBox, const Mat& img) {
+    // Etiqueta y salida cruda del SVM en una sola pasada sobre el descriptor
+    LinearSVM::Score score;
+    {
+        TRAZA_AMBITO("svm");
+        score = svm.predict(descriptor.data());
+    }
 
     // Calcula la confianza basándote en la distancia al hiperplano
-    float confidence = dist.at<float>(0, 0);  // La distancia al hiperplano de decisión
+    float confidence = score.raw;  // La distancia al hiperplano de decisión
     cout << "Confianza: " << confidence << endl;
 
-    // Si la confianza es baja, consideramos que la clase es desconocida
-    if (fabs(confidence) < 2) {  // Ajusta el umbral según sea necesario
-        return "desconocido";
-    }
-
-    // De lo contrario, retornamos el nombre de la categoría
-    int predictedClass = static_cast<int>(response.at<float>(0, 0));
-    if (categoryNames.find(predictedClass) != categoryNames.end()) {
+    string label = labelForScore(score);
+    if (label != "desconocido") {
         // Aquí calculamos dinámicamente el bounding box basado en la región de interés detectada
         boundingBox = getBoundingBoxForLogo(img);  // Función para encontrar la región donde está el logo
-        return categoryNames[predictedClass];
     }
-
-    return "desconocido";
+    return label;
 }
 
-
 // Función para predecir un grupo de imágenes de prueba
-void predictBatchSVM(const Ptr<SVM>& svm, const string& testFolderPath) {
+void predictBatchSVM(const LinearSVM& svm, const string& testFolderPath) {
     // Cargar las imágenes de test
     vector<Mat> testImages;
     vector<string> fileNames;
     for (const auto& entry : fs::directory_iterator(testFolderPath)) {
-        Mat img = imread(entry.path().string(), IMREAD_GRAYSCALE);
+        Mat img;
+        {
+            TRAZA_AMBITO("decodificar");
+            img = imread(entry.path().string(), IMREAD_GRAYSCALE);
+        }
         if (!img.empty()) {
             // Preprocesar la imagen antes de calcular el descriptor
-            GaussianBlur(img, img, Size(3, 3), 0);
-            adaptiveThreshold(img, img, 255, ADAPTIVE_THRESH_GAUSSIAN_C, THRESH_BINARY, 11, 2);
-            equalizeHist(img, img);
+            {
+                TRAZA_AMBITO("desenfoque");
+                GaussianBlur(img, img, Size(3, 3), 0);
+            }
+            {
+                TRAZA_AMBITO("umbral");
+                adaptiveThreshold(img, img, 255, ADAPTIVE_THRESH_GAUSSIAN_C, THRESH_BINARY, 11, 2);
+            }
+            {
+                TRAZA_AMBITO("ecualizar");
+                equalizeHist(img, img);
+            }
 
             testImages.push_back(img);
             fileNames.push_back(entry.path().filename().string());
@@ -160,17 +159,287 @@ void predictBatchSVM(const Ptr<SVM>& svm, const string& testFolderPath) {
 }
 
 
+// Resultado de una imagen en el modo sin interfaz
+struct BatchRecord {
+    string file;
+    bool ok = false;
+    string label;
+    LinearSVM::Score score = {-1, 0.0f, 0.0f};
+    Rect boundingBox;
+    // Tiempos por etapa en milisegundos
+    double decodeMs = 0, preprocessMs = 0, hogMs = 0, svmMs = 0, boxMs = 0;
 
+    double totalMs() const { return decodeMs + preprocessMs + hogMs + svmMs + boxMs; }
+};
+
+// Función para obtener la lista de imágenes: todos los archivos de una carpeta (ordenados) o
+// las rutas de un archivo de texto, una por línea
+vector<string> listInputs(const string& input) {
+    vector<string> files;
+    if (fs::is_directory(input)) {
+        for (const auto& entry : fs::directory_iterator(input)) {
+            if (entry.is_regular_file()) {
+                files.push_back(entry.path().string());
+            }
+        }
+        sort(files.begin(), files.end());
+    } else {
+        ifstream list(input);
+        string line;
+        while (getline(list, line)) {
+            if (!line.empty()) {
+                files.push_back(line);
+            }
+        }
+    }
+    return files;
+}
+
+// Función para escapar una cadena dentro de JSON: comillas y barras invertidas llevan una barra
+// delante, y los caracteres de control (por debajo de 0x20, no admitidos en una cadena) van como \u00XX
+string jsonEscape(const string& text) {
+    string out;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char code[7];
+            snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned char>(c));
+            out += code;
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+// Función para escribir un número en JSON: inf y nan no son válidos y se escriben como null
+string jsonNumber(double value) {
+    if (!isfinite(value)) {
+        return "null";
+    }
+    ostringstream out;
+    out << value;
+    return out.str();
+}
+
+// Función para escribir una cadena como campo CSV: entre comillas y con las comillas internas
+// duplicadas (RFC 4180), así las comas y los saltos de línea del nombre no rompen la fila
+string csvQuote(const string& text) {
+    string out = "\"";
+    for (char c : text) {
+        if (c == '"') {
+            out += '"';
+        }
+        out += c;
+    }
+    return out + "\"";
+}
+
+// Función para clasificar un lote de imágenes sin ventanas ni esperas de teclado. Las imágenes
+// se reparten entre todos los núcleos; cada una deja su resultado en su propia ranura y los
+// registros se escriben después en el orden de entrada (CSV o JSON lines).
+void predictHeadless(const LinearSVM& svm, const string& input, const string& outputPath, const string& format) {
+    vector<string> files = listInputs(input);
+    vector<BatchRecord> records(files.size());
+
+    TickMeter wall;
+    wall.start();
+    parallel_for_(Range(0, static_cast<int>(files.size())), [&](const Range& range) {
+        HOGBatchExtractor extractor;
+        Mat descriptor(1, extractor.descriptorSize(), CV_32F);
+        TickMeter tm;
+        for (int i = range.start; i < range.end; i++) {
+            BatchRecord& r = records[i];
+            r.file = files[i];
+
+            tm.reset(); tm.start();
+            Mat img;
+            {
+                TRAZA_AMBITO("decodificar");
+                img = imread(files[i], IMREAD_GRAYSCALE);
+            }
+            tm.stop(); r.decodeMs = tm.getTimeMilli();
+            if (img.empty()) {
+                continue;
+            }
+
+            // Mismo preprocesamiento que predictBatchSVM antes de calcular el descriptor
+            tm.reset(); tm.start();
+            {
+                TRAZA_AMBITO("desenfoque");
+                GaussianBlur(img, img, Size(3, 3), 0);
+            }
+            {
+                TRAZA_AMBITO("umbral");
+                adaptiveThreshold(img, img, 255, ADAPTIVE_THRESH_GAUSSIAN_C, THRESH_BINARY, 11, 2);
+            }
+            {
+                TRAZA_AMBITO("ecualizar");
+                equalizeHist(img, img);
+            }
+            tm.stop(); r.preprocessMs = tm.getTimeMilli();
+
+            tm.reset(); tm.start();
+            extractor.computeRow(img, descriptor);
+            tm.stop(); r.hogMs = tm.getTimeMilli();
+
+            tm.reset(); tm.start();
+            {
+                TRAZA_AMBITO("svm");
+                r.score = svm.predict(descriptor);
+            }
+            r.label = labelForScore(r.score);
+            tm.stop(); r.svmMs = tm.getTimeMilli();
+
+            if (r.label != "desconocido") {
+                tm.reset(); tm.start();
+                r.boundingBox = getBoundingBoxForLogo(img);
+                tm.stop(); r.boxMs = tm.getTimeMilli();
+            }
+            r.ok = true;
+        }
+    });
+    wall.stop();
+
+    ofstream file;
+    if (!outputPath.empty()) {
+        file.open(outputPath);
+        if (!file.is_open()) {
+            cerr << "No se pudo crear " << outputPath << endl;
+            return;
+        }
+    }
+    ostream& out = outputPath.empty() ? cout : file;
+
+    bool json = format == "jsonl";
+    if (!json) {
+        out << "file,ok,label,class,raw,margin,x,y,width,height,decode_ms,preprocess_ms,hog_ms,svm_ms,bbox_ms,total_ms\n";
+    }
+    vector<double> latencies;
+    int failed = 0;
+    for (const auto& r : records) {
+        if (r.ok) {
+            latencies.push_back(r.totalMs());
+        } else {
+            failed++;
+        }
+        const Rect& b = r.boundingBox;
+        if (json) {
+            out << "{\"file\":\"" << jsonEscape(r.file) << "\",\"ok\":" << (r.ok ? "true" : "false")
+                << ",\"label\":\"" << r.label << "\",\"class\":" << r.score.label
+                << ",\"raw\":" << jsonNumber(r.score.raw) << ",\"margin\":" << jsonNumber(r.score.margin)
+                << ",\"bbox\":[" << b.x << "," << b.y << "," << b.width << "," << b.height << "]"
+                << ",\"ms\":{\"decode\":" << jsonNumber(r.decodeMs)
+                << ",\"preprocess\":" << jsonNumber(r.preprocessMs) << ",\"hog\":" << jsonNumber(r.hogMs)
+                << ",\"svm\":" << jsonNumber(r.svmMs) << ",\"bbox\":" << jsonNumber(r.boxMs)
+                << ",\"total\":" << jsonNumber(r.totalMs()) << "}}\n";
+        } else {
+            out << csvQuote(r.file) << "," << r.ok << "," << r.label << "," << r.score.label << ","
+                << r.score.raw << "," << r.score.margin << "," << b.x << "," << b.y << "," << b.width << ","
+                << b.height << "," << r.decodeMs << "," << r.preprocessMs << "," << r.hogMs << ","
+                << r.svmMs << "," << r.boxMs << "," << r.totalMs() << "\n";
+        }
+    }
+
+    // Resumen: totales y latencia por imagen (suma de etapas) en los percentiles 50 y 99
+    sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double q) {
+        if (latencies.empty()) return 0.0;
+        size_t idx = static_cast<size_t>(ceil(q * latencies.size())) - 1;
+        return latencies[min(idx, latencies.size() - 1)];
+    };
+    double seconds = wall.getTimeSec();
+    cerr << "Imágenes: " << records.size() << " (" << failed << " no se pudieron leer)" << endl;
+    cerr << "Tiempo total: " << seconds << " s (" << (seconds > 0 ? records.size() / seconds : 0.0)
+         << " imágenes/s con " << getNumThreads() << " hilos)" << endl;
+    cerr << "Latencia p50: " << percentile(0.50) << " ms, p99: " << percentile(0.99) << " ms" << endl;
+}
+
+// Función para buscar todos los logos de una imagen grande con el detector de ventana deslizante
+void detectLogos(const LinearSVM &model, const string &imagePath, int repeat) {
+    Mat img = imread(imagePath, IMREAD_GRAYSCALE);
+    if (img.empty()) {
+        cerr << "No se pudo cargar la imagen " << imagePath << endl;
+        return;
+    }
+
+    LogoDetector detector(model);
+    vector<Detection> detections;
+
+    // Se repite la detección para medir los cuadros por segundo con imágenes grandes
+    TickMeter tm;
+    for (int r = 0; r < max(repeat, 1); r++) {
+        tm.start();
+        detections = detector.detect(img);
+        tm.stop();
+    }
+    double seconds = tm.getTimeSec() / max(repeat, 1);
+    cout << "Detección en " << img.cols << "x" << img.rows << ": " << seconds * 1000.0 << " ms por imagen ("
+         << (seconds > 0 ? 1.0 / seconds : 0.0) << " imágenes/s)" << endl;
+
+    Mat display;
+    cvtColor(img, display, COLOR_GRAY2BGR);
+    for (const auto &d : detections) {
+        string name = categoryNames.count(d.label) ? categoryNames[d.label] : to_string(d.label);
+        cout << name << " en (" << d.box.x << ", " << d.box.y << ", " << d.box.width << ", " << d.box.height
+             << ") puntuación " << d.score << endl;
+        rectangle(display, d.box, Scalar(0, 0, 255), 2);
+        putText(display, name, Point(d.box.x, d.box.y - 10), FONT_HERSHEY_SIMPLEX, 1, Scalar(0, 255, 0), 2);
+    }
+
+    imshow("Detección", display);
+    waitKey(0);
+}
+
+int main(int argc, char **argv) {
+    const string keys =
+        "{help h  |               | Muestra esta ayuda }"
+        "{model   | logos_svm.xml | Modelo SVM entrenado }"
+        "{test    | test          | Carpeta con las imágenes de test }"
+        "{detect  |               | Imagen en la que buscar todos los logos con ventana deslizante }"
+        "{repeat  | 1             | Repeticiones de la detección para medir imágenes/s }"
+        "{headless|               | Clasifica sin ventanas: carpeta o archivo con una ruta por línea }"
+        "{output  |               | Archivo de resultados del modo sin interfaz (por defecto, salida estándar) }"
+        "{format  | csv           | Formato de resultados del modo sin interfaz: csv o jsonl }"
+        "{traza   | traza.json    | Archivo de trazas por etapa (solo si se compila con TRAZA=1) }";
+    CommandLineParser parser(argc, argv, keys);
+    if (parser.has("help")) {
+        parser.printMessage();
+        return 0;
+    }
 
-int main() {
     // Cargar el modelo SVM guardado
-    Ptr<SVM> svm = SVM::load("logos_svm.xml");
+    LinearSVM svm;
+    if (!svm.load(parser.get<string>("model"))) {
+        return -1;
+    }
+    // predict lee varCount floats del descriptor HOG completo
+    const int hogSize = HOGBatchExtractor().descriptorSize();
+    if (svm.varCount() != hogSize) {
+        cerr << "El modelo espera " << svm.varCount() << " valores y el descriptor HOG tiene " << hogSize << endl;
+        return -1;
+    }
+
+    if (parser.has("detect")) {
+        detectLogos(svm, parser.get<string>("detect"), parser.get<int>("repeat"));
+        TRAZA_VOLCAR(parser.get<string>("traza"));
+        return 0;
+    }
+
+    if (parser.has("headless")) {
+        predictHeadless(svm, parser.get<string>("headless"), parser.get<string>("output"), parser.get<string>("format"));
+        TRAZA_VOLCAR(parser.get<string>("traza"));
+        return 0;
+    }
 
     // Especificar la ruta de las imágenes de test
-    string testFolderPath = "test";  // Cambia a la carpeta donde tienes las imágenes de test
+    string testFolderPath = parser.get<string>("test");
 
     // Realizar la predicción sobre las imágenes de test
     predictBatchSVM(svm, testFolderPath);
 
+    TRAZA_VOLCAR(parser.get<string>("traza"));
     return 0;
 }
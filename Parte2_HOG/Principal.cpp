@@ -7,95 +7,162 @@
 #include <filesystem>
 #include <fstream>
 #include <random>
+#include <algorithm>
+#include <sstream>
+#include <memory>
+#include <numeric>
+#include "hog_features.hpp"
+#include "augmentation.hpp"
+#include "dataset_writer.hpp"
+#include "hog_cache.hpp"
+#include "linear_svm.hpp"
+#include "hog_projection.hpp"
+#include "../comun/traza.hpp"
 
 using namespace cv;
 using namespace std;
 using namespace cv::ml;
 namespace fs = std::filesystem;
 
-// Función para calcular el descriptor HOG con normalización
-void computeHOG(Mat img, vector<float> &descriptors) {
-    HOGDescriptor hog(
-        Size(128, 128), 
-        Size(16, 16),    
-        Size(4, 4),     
-        Size(8, 8),     
-        18             
-    );
-
-    resize(img, img, Size(128, 128));
-    GaussianBlur(img, img, Size(3, 3), 0);
-    adaptiveThreshold(img, img, 255, ADAPTIVE_THRESH_GAUSSIAN_C, THRESH_BINARY, 11, 2);
-    equalizeHist(img, img);
-
-    vector<Point> locations;
-    hog.compute(img, descriptors, Size(8, 8), Size(0, 0), locations);
-
-    // Normalizar las características HOG
-    normalize(descriptors, descriptors, 0, 1, NORM_MINMAX);
-}
-
-// Función para aumentar el dataset con más rotaciones y escalados
-void augmentImage(const Mat &img, vector<Mat> &augmentedImages, int classLabel) {
-    augmentedImages.push_back(img.clone());
-
-    // Rotaciones (-20° a 20°)
-    for (int angle = -20; angle <= 20; angle += 5) {
-        Mat rotated;
-        Point2f center(img.cols / 2.0, img.rows / 2.0);
-        Mat rotationMatrix = getRotationMatrix2D(center, angle, 1.0);
-        warpAffine(img, rotated, rotationMatrix, img.size());
-        augmentedImages.push_back(rotated);
-    }
-
-    // Escalado (80%-120%)
-    for (double scale = 0.8; scale <= 1.2; scale += 0.2) {
-        Mat scaled;
-        resize(img, scaled, Size(), scale, scale);
-        augmentedImages.push_back(scaled);
+// Carpeta de imágenes de una clase y su etiqueta
+struct ClassSource {
+    string path;
+    int label;
+};
+
+// Imagen original a procesar y la clase a la que pertenece
+struct DatasetFile {
+    string path;
+    int label;
+    int index;      // Posición del archivo dentro de su clase
+};
+
+// Función para listar las imágenes de todas las clases en un orden determinista
+vector<DatasetFile> listDataset(const vector<ClassSource> &sources) {
+    vector<DatasetFile> files;
+    for (const auto &source : sources) {
+        vector<string> paths;
+        for (const auto &entry : fs::directory_iterator(source.path)) {
+            if (entry.is_regular_file()) {
+                paths.push_back(entry.path().string());
+            }
+        }
+        // directory_iterator no garantiza ningún orden: se ordena para que las filas no varíen
+        sort(paths.begin(), paths.end());
+        for (size_t i = 0; i < paths.size(); i++) {
+            files.push_back({paths[i], source.label, static_cast<int>(i)});
+        }
     }
-
-    // Reflejo horizontal
-    Mat flipped;
-    flip(img, flipped, 1);
-    augmentedImages.push_back(flipped);
+    return files;
 }
 
-// Función para cargar imágenes y extraer características HOG
-void loadDataset(const string &path, vector<Mat> &images, vector<int> &labels, int classLabel, const string &outputPath) {
-    for (const auto &entry : fs::directory_iterator(path)) {
-        Mat img = imread(entry.path().string(), IMREAD_GRAYSCALE);
-        if (!img.empty()) {
-            vector<Mat> augmentedImages;
-            augmentImage(img, augmentedImages, classLabel);
+// Función para cargar y aumentar las imágenes en paralelo. Cada archivo se decodifica y
+// aumenta en su propia ranura, y luego las ranuras se concatenan en el orden de la lista,
+// por lo que imágenes y etiquetas quedan siempre en el mismo orden. 'keys' recibe la clave
+// de caché de cada imagen aumentada (hash de sus píxeles, así que cambiar los parámetros de
+// augmentImage invalida sus descriptores).
+void loadDataset(const vector<ClassSource> &sources, vector<Mat> &images, vector<int> &labels,
+                 vector<uint64_t> &keys, DatasetWriter &writer) {
+    vector<DatasetFile> files = listDataset(sources);
+    vector<vector<Mat>> slots(files.size());
+    vector<vector<uint64_t>> variantHashes(files.size());
+
+    TickMeter tm;
+    tm.start();
+    parallel_for_(Range(0, static_cast<int>(files.size())), [&](const Range &range) {
+        for (int i = range.start; i < range.end; i++) {
+            const DatasetFile &file = files[i];
+            Mat img;
+            {
+                TRAZA_AMBITO("decodificar");
+                img = imread(file.path, IMREAD_GRAYSCALE);
+            }
+            if (img.empty()) {
+                continue;
+            }
+            {
+                TRAZA_AMBITO("aumentar");
+                augmentImage(img, slots[i], file.label);
+            }
+            for (const auto &augImg : slots[i]) {
+                variantHashes[i].push_back(hashImage(augImg));
+            }
 
             int imgCounter = 0;
-            for (const auto &augImg : augmentedImages) {
-                string savePath = outputPath + "/" + to_string(classLabel) + "_" + to_string(imgCounter++) + ".png";
-                imwrite(savePath, augImg);
-                images.push_back(augImg);
-                labels.push_back(classLabel);
+            for (const auto &augImg : slots[i]) {
+                string name = to_string(file.label) + "_" + to_string(file.index) + "_" + to_string(imgCounter++);
+                writer.write(name, augImg);
             }
         }
+    });
+    tm.stop();
+
+    for (size_t i = 0; i < files.size(); i++) {
+        for (size_t v = 0; v < slots[i].size(); v++) {
+            images.push_back(slots[i][v]);
+            labels.push_back(files[i].label);
+            keys.push_back(variantHashes[i][v]);
+        }
     }
+
+    cout << "Carga y aumentación: " << files.size() << " archivos en " << tm.getTimeSec() << " s" << endl;
 }
 
-// Función para entrenar el clasificador SVM
-void trainSVM(vector<Mat> &images, vector<int> &labels) {
-    vector<vector<float>> trainingData;
-    for (auto &img : images) {
-        vector<float> descriptors;
-        computeHOG(img, descriptors);
-        trainingData.push_back(descriptors);
+// Filas de entrenamiento y de prueba
+struct DatasetSplit {
+    vector<int> train, test;
+};
+
+// Función para dividir el conjunto como siempre: el primer 80% de las filas (en el orden de
+// carga) para entrenamiento y el resto para prueba
+DatasetSplit splitRows(size_t rows, double trainFraction) {
+    const size_t trainSize = static_cast<size_t>(rows * trainFraction);
+    DatasetSplit split;
+    for (size_t i = 0; i < rows; i++) {
+        (i < trainSize ? split.train : split.test).push_back(static_cast<int>(i));
     }
+    return split;
+}
 
-    Mat trainData(trainingData.size(), trainingData[0].size(), CV_32F);
-    for (size_t i = 0; i < trainingData.size(); i++) {
-        for (size_t j = 0; j < trainingData[i].size(); j++) {
-            trainData.at<float>(i, j) = trainingData[i][j];
+// Función para obtener en 'data' los descriptores HOG de las filas indicadas (una fila de
+// 'data' por índice). Las filas presentes en la caché se copian desde el archivo proyectado y
+// solo se calculan en paralelo las de imágenes nuevas o modificadas. Retorna cuántas se calcularon.
+size_t extractRows(const vector<Mat> &images, const vector<uint64_t> &keys, const vector<int> &rows,
+                   const HOGCache *cache, Mat &data) {
+    HOGBatchExtractor probe;
+    data.create(static_cast<int>(rows.size()), probe.descriptorSize(), CV_32F);
+    vector<int> missing;
+    for (size_t j = 0; j < rows.size(); j++) {
+        const float *cached = cache ? cache->find(keys[rows[j]]) : nullptr;
+        if (cached) {
+            memcpy(data.ptr<float>(static_cast<int>(j)), cached, data.cols * sizeof(float));
+        } else {
+            missing.push_back(static_cast<int>(j));
         }
     }
+    parallel_for_(Range(0, static_cast<int>(missing.size())), [&](const Range &range) {
+        HOGBatchExtractor extractor;
+        for (int i = range.start; i < range.end; i++) {
+            extractor.computeRow(images[rows[missing[i]]], data.row(missing[i]));
+        }
+    }, getNumThreads() * 4.0);
+    return missing.size();
+}
+
+// Función para seleccionar hasta 'count' filas repartidas uniformemente en 'rows' (0 = todas)
+vector<int> sampleRows(const vector<int> &rows, int count) {
+    if (count <= 0 || rows.size() <= static_cast<size_t>(count)) {
+        return rows;
+    }
+    vector<int> sample(count);
+    for (int i = 0; i < count; i++) {
+        sample[i] = rows[static_cast<size_t>(i) * rows.size() / count];
+    }
+    return sample;
+}
 
+// Función para ajustar el SVM lineal sobre las filas de trainData
+Ptr<SVM> fitSVM(const Mat &trainData, vector<int> &labels) {
     Mat trainLabels(labels.size(), 1, CV_32S, labels.data());
 
     Ptr<SVM> svm = SVM::create();
@@ -105,31 +172,113 @@ void trainSVM(vector<Mat> &images, vector<int> &labels) {
     svm->setGamma(0.5);  // Ajusta el parámetro gamma para el kernel RBF
     svm->setTermCriteria(TermCriteria(TermCriteria::MAX_ITER, 5000, 1e-7));
 
-    cout << "Entrenando el modelo SVM con parámetros optimizados y HOG..." << endl;
+    TRAZA_AMBITO("svm_entrenar");
     svm->train(trainData, ROW_SAMPLE, trainLabels);
+    return svm;
+}
+
+// Función para entrenar el clasificador SVM (trainData: una fila HOG por imagen, o su
+// proyección si 'projection' no está vacía) y guardarlo junto a la proyección
+void trainSVM(const Mat &trainData, vector<int> &labels, const HOGProjection &projection) {
+    cout << "Entrenando el modelo SVM con parámetros optimizados y HOG..." << endl;
+    Ptr<SVM> svm = fitSVM(trainData, labels);
     cout << "Entrenamiento completado." << endl;
 
     svm->save("logos_svm.xml");
     cout << "Modelo guardado en 'logos_svm.xml'." << endl;
+
+    // La proyección va junto al modelo para que LinearSVM::load la aplique; sin proyección se
+    // borra la de un entrenamiento anterior
+    const string projectionPath = HOGProjection::pathFor("logos_svm.xml");
+    if (projection.empty()) {
+        fs::remove(projectionPath);
+    } else if (projection.save(projectionPath)) {
+        cout << "Proyección guardada en '" << projectionPath << "'." << endl;
+    }
 }
 
-// Función para predicción con el modelo SVM
-string predictSVM(const Ptr<SVM>& svm, const vector<float>& descriptor) {
-    Mat testSample(1, descriptor.size(), CV_32F);
-    for (size_t i = 0; i < descriptor.size(); i++) {
-        testSample.at<float>(0, i) = descriptor[i];
+// Función para ajustar la proyección indicada sobre un conjunto de entrenamiento completo
+HOGProjection fitProjection(HOGProjection::Type type, const Mat &trainData, int dims, int pcaSamples) {
+    if (type == HOGProjection::Type::PCA) {
+        return HOGProjection::fitPCA(trainData, dims, pcaSamples);
     }
+    if (type == HOGProjection::Type::SparseRandom) {
+        return HOGProjection::sparseRandom(trainData.cols, dims);
+    }
+    return HOGProjection();
+}
+
+// Función para medir la precisión frente a la dimensión: para cada dimensión se ajusta la
+// proyección, se entrena un SVM sobre las filas proyectadas y se evalúa en el conjunto de
+// prueba. La primera fila es el descriptor completo. Se informan el tamaño de la matriz de
+// entrenamiento, los tiempos de ajuste y entrenamiento y el costo de predicción por muestra
+// (proyección + SVM sin plegar, y con la proyección plegada en los pesos).
+void reportDimensionSweep(HOGProjection::Type type, const vector<int> &dimsList, const Mat &trainData,
+                          vector<int> &trainLabels, const Mat &testData, const vector<int> &testLabels, int pcaSamples) {
+    cout << "dim,precision_%,matriz_MB,proyeccion_MB,ajuste_s,svm_s,prediccion_us,plegado_us" << endl;
+    vector<int> dims = dimsList;
+    dims.insert(dims.begin(), 0);  // 0 = descriptor completo
+    for (int d : dims) {
+        TickMeter fitTime, svmTime, projectedTime, foldedTime;
+        HOGProjection projection;
+        Mat train, test;
+        if (d == 0) {
+            train = trainData;
+            test = testData;
+        } else {
+            fitTime.start();
+            projection = fitProjection(type, trainData, d, pcaSamples);
+            projection.project(trainData, train);
+            fitTime.stop();
+            projection.project(testData, test);
+        }
+
+        svmTime.start();
+        Ptr<SVM> svm = fitSVM(train, trainLabels);
+        svmTime.stop();
+        const string modelPath = (fs::temp_directory_path() / "logos_svm_barrido.xml").string();
+        svm->save(modelPath);
+        fs::remove(HOGProjection::pathFor(modelPath));  // El modelo ya está en el espacio reducido
+        LinearSVM reduced;
+        reduced.load(modelPath);
+        fs::remove(modelPath);
+
+        int correct = 0;
+        projectedTime.start();
+        for (int i = 0; i < test.rows; i++) {
+            correct += reduced.predict(test.row(i)).label == testLabels[i];
+        }
+        // La proyección de cada muestra se mide por separado con el descriptor sin proyectar
+        vector<float> projected(projection.empty() ? 0 : projection.outputSize());
+        for (int i = 0; d > 0 && i < testData.rows; i++) {
+            projection.project(testData.ptr<float>(i), projected.data());
+        }
+        projectedTime.stop();
 
-    // Obtener la respuesta del SVM (predicción)
-    Mat response;
-    svm->predict(testSample, response);
+        if (d > 0) reduced.foldProjection(projection);
+        foldedTime.start();
+        for (int i = 0; i < testData.rows; i++) {
+            reduced.predict(testData.row(i));
+        }
+        foldedTime.stop();
+
+        const double perSample = testData.rows > 0 ? 1e6 / testData.rows : 0.0;
+        cout << (d > 0 ? projection.outputSize() : trainData.cols) << ","
+             << (test.rows > 0 ? 100.0 * correct / test.rows : 0.0) << ","
+             << train.total() * sizeof(float) / 1e6 << "," << projection.parameterBytes() / 1e6 << ","
+             << fitTime.getTimeSec() << "," << svmTime.getTimeSec() << ","
+             << projectedTime.getTimeSec() * perSample << "," << foldedTime.getTimeSec() * perSample << endl;
+    }
+}
 
-    // Obtener la distancia al hiperplano
-    Mat dist;
-    svm->predict(testSample, dist, StatModel::RAW_OUTPUT);
+// Función para predicción con el modelo SVM (sample: 1 x N, CV_32F)
+string predictSVM(const LinearSVM& svm, const Mat& testSample) {
+    // Etiqueta y salida cruda del SVM en una sola pasada sobre el descriptor
+    TRAZA_AMBITO("svm");
+    LinearSVM::Score score = svm.predict(testSample);
 
     // Calcula la confianza basándote en la distancia al hiperplano
-    float confidence = dist.at<float>(0, 0);  // La distancia al hiperplano de decisión
+    float confidence = score.raw;  // La distancia al hiperplano de decisión
     cout << "Confianza: " << confidence << endl;
 
     // Si la confianza es baja, consideramos que la clase es desconocida
@@ -138,57 +287,181 @@ string predictSVM(const Ptr<SVM>& svm, const vector<float>& descriptor) {
     }
 
     // De lo contrario, retornamos la clase predicha
-    return response.at<float>(0, 0) == -1 ? "desconocido" : to_string(static_cast<int>(response.at<float>(0, 0)));
+    return score.label == -1 ? "desconocido" : to_string(score.label);
 }
 
 // Función principal
-int main() {
+int main(int argc, char **argv) {
+    const string keys =
+        "{help h       |                   | Muestra esta ayuda }"
+        "{dump         | async             | Volcado de imágenes aumentadas: none, sync, async o archive }"
+        "{output       | dataset_augmented | Carpeta (o prefijo del .pack) del volcado }"
+        "{queue        | 256               | Capacidad de la cola del escritor en segundo plano }"
+        "{cache        | hog_cache.bin     | Caché persistente de descriptores HOG (vacío para desactivarla) }"
+        "{proyeccion   | none              | Proyección antes del SVM: none, pca o random (aleatoria dispersa) }"
+        "{dims         | 512               | Dimensiones de la proyección }"
+        "{pca_muestras | 2000              | Filas usadas para ajustar la PCA (0 = todas) }"
+        "{barrido      |                   | Dimensiones separadas por comas: informa la precisión frente a la dimensión }"
+        "{traza        | traza.json        | Archivo de trazas por etapa (solo si se compila con TRAZA=1) }";
+    CommandLineParser parser(argc, argv, keys);
+    if (parser.has("help")) {
+        parser.printMessage();
+        return 0;
+    }
+
     vector<Mat> images;
     vector<int> labels;
-    string outputPath = "dataset_augmented";
-
-    fs::create_directories(outputPath);
+    vector<uint64_t> cacheKeys;
+    DatasetWriter writer(parseDumpMode(parser.get<string>("dump")), parser.get<string>("output"),
+                         static_cast<size_t>(parser.get<int>("queue")));
 
     // Cargar datasets de diferentes clases
-    loadDataset("images/batman", images, labels, 1, outputPath);
-    loadDataset("images/chrome", images, labels, 2, outputPath);
-    loadDataset("images/ebay", images, labels, 3, outputPath);
-    loadDataset("images/facebook", images, labels, 4, outputPath);
-    loadDataset("images/instagram", images, labels, 5, outputPath);
+    vector<ClassSource> sources = {
+        {"images/batman", 1},
+        {"images/chrome", 2},
+        {"images/ebay", 3},
+        {"images/facebook", 4},
+        {"images/instagram", 5}
+    };
+    loadDataset(sources, images, labels, cacheKeys, writer);
 
     cout << "Total de imágenes tras aumentación: " << images.size() << endl;
 
-    // Dividir en conjunto de entrenamiento y prueba (80% entrenamiento, 20% prueba)
-    int trainSize = static_cast<int>(images.size() * 0.8);  // 80% para entrenamiento
-    vector<Mat> trainImages(images.begin(), images.begin() + trainSize);
-    vector<int> trainLabels(labels.begin(), labels.begin() + trainSize);
-
-    vector<Mat> testImages(images.begin() + trainSize, images.end());
-    vector<int> testLabels(labels.begin() + trainSize, labels.end());
+    // Dividir en conjunto de entrenamiento y prueba (80% / 20% de los archivos de cada clase)
+    DatasetSplit split = splitRows(labels.size(), 0.8);  // 80% para entrenamiento
+    vector<int> trainLabels, testLabels;
+    for (int i : split.train) trainLabels.push_back(labels[i]);
+    for (int i : split.test) testLabels.push_back(labels[i]);
+    cout << "Entrenamiento: " << split.train.size() << " filas, prueba: " << split.test.size() << " filas" << endl;
+
+    // Caché persistente de descriptores HOG (solo se calculan las filas que no están)
+    const string cachePath = parser.get<string>("cache");
+    unique_ptr<HOGCache> cache;
+    HOGBatchExtractor probe;
+    const int descriptorSize = probe.descriptorSize();
+    size_t missing = 0;
+    if (!cachePath.empty()) {
+        cache = make_unique<HOGCache>(cachePath, HOG_PARAMS_SIGNATURE, descriptorSize);
+        for (uint64_t key : cacheKeys) {
+            missing += cache->find(key) == nullptr;
+        }
+        cout << "Caché HOG: " << cacheKeys.size() - missing << " descriptores reutilizados, " << missing
+             << " por calcular" << endl;
+    }
 
-    // Entrenamiento del modelo SVM con el conjunto de entrenamiento
-    trainSVM(trainImages, trainLabels);
+    // Proyección opcional de los descriptores, ajustada solo con el conjunto de entrenamiento
+    HOGProjection::Type projectionType = HOGProjection::parseType(parser.get<string>("proyeccion"));
+    const int pcaSamples = max(0, parser.get<int>("pca_muestras"));
+    if (parser.has("barrido") && projectionType != HOGProjection::Type::None) {
+        // El barrido es un diagnóstico: necesita los descriptores completos de ambos conjuntos
+        vector<int> dimsList;
+        stringstream list(parser.get<string>("barrido"));
+        for (string item; getline(list, item, ',');) {
+            if (!item.empty() && stoi(item) > 0) dimsList.push_back(stoi(item));
+        }
+        Mat trainData, testData;
+        extractRows(images, cacheKeys, split.train, cache.get(), trainData);
+        extractRows(images, cacheKeys, split.test, cache.get(), testData);
+        reportDimensionSweep(projectionType, dimsList, trainData, trainLabels, testData, testLabels, pcaSamples);
+    }
+    HOGProjection projection;
+    if (projectionType == HOGProjection::Type::PCA) {
+        // La PCA se ajusta solo con los descriptores de --pca_muestras filas de entrenamiento
+        Mat sample;
+        extractRows(images, cacheKeys, sampleRows(split.train, pcaSamples), cache.get(), sample);
+        projection = HOGProjection::fitPCA(sample, max(1, parser.get<int>("dims")));
+    } else if (projectionType == HOGProjection::Type::SparseRandom) {
+        projection = HOGProjection::sparseRandom(descriptorSize, max(1, parser.get<int>("dims")));
+    }
 
-    // Cargar el modelo SVM guardado
-    Ptr<SVM> svm = SVM::load("logos_svm.xml");
+    // Extraer los descriptores por bloques y guardar cada fila de entrenamiento ya proyectada:
+    // la matriz completa de descriptores nunca existe, solo la de entrenamiento (proyectada, si
+    // hay proyección) y un bloque. Si la caché cambia, se reescribe a la vez fila por fila, en
+    // cuyo caso también se recorren las filas de prueba. Mientras tanto, el escritor termina
+    // de volcar las imágenes.
+    const size_t blockSize = 256;
+    unique_ptr<HOGCache::Writer> cacheWriter;
+    if (cache && (missing > 0 || cache->size() != cacheKeys.size())) {
+        cacheWriter = cache->writer(cacheKeys);
+    }
+    vector<int> trainPosition(images.size(), -1);
+    for (size_t j = 0; j < split.train.size(); j++) trainPosition[split.train[j]] = static_cast<int>(j);
+    vector<int> firstPass = split.train;
+    if (cacheWriter) {
+        firstPass.resize(images.size());
+        iota(firstPass.begin(), firstPass.end(), 0);
+    }
 
-    // Predicción en el conjunto de prueba
-    int correct = 0;
-    for (size_t i = 0; i < testImages.size(); i++) {
-        vector<float> descriptors;
-        computeHOG(testImages[i], descriptors);
+    Mat svmTrainData(static_cast<int>(split.train.size()), projection.empty() ? descriptorSize : projection.outputSize(),
+                     CV_32F);
+    TickMeter hogTime;
+    size_t computed = 0;
+    hogTime.start();
+    for (size_t start = 0; start < firstPass.size(); start += blockSize) {
+        vector<int> blockRows(firstPass.begin() + start, firstPass.begin() + min(firstPass.size(), start + blockSize));
+        Mat block;
+        computed += extractRows(images, cacheKeys, blockRows, cache.get(), block);
+        for (size_t j = 0; j < blockRows.size(); j++) {
+            const float *descriptor = block.ptr<float>(static_cast<int>(j));
+            if (cacheWriter) {
+                cacheWriter->write(cacheKeys[blockRows[j]], descriptor);
+            }
+            const int position = trainPosition[blockRows[j]];
+            if (position < 0) {
+                continue;
+            }
+            if (projection.empty()) {
+                memcpy(svmTrainData.ptr<float>(position), descriptor, descriptorSize * sizeof(float));
+            } else {
+                projection.project(descriptor, svmTrainData.ptr<float>(position));
+            }
+        }
+    }
+    hogTime.stop();
+    HOGBatchExtractor::reportThroughput(computed, hogTime.getTimeSec());
+    if (cacheWriter && cacheWriter->commit()) {
+        // Se vuelve a abrir para leer las filas de prueba desde la caché nueva
+        cacheWriter.reset();
+        cache = make_unique<HOGCache>(cachePath, HOG_PARAMS_SIGNATURE, descriptorSize);
+    }
+    writer.close();
+    if (!projection.empty()) {
+        cout << "Proyección: " << descriptorSize << " -> " << projection.outputSize() << " dimensiones ("
+             << split.train.size() * descriptorSize * sizeof(float) / 1e6 << " MB -> "
+             << svmTrainData.total() * sizeof(float) / 1e6 << " MB de entrenamiento)" << endl;
+    }
 
-        // Predicción
-        string predictedLabel = predictSVM(svm, descriptors);
+    // Entrenamiento del modelo SVM con el conjunto de entrenamiento
+    trainSVM(svmTrainData, trainLabels, projection);
+    svmTrainData.release();
+
+    // Cargar el modelo SVM guardado (con la proyección plegada, si la hay: se evalúa sobre los
+    // descriptores completos)
+    LinearSVM svm;
+    if (!svm.load("logos_svm.xml")) {
+        return -1;
+    }
 
-        if (predictedLabel == to_string(testLabels[i])) {
-            correct++;
+    // Predicción en el conjunto de prueba, también por bloques
+    int correct = 0;
+    for (size_t start = 0; start < split.test.size(); start += blockSize) {
+        vector<int> blockRows(split.test.begin() + start, split.test.begin() + min(split.test.size(), start + blockSize));
+        Mat block;
+        extractRows(images, cacheKeys, blockRows, cache.get(), block);
+        for (size_t j = 0; j < blockRows.size(); j++) {
+            // Predicción
+            string predictedLabel = predictSVM(svm, block.row(static_cast<int>(j)));
+
+            if (predictedLabel == to_string(labels[blockRows[j]])) {
+                correct++;
+            }
         }
     }
 
     // Mostrar el porcentaje de aciertos
-    float accuracy = static_cast<float>(correct) / testImages.size() * 100.0;
+    float accuracy = static_cast<float>(correct) / split.test.size() * 100.0;
     cout << "Precisión del modelo en el conjunto de prueba: " << accuracy << "%" << endl;
 
+    TRAZA_VOLCAR(parser.get<string>("traza"));
     return 0;
 }
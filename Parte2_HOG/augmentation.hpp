@@ -0,0 +1,30 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+// Función para aumentar el dataset con más rotaciones y escalados
+inline void augmentImage(const cv::Mat &img, std::vector<cv::Mat> &augmentedImages, int classLabel) {
+    augmentedImages.push_back(img.clone());
+
+    // Rotaciones (-20° a 20°)
+    for (int angle = -20; angle <= 20; angle += 5) {
+        cv::Mat rotated;
+        cv::Point2f center(img.cols / 2.0, img.rows / 2.0);
+        cv::Mat rotationMatrix = cv::getRotationMatrix2D(center, angle, 1.0);
+        cv::warpAffine(img, rotated, rotationMatrix, img.size());
+        augmentedImages.push_back(rotated);
+    }
+
+    // Escalado (80%-120%)
+    for (double scale = 0.8; scale <= 1.2; scale += 0.2) {
+        cv::Mat scaled;
+        cv::resize(img, scaled, cv::Size(), scale, scale);
+        augmentedImages.push_back(scaled);
+    }
+
+    // Reflejo horizontal
+    cv::Mat flipped;
+    cv::flip(img, flipped, 1);
+    augmentedImages.push_back(flipped);
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+// Modos de volcado de las imágenes aumentadas
+enum class DumpMode {
+    None,       // No se guarda nada
+    Sync,       // imwrite en el mismo hilo que produce la imagen (comportamiento original)
+    Async,      // imwrite en un hilo escritor con cola acotada
+    Archive     // Un único archivo empaquetado sin compresión, escrito en segundo plano
+};
+
+// Función para interpretar el modo de volcado recibido por línea de comandos
+inline DumpMode parseDumpMode(const std::string &mode) {
+    if (mode == "none") return DumpMode::None;
+    if (mode == "sync") return DumpMode::Sync;
+    if (mode == "async") return DumpMode::Async;
+    if (mode == "archive") return DumpMode::Archive;
+    CV_Error(cv::Error::StsBadArg, "Modo de volcado desconocido: " + mode + " (none|sync|async|archive)");
+}
+
+// Escritor del dataset aumentado. En los modos Async y Archive las imágenes se encolan y un
+// hilo escritor las guarda; si la cola está llena, el productor espera (cola acotada), de modo
+// que la memoria usada por imágenes pendientes nunca supera 'capacity' elementos.
+//
+// Formato del modo Archive (<outputPath>.pack), un registro por imagen:
+//   uint32 longitud del nombre, nombre, int32 filas, int32 columnas, int32 tipo, píxeles
+class DatasetWriter {
+public:
+    DatasetWriter(DumpMode mode, const std::string &outputPath, size_t capacity = 256)
+        : mode(mode), outputPath(outputPath), capacity(capacity) {
+        if (mode == DumpMode::Sync || mode == DumpMode::Async) {
+            std::filesystem::create_directories(outputPath);
+        }
+        if (mode == DumpMode::Archive) {
+            archive.open(outputPath + ".pack", std::ios::binary | std::ios::trunc);
+            if (!archive.is_open()) {
+                CV_Error(cv::Error::StsError, "No se pudo crear " + outputPath + ".pack");
+            }
+        }
+        if (mode == DumpMode::Async || mode == DumpMode::Archive) {
+            worker = std::thread(&DatasetWriter::run, this);
+        }
+    }
+
+    ~DatasetWriter() { close(); }
+
+    DatasetWriter(const DatasetWriter &) = delete;
+    DatasetWriter &operator=(const DatasetWriter &) = delete;
+
+    // Guarda (o encola) una imagen con el nombre indicado. Se puede llamar desde varios hilos.
+    void write(const std::string &name, const cv::Mat &img) {
+        switch (mode) {
+        case DumpMode::None:
+            return;
+        case DumpMode::Sync:
+            store(name, img);
+            return;
+        default:
+            break;
+        }
+
+        std::unique_lock<std::mutex> lock(mtx);
+        notFull.wait(lock, [this] { return pending.size() < capacity; });
+        // cv::Mat comparte los datos por conteo de referencias: encolar no copia píxeles
+        pending.emplace_back(name, img);
+        notEmpty.notify_one();
+    }
+
+    // Espera a que se vacíe la cola y termina el hilo escritor
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (closing) return;
+            closing = true;
+        }
+        notEmpty.notify_all();
+        if (worker.joinable()) {
+            worker.join();
+        }
+        if (archive.is_open()) {
+            archive.close();
+        }
+        if (mode != DumpMode::None) {
+            std::cout << "Volcado del dataset aumentado: " << written << " imágenes" << std::endl;
+        }
+    }
+
+private:
+    // Bucle del hilo escritor
+    void run() {
+        for (;;) {
+            std::pair<std::string, cv::Mat> item;
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                notEmpty.wait(lock, [this] { return closing || !pending.empty(); });
+                if (pending.empty()) {
+                    return;
+                }
+                item = std::move(pending.front());
+                pending.pop_front();
+                notFull.notify_one();
+            }
+            store(item.first, item.second);
+        }
+    }
+
+    // Escribe una imagen según el modo. En Archive solo la llama el hilo escritor.
+    void store(const std::string &name, const cv::Mat &img) {
+        if (mode == DumpMode::Archive) {
+            cv::Mat data = img.isContinuous() ? img : img.clone();
+            uint32_t nameLength = static_cast<uint32_t>(name.size());
+            int32_t header[3] = {data.rows, data.cols, data.type()};
+            archive.write(reinterpret_cast<const char *>(&nameLength), sizeof(nameLength));
+            archive.write(name.data(), nameLength);
+            archive.write(reinterpret_cast<const char *>(header), sizeof(header));
+            archive.write(reinterpret_cast<const char *>(data.data), data.total() * data.elemSize());
+        } else {
+            cv::imwrite(outputPath + "/" + name + ".png", img);
+        }
+        written++;
+    }
+
+    DumpMode mode;
+    std::string outputPath;
+    size_t capacity;
+
+    std::mutex mtx;
+    std::condition_variable notFull, notEmpty;
+    std::deque<std::pair<std::string, cv::Mat>> pending;
+    bool closing = false;
+    std::thread worker;
+    std::ofstream archive;
+    std::atomic<size_t> written{0};
+};
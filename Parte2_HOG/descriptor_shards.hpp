@@ -0,0 +1,161 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "hog_cache.hpp"
+#include "hog_features.hpp"
+
+// Fragmentos de descriptores etiquetados en disco, para entrenar sin tener todo el conjunto en
+// memoria (streaming_svm.hpp). Cada fragmento es un archivo <prefijo>_NNNNN.shard:
+//   cabecera (DescriptorShardHeader), int32 etiquetas[count], float descriptores[count][dim]
+// Como la caché HOG, la cabecera guarda el hash de HOG_PARAMS_SIGNATURE y el archivo se escribe
+// en un temporal que luego se renombra.
+struct DescriptorShardHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t dim;
+    uint64_t paramsHash;
+    uint64_t count;
+};
+
+inline uint64_t descriptorParamsHash() {
+    return hashBytes(HOG_PARAMS_SIGNATURE, std::strlen(HOG_PARAMS_SIGNATURE));
+}
+
+// Fragmento cargado en memoria
+struct DescriptorShard {
+    std::string path;
+    int epoch = 0;                  // Época en la que se lee (la asigna el lector)
+    int index = 0;                  // Posición en la lista de fragmentos
+    int dim = 0;
+    std::vector<int32_t> labels;
+    std::vector<float> rows;        // labels.size() x dim
+
+    size_t size() const { return labels.size(); }
+    const float *row(size_t i) const { return rows.data() + i * dim; }
+
+    // Función para leer un fragmento completo. Con labelsOnly solo se leen las etiquetas.
+    bool read(const std::string &shardPath, bool labelsOnly = false) {
+        path = shardPath;
+        labels.clear();
+        rows.clear();
+        std::ifstream in(shardPath, std::ios::binary);
+        DescriptorShardHeader header;
+        if (!in.read(reinterpret_cast<char *>(&header), sizeof(header)) || std::memcmp(header.magic, "HOGSHARD", 8) != 0 ||
+            header.version != 1 || header.paramsHash != descriptorParamsHash()) {
+            std::cerr << "Fragmento " << shardPath << " ilegible o de otra configuración HOG: se omite" << std::endl;
+            return false;
+        }
+        // El tamaño del archivo debe coincidir con la cabecera: un fragmento truncado o dañado se
+        // omite antes de reservar memoria para su contenido
+        std::error_code error;
+        const uint64_t fileSize = std::filesystem::file_size(shardPath, error);
+        const uint64_t rowBytes = sizeof(int32_t) + static_cast<uint64_t>(header.dim) * sizeof(float);
+        if (error || header.dim == 0 || fileSize < sizeof(header) ||
+            header.count != (fileSize - sizeof(header)) / rowBytes || (fileSize - sizeof(header)) % rowBytes != 0) {
+            std::cerr << "Fragmento " << shardPath << " truncado o dañado: se omite" << std::endl;
+            return false;
+        }
+        dim = static_cast<int>(header.dim);
+        labels.resize(header.count);
+        if (!in.read(reinterpret_cast<char *>(labels.data()), labels.size() * sizeof(int32_t))) return false;
+        if (labelsOnly) return true;
+        rows.resize(header.count * header.dim);
+        return static_cast<bool>(in.read(reinterpret_cast<char *>(rows.data()), rows.size() * sizeof(float)));
+    }
+};
+
+// Función para listar los fragmentos de un prefijo, en orden
+inline std::vector<std::string> listShards(const std::string &prefix) {
+    namespace fs = std::filesystem;
+    fs::path base(prefix);
+    fs::path folder = base.has_parent_path() ? base.parent_path() : fs::path(".");
+    const std::string stem = base.filename().string() + "_";
+    std::vector<std::string> shards;
+    if (!fs::is_directory(folder)) return shards;
+    for (const auto &entry : fs::directory_iterator(folder)) {
+        const std::string name = entry.path().filename().string();
+        if (entry.is_regular_file() && name.size() == stem.size() + 11 && name.compare(0, stem.size(), stem) == 0 &&
+            entry.path().extension() == ".shard") {
+            shards.push_back(entry.path().string());
+        }
+    }
+    std::sort(shards.begin(), shards.end());
+    return shards;
+}
+
+// Escritor de fragmentos: acumula filas y escribe un fragmento cada 'rowsPerShard'. La memoria
+// usada es la de un fragmento, sin importar cuántas filas se escriban en total.
+class DescriptorShardWriter {
+public:
+    DescriptorShardWriter(const std::string &prefix, int dim, size_t rowsPerShard)
+        : prefix(prefix), dim(dim), rowsPerShard(std::max<size_t>(1, rowsPerShard)) {
+        namespace fs = std::filesystem;
+        fs::path base(prefix);
+        if (base.has_parent_path()) fs::create_directories(base.parent_path());
+        // Los fragmentos de una ejecución anterior con el mismo prefijo se reemplazan
+        for (const auto &old : listShards(prefix)) fs::remove(old);
+    }
+
+    ~DescriptorShardWriter() { close(); }
+
+    DescriptorShardWriter(const DescriptorShardWriter &) = delete;
+    DescriptorShardWriter &operator=(const DescriptorShardWriter &) = delete;
+
+    // Función para agregar una fila (dim floats) con su etiqueta
+    bool write(int label, const float *descriptor) {
+        labels.push_back(label);
+        rows.insert(rows.end(), descriptor, descriptor + dim);
+        return labels.size() < rowsPerShard || flush();
+    }
+
+    // Escribe el fragmento pendiente. Retorna false si no se pudo escribir.
+    bool close() { return labels.empty() || flush(); }
+
+    size_t shardCount() const { return shards; }
+    size_t rowCount() const { return total; }
+
+private:
+    bool flush() {
+        char suffix[16];
+        std::snprintf(suffix, sizeof(suffix), "_%05zu.shard", shards);
+        const std::string path = prefix + suffix;
+        const std::string tmpPath = path + ".tmp";
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        DescriptorShardHeader header = {};
+        std::memcpy(header.magic, "HOGSHARD", 8);
+        header.version = 1;
+        header.dim = static_cast<uint32_t>(dim);
+        header.paramsHash = descriptorParamsHash();
+        header.count = labels.size();
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char *>(labels.data()), labels.size() * sizeof(int32_t));
+        out.write(reinterpret_cast<const char *>(rows.data()), rows.size() * sizeof(float));
+        out.close();
+        if (!out || std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+            std::cerr << "No se pudo escribir el fragmento " << path << std::endl;
+            return false;
+        }
+        total += labels.size();
+        shards++;
+        labels.clear();
+        rows.clear();
+        return true;
+    }
+
+    std::string prefix;
+    int dim;
+    size_t rowsPerShard;
+    size_t shards = 0;
+    size_t total = 0;
+    std::vector<int32_t> labels;
+    std::vector<float> rows;
+};
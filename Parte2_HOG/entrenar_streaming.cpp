@@ -0,0 +1,192 @@
+// Entrenamiento del SVM de logos sin cargar el conjunto aumentado en memoria.
+//
+// 1. Con --write, las imágenes originales se decodifican, aumentan y pasan por HOG en bloques
+//    de --block archivos, y los descriptores se escriben en fragmentos de --shard_rows filas
+//    (descriptor_shards.hpp). Los archivos se barajan antes, así que cada fragmento mezcla las
+//    clases; una fracción --holdout de los originales va a los fragmentos <shards>_test.
+// 2. StreamingSVM (Pegasos uno-contra-resto) recorre los fragmentos durante --epochs épocas con
+//    lectura anticipada, y el modelo se guarda con el formato de cv::ml::SVM: Prediccion.cpp lo
+//    carga igual que el de Principal.cpp.
+//
+// La memoria depende de --block y de --shard_rows / --prefetch, no del tamaño del conjunto.
+
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "hog_features.hpp"
+#include "augmentation.hpp"
+#include "descriptor_shards.hpp"
+#include "hog_projection.hpp"
+#include "linear_svm.hpp"
+#include "streaming_svm.hpp"
+#include "../comun/traza.hpp"
+
+using namespace cv;
+using namespace std;
+namespace fs = std::filesystem;
+
+// Imagen original y su clase
+struct SourceFile {
+    string path;
+    int label;
+};
+
+// Función para listar las imágenes de cada clase (una subcarpeta por clase, como en Principal.cpp)
+vector<SourceFile> listSources(const string &folder) {
+    const vector<pair<string, int>> classes = {
+        {"batman", 1}, {"chrome", 2}, {"ebay", 3}, {"facebook", 4}, {"instagram", 5}
+    };
+    vector<SourceFile> files;
+    for (const auto &[name, label] : classes) {
+        const fs::path classFolder = fs::path(folder) / name;
+        if (!fs::is_directory(classFolder)) continue;
+        vector<string> paths;
+        for (const auto &entry : fs::directory_iterator(classFolder)) {
+            if (entry.is_regular_file()) paths.push_back(entry.path().string());
+        }
+        sort(paths.begin(), paths.end());
+        for (const auto &path : paths) files.push_back({path, label});
+    }
+    return files;
+}
+
+// Función para escribir los fragmentos de entrenamiento y de prueba. Solo hay en memoria los
+// descriptores de un bloque de archivos y un fragmento pendiente por escritor.
+void writeShards(const string &imagesFolder, const string &prefix, size_t shardRows, int block, double holdout,
+                 uint64_t seed) {
+    vector<SourceFile> files = listSources(imagesFolder);
+    mt19937_64 rng(seed);
+    shuffle(files.begin(), files.end(), rng);
+    const size_t testFiles = static_cast<size_t>(files.size() * min(max(holdout, 0.0), 1.0));
+
+    HOGBatchExtractor probe;
+    DescriptorShardWriter trainWriter(prefix, probe.descriptorSize(), shardRows);
+    DescriptorShardWriter testWriter(prefix + "_test", probe.descriptorSize(), shardRows);
+
+    TickMeter tm;
+    tm.start();
+    vector<Mat> slots;
+    for (size_t start = 0; start < files.size(); start += block) {
+        const size_t end = min(files.size(), start + static_cast<size_t>(block));
+        slots.assign(end - start, Mat());
+        parallel_for_(Range(static_cast<int>(start), static_cast<int>(end)), [&](const Range &range) {
+            HOGBatchExtractor extractor;
+            vector<Mat> augmented;
+            for (int i = range.start; i < range.end; i++) {
+                Mat img;
+                {
+                    TRAZA_AMBITO("decodificar");
+                    img = imread(files[i].path, IMREAD_GRAYSCALE);
+                }
+                if (img.empty()) continue;
+                augmented.clear();
+                {
+                    TRAZA_AMBITO("aumentar");
+                    augmentImage(img, augmented, files[i].label);
+                }
+                Mat &rows = slots[i - start];
+                rows.create(static_cast<int>(augmented.size()), extractor.descriptorSize(), CV_32F);
+                for (size_t v = 0; v < augmented.size(); v++) {
+                    extractor.computeRow(augmented[v], rows.row(static_cast<int>(v)));
+                }
+            }
+        });
+
+        for (size_t i = start; i < end; i++) {
+            DescriptorShardWriter &writer = i < testFiles ? testWriter : trainWriter;
+            const Mat &rows = slots[i - start];
+            for (int r = 0; r < rows.rows; r++) {
+                writer.write(files[i].label, rows.ptr<float>(r));
+            }
+        }
+    }
+    trainWriter.close();
+    testWriter.close();
+    tm.stop();
+
+    const double seconds = tm.getTimeSec();
+    cout << "Fragmentos: " << trainWriter.rowCount() << " filas de entrenamiento en " << trainWriter.shardCount()
+         << " fragmentos, " << testWriter.rowCount() << " de prueba en " << testWriter.shardCount() << " ("
+         << files.size() << " originales en " << seconds << " s, "
+         << (seconds > 0 ? files.size() / seconds : 0.0) << " imágenes/s)" << endl;
+}
+
+int main(int argc, char **argv) {
+    const string keys =
+        "{help h     |                  | Muestra esta ayuda }"
+        "{write      |                  | Genera los fragmentos desde las imágenes antes de entrenar }"
+        "{images     | images           | Carpeta con una subcarpeta por clase }"
+        "{shards     | descriptores/hog | Prefijo de los fragmentos (<shards>_NNNNN.shard y <shards>_test_NNNNN.shard) }"
+        "{shard_rows | 512              | Filas por fragmento (cada fila ocupa 4 bytes por dimensión HOG) }"
+        "{block      | 16               | Imágenes originales procesadas a la vez al generar los fragmentos }"
+        "{holdout    | 0.2              | Fracción de imágenes originales reservada para prueba }"
+        "{epochs     | 5                | Épocas sobre los fragmentos de entrenamiento }"
+        "{lambda     | 1e-4             | Regularización de Pegasos }"
+        "{seed       | 1                | Semilla del barajado de archivos, fragmentos y filas }"
+        "{prefetch   | 2                | Fragmentos leídos por adelantado }"
+        "{last       |                  | Usa los últimos pesos en lugar del promedio }"
+        "{model      | logos_svm.xml    | Modelo de salida (formato de cv::ml::SVM) }"
+        "{traza      | traza.json       | Archivo de trazas por etapa (solo si se compila con TRAZA=1) }";
+    CommandLineParser parser(argc, argv, keys);
+    if (parser.has("help")) {
+        parser.printMessage();
+        return 0;
+    }
+
+    const string prefix = parser.get<string>("shards");
+    const uint64_t seed = static_cast<uint64_t>(parser.get<int>("seed"));
+    if (parser.has("write")) {
+        writeShards(parser.get<string>("images"), prefix, static_cast<size_t>(max(1, parser.get<int>("shard_rows"))),
+                    max(1, parser.get<int>("block")), parser.get<double>("holdout"), seed);
+    }
+
+    StreamingSVM::Params params;
+    params.lambda = parser.get<double>("lambda");
+    params.epochs = max(1, parser.get<int>("epochs"));
+    params.seed = seed;
+    params.prefetch = static_cast<size_t>(max(1, parser.get<int>("prefetch")));
+    params.average = !parser.has("last");
+
+    StreamingSVM svm;
+    if (!svm.train(listShards(prefix), params)) {
+        cerr << "No hay fragmentos de entrenamiento en " << prefix << " (usa --write para generarlos)" << endl;
+        return -1;
+    }
+
+    const string modelPath = parser.get<string>("model");
+    if (!svm.save(modelPath)) {
+        return -1;
+    }
+    // El modelo se entrenó sobre el descriptor completo: una proyección anterior ya no aplica
+    fs::remove(HOGProjection::pathFor(modelPath));
+    cout << "Modelo guardado en '" << modelPath << "'." << endl;
+
+    // Precisión en los fragmentos de prueba, con el modelo tal como lo carga Prediccion.cpp
+    const vector<string> testShards = listShards(prefix + "_test");
+    if (!testShards.empty()) {
+        LinearSVM loaded;
+        if (!loaded.load(modelPath)) {
+            return -1;
+        }
+        size_t rows = 0, correct = 0, agree = 0;
+        DescriptorShard shard;
+        for (const auto &path : testShards) {
+            if (!shard.read(path) || shard.dim != loaded.varCount()) continue;
+            for (size_t i = 0; i < shard.size(); i++) {
+                const int label = loaded.predict(shard.row(i)).label;
+                correct += label == shard.labels[i];
+                agree += label == svm.predict(shard.row(i));
+            }
+            rows += shard.size();
+        }
+        cout << "Precisión del modelo en los fragmentos de prueba: " << (rows > 0 ? 100.0 * correct / rows : 0.0)
+             << "% (" << rows << " muestras; LinearSVM coincide con StreamingSVM en " << agree << ")" << endl;
+    }
+
+    TRAZA_VOLCAR(parser.get<string>("traza"));
+    return 0;
+}
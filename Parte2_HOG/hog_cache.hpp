@@ -0,0 +1,224 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Función para calcular un hash FNV-1a de 64 bits sobre un bloque de bytes
+inline uint64_t hashBytes(const void *data, size_t size, uint64_t seed = 1469598103934665603ULL) {
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    uint64_t hash = seed;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Función para calcular el hash del contenido de una imagen (dimensiones, tipo y píxeles)
+inline uint64_t hashImage(const cv::Mat &img) {
+    int32_t header[3] = {img.rows, img.cols, img.type()};
+    uint64_t hash = hashBytes(header, sizeof(header));
+    size_t rowBytes = img.cols * img.elemSize();
+    for (int y = 0; y < img.rows; y++) {
+        hash = hashBytes(img.ptr(y), rowBytes, hash);
+    }
+    return hash;
+}
+
+// Caché persistente de descriptores HOG.
+//
+// El archivo se proyecta en memoria con mmap y no se copia al abrirlo. Formato:
+//   cabecera (HOGCacheHeader), uint64 claves[count], float descriptores[count][dim]
+// La clave de cada fila es hashImage de la imagen aumentada que se describe: si cambian los
+// parámetros de la aumentación, las variantes afectadas tienen otra clave y se recalculan.
+// La cabecera guarda el hash de HOG_PARAMS_SIGNATURE: si la configuración HOG o el
+// preprocesamiento cambian, la caché completa se descarta.
+class HOGCache {
+public:
+    struct HOGCacheHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t dim;
+        uint64_t paramsHash;
+        uint64_t count;
+    };
+
+    HOGCache(const std::string &path, const std::string &paramsSignature, int dim)
+        : path(path), paramsHash(hashBytes(paramsSignature.data(), paramsSignature.size())), dim(dim) {
+        open();
+    }
+
+    ~HOGCache() { unmap(); }
+
+    HOGCache(const HOGCache &) = delete;
+    HOGCache &operator=(const HOGCache &) = delete;
+
+    size_t size() const { return index.size(); }
+
+    // Devuelve el descriptor guardado para la clave, o nullptr si no está en la caché
+    const float *find(uint64_t key) const {
+        auto it = index.find(key);
+        return it == index.end() ? nullptr : rows + it->second * dim;
+    }
+
+    // Escritor incremental de la caché: las claves se conocen de antemano y las filas se agregan
+    // a medida que se calculan, sin tener todos los descriptores en memoria. Las filas deben
+    // llegar en el orden de la primera aparición de cada clave; las repetidas se ignoran. Todo
+    // se escribe en un archivo temporal que commit() renombra, de modo que una ejecución
+    // interrumpida nunca deja una caché a medio escribir.
+    class Writer {
+    public:
+        Writer(const std::string &path, uint64_t paramsHash, int dim, const std::vector<uint64_t> &keys)
+            : path(path), tmpPath(path + ".tmp"), dim(dim) {
+            // Se conserva solo la primera aparición de cada clave
+            for (uint64_t key : keys) {
+                if (position.emplace(key, order.size()).second) {
+                    order.push_back(key);
+                }
+            }
+
+            out.open(tmpPath, std::ios::binary | std::ios::trunc);
+            if (!out.is_open()) {
+                std::cerr << "No se pudo escribir la caché HOG " << tmpPath << std::endl;
+                return;
+            }
+            HOGCacheHeader header = {};
+            std::memcpy(header.magic, "HOGCACHE", 8);
+            header.version = 1;
+            header.dim = static_cast<uint32_t>(dim);
+            header.paramsHash = paramsHash;
+            header.count = order.size();
+            out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char *>(order.data()), order.size() * sizeof(uint64_t));
+        }
+
+        ~Writer() {
+            if (out.is_open()) {
+                out.close();
+                std::remove(tmpPath.c_str());
+            }
+        }
+
+        Writer(const Writer &) = delete;
+        Writer &operator=(const Writer &) = delete;
+
+        // Agrega la fila de una clave. Retorna false si la clave no es la siguiente esperada.
+        bool write(uint64_t key, const float *row) {
+            auto it = position.find(key);
+            if (it == position.end() || it->second > next) {
+                return false;
+            }
+            if (it->second < next) {
+                return true;  // Repetida: ya se escribió
+            }
+            out.write(reinterpret_cast<const char *>(row), dim * sizeof(float));
+            next++;
+            return true;
+        }
+
+        // Cierra el temporal y reemplaza la caché. Falla si faltan filas.
+        bool commit() {
+            if (!out.is_open()) {
+                return false;
+            }
+            out.close();
+            if (!out || next != order.size()) {
+                std::cerr << "Error al escribir la caché HOG " << tmpPath << std::endl;
+                std::remove(tmpPath.c_str());
+                return false;
+            }
+            return std::rename(tmpPath.c_str(), path.c_str()) == 0;
+        }
+
+    private:
+        std::string path, tmpPath;
+        int dim;
+        std::vector<uint64_t> order;
+        std::unordered_map<uint64_t, size_t> position;
+        size_t next = 0;
+        std::ofstream out;
+    };
+
+    // Función para crear un escritor que reemplazará esta caché con las claves indicadas
+    std::unique_ptr<Writer> writer(const std::vector<uint64_t> &keys) const {
+        return std::make_unique<Writer>(path, paramsHash, dim, keys);
+    }
+
+    // Reescribe la caché con las claves y filas indicadas (una fila de 'data' por clave)
+    bool save(const std::vector<uint64_t> &keys, const cv::Mat &data) const {
+        CV_Assert(data.type() == CV_32F && data.cols == dim && data.rows == static_cast<int>(keys.size()));
+        std::unique_ptr<Writer> out = writer(keys);
+        for (size_t i = 0; i < keys.size(); i++) {
+            out->write(keys[i], data.ptr<float>(static_cast<int>(i)));
+        }
+        return out->commit();
+    }
+
+private:
+    void open() {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;  // Aún no existe: primera ejecución
+        }
+        struct stat st;
+        if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(HOGCacheHeader)) {
+            void *ptr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (ptr != MAP_FAILED) {
+                mapped = ptr;
+                mappedSize = st.st_size;
+            }
+        }
+        ::close(fd);
+        if (!mapped) {
+            return;
+        }
+
+        const HOGCacheHeader *header = static_cast<const HOGCacheHeader *>(mapped);
+        size_t expected = sizeof(HOGCacheHeader) + header->count * (sizeof(uint64_t) + dim * sizeof(float));
+        if (std::memcmp(header->magic, "HOGCACHE", 8) != 0 || header->version != 1 ||
+            header->dim != static_cast<uint32_t>(dim) || header->paramsHash != paramsHash ||
+            mappedSize != expected) {
+            std::cout << "Caché HOG " << path << " incompatible con la configuración actual: se descarta" << std::endl;
+            unmap();
+            return;
+        }
+
+        const uint64_t *keys = reinterpret_cast<const uint64_t *>(header + 1);
+        rows = reinterpret_cast<const float *>(keys + header->count);
+        index.reserve(header->count);
+        for (uint64_t i = 0; i < header->count; i++) {
+            index.emplace(keys[i], i);
+        }
+    }
+
+    void unmap() {
+        if (mapped) {
+            munmap(mapped, mappedSize);
+            mapped = nullptr;
+            mappedSize = 0;
+        }
+        rows = nullptr;
+        index.clear();
+    }
+
+    std::string path;
+    uint64_t paramsHash;
+    int dim;
+
+    void *mapped = nullptr;
+    size_t mappedSize = 0;
+    const float *rows = nullptr;
+    std::unordered_map<uint64_t, size_t> index;
+};
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <vector>
+#include "../comun/traza.hpp"
+#include "hog_fixed.hpp"
+
+// Firma de la configuración HOG y del preprocesamiento. Si se cambia cualquiera de los
+// parámetros de createHOG, preprocessHOG o la normalización, hay que actualizarla para que
+// la caché de descriptores deje de reutilizar resultados calculados con la configuración anterior.
+constexpr const char *HOG_PARAMS_SIGNATURE =
+    "win=128x128;block=16x16;stride=4x4;cell=8x8;bins=18;"
+    "resize=128x128;blur=3x3;adaptive=gauss,11,2;equalize;minmax=0,1;impl=fixed";
+
+// Función para crear el descriptor HOG con la configuración usada en entrenamiento y predicción.
+// computeHOG y HOGBatchExtractor usan la versión especializada LogoHOG (hog_fixed.hpp), que
+// calcula lo mismo para imágenes de 128x128; este descriptor genérico queda para el detector
+// de ventana deslizante y para validar LogoHOG.
+inline cv::HOGDescriptor createHOG() {
+    return cv::HOGDescriptor(
+        cv::Size(128, 128),
+        cv::Size(16, 16),
+        cv::Size(4, 4),
+        cv::Size(8, 8),
+        18
+    );
+}
+
+// Función para aplicar el preprocesamiento previo al cálculo del descriptor HOG
+inline void preprocessHOG(const cv::Mat &img, cv::Mat &dst) {
+    {
+        TRAZA_AMBITO("redimensionar");
+        cv::resize(img, dst, cv::Size(128, 128));
+    }
+    {
+        TRAZA_AMBITO("desenfoque");
+        cv::GaussianBlur(dst, dst, cv::Size(3, 3), 0);
+    }
+    {
+        TRAZA_AMBITO("umbral");
+        cv::adaptiveThreshold(dst, dst, 255, cv::ADAPTIVE_THRESH_GAUSSIAN_C, cv::THRESH_BINARY, 11, 2);
+    }
+    {
+        TRAZA_AMBITO("ecualizar");
+        cv::equalizeHist(dst, dst);
+    }
+}
+
+// Función para calcular el descriptor HOG con normalización
+inline void computeHOG(cv::Mat img, std::vector<float> &descriptors) {
+    // Un extractor por hilo: sus buffers de gradiente se reutilizan entre llamadas
+    thread_local LogoHOG hog;
+
+    preprocessHOG(img, img);
+
+    // Descriptor HOG y normalización min-max a [0, 1] en una sola pasada
+    TRAZA_AMBITO("hog");
+    hog.compute(img, descriptors);
+}
+
+// Función para calcular el descriptor con cv::HOGDescriptor (implementación de referencia)
+inline void computeHOGOpenCV(cv::Mat img, std::vector<float> &descriptors) {
+    cv::HOGDescriptor hog = createHOG();
+
+    preprocessHOG(img, img);
+
+    std::vector<cv::Point> locations;
+    hog.compute(img, descriptors, cv::Size(8, 8), cv::Size(0, 0), locations);
+
+    // Normalizar las características HOG
+    cv::normalize(descriptors, descriptors, 0, 1, cv::NORM_MINMAX);
+}
+
+// Extractor HOG por lotes: reutiliza un único descriptor configurado y sus buffers,
+// y escribe cada descriptor normalizado directamente en una fila de una matriz CV_32F.
+class HOGBatchExtractor {
+public:
+    int descriptorSize() const { return LogoHOG::descriptorSize; }
+
+    // Calcula el descriptor de una imagen y lo escribe en 'row' (1 x descriptorSize, CV_32F)
+    void computeRow(const cv::Mat &img, cv::Mat row) {
+        CV_Assert(row.rows == 1 && row.cols == descriptorSize() && row.type() == CV_32F);
+
+        preprocessHOG(img, work);
+
+        // El descriptor normalizado se escribe directamente sobre la fila destino
+        TRAZA_AMBITO("hog");
+        hog.compute(work, row.ptr<float>());
+    }
+
+    // Calcula los descriptores de todas las imágenes sobre las filas preasignadas de 'data'
+    void computeBatch(const std::vector<cv::Mat> &images, cv::Mat &data) {
+        data.create(static_cast<int>(images.size()), descriptorSize(), CV_32F);
+
+        cv::TickMeter tm;
+        tm.start();
+        for (size_t i = 0; i < images.size(); i++) {
+            computeRow(images[i], data.row(static_cast<int>(i)));
+        }
+        tm.stop();
+
+        reportThroughput(images.size(), tm.getTimeSec());
+    }
+
+    // Igual que computeBatch, pero reparte las filas entre todos los núcleos. Cada bloque de
+    // filas usa su propio extractor y escribe en filas disjuntas, por lo que el resultado es
+    // idéntico al de la versión secuencial.
+    static void computeBatchParallel(const std::vector<cv::Mat> &images, cv::Mat &data) {
+        std::vector<int> rows(images.size());
+        for (size_t i = 0; i < rows.size(); i++) {
+            rows[i] = static_cast<int>(i);
+        }
+        HOGBatchExtractor probe;
+        data.create(static_cast<int>(images.size()), probe.descriptorSize(), CV_32F);
+        computeRowsParallel(images, data, rows);
+    }
+
+    // Calcula en paralelo solo las filas indicadas de 'data' (ya reservada)
+    static void computeRowsParallel(const std::vector<cv::Mat> &images, cv::Mat &data, const std::vector<int> &rows) {
+        cv::TickMeter tm;
+        tm.start();
+        cv::parallel_for_(cv::Range(0, static_cast<int>(rows.size())), [&](const cv::Range &range) {
+            HOGBatchExtractor extractor;
+            for (int i = range.start; i < range.end; i++) {
+                extractor.computeRow(images[rows[i]], data.row(rows[i]));
+            }
+        }, cv::getNumThreads() * 4.0);
+        tm.stop();
+
+        reportThroughput(rows.size(), tm.getTimeSec());
+    }
+
+    // Muestra el rendimiento de la extracción en imágenes por segundo
+    static void reportThroughput(size_t count, double seconds) {
+        double rate = seconds > 0 ? count / seconds : 0.0;
+        std::cout << "HOG: " << count << " imágenes en " << seconds << " s ("
+                  << rate << " imágenes/s)" << std::endl;
+    }
+
+private:
+    LogoHOG hog;
+    cv::Mat work;                      // Imagen preprocesada reutilizada entre llamadas
+};
@@ -0,0 +1,233 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <vector>
+#include "../comun/traza.hpp"
+
+// Descriptor HOG con la configuración fija como constantes de compilación.
+//
+// Calcula lo mismo que cv::HOGDescriptor (gradiente unsigned, derivAperture 1, winSigma por
+// defecto, L2Hys con umbral 0.2, sin corrección gamma) para una ventana que cubre toda la imagen:
+//   - Gradiente con bordes BORDER_REFLECT_101 y ángulo/magnitud con cv::cartToPolar (SIMD),
+//     calculados una vez por imagen. Cada píxel reparte su magnitud entre los dos bins vecinos.
+//   - El peso de un píxel en una celda de un bloque es gauss(i) * gauss(j) * bilineal(i) *
+//     bilineal(j), separable por ejes. Por eso primero se calculan, por cada fila de la imagen y
+//     cada columna de bloques, los histogramas parciales de la fila ponderados en x; cada uno lo
+//     comparten los Block / Stride bloques que se solapan en vertical. Después cada bloque se
+//     arma sumando esas filas ponderadas en y, un bucle denso que el compilador vectoriza.
+//   - Normalización L2Hys por bloque y, al final, min-max a [0, 1] fusionada con la escritura
+//     del descriptor (el mínimo y el máximo se acumulan mientras se normalizan los bloques).
+//
+// Las sumas se hacen en otro orden que en OpenCV y el peso gaussiano se separa en dos factores,
+// así que el resultado no es idéntico bit a bit. Validado contra HOGDescriptor::compute +
+// normalize(NORM_MINMAX) sobre las imágenes de images/ y ruido aleatorio: diferencia máxima por
+// componente por debajo de 1e-5 (tolerancia comprobada en benchmarks/).
+template <int Win, int Block, int Stride, int Cell, int Bins>
+class FixedHOG {
+public:
+    static_assert(Block % Cell == 0 && (Win - Block) % Stride == 0, "Configuración HOG no válida");
+
+    static constexpr int cellsPerBlock = Block / Cell;
+    static constexpr int blocksPerSide = (Win - Block) / Stride + 1;
+    static constexpr int blockHistSize = cellsPerBlock * cellsPerBlock * Bins;
+    static constexpr int descriptorSize = blocksPerSide * blocksPerSide * blockHistSize;
+    static constexpr int rowHistSize = cellsPerBlock * Bins;
+
+    FixedHOG()
+        : grad(Win * Win * 2), qangle(Win * Win * 2), rows(Win * blocksPerSide * rowHistSize), dx(Win, Win, CV_32F), dy(Win, Win, CV_32F) {}
+
+    // Calcula el descriptor de una imagen Win x Win CV_8UC1 ya preprocesada y lo escribe en
+    // 'out' (descriptorSize floats). Con minMax = true se normaliza a [0, 1] como cv::normalize.
+    void compute(const cv::Mat &img, float *out, bool minMax = true) {
+        CV_Assert(img.type() == CV_8UC1 && img.rows == Win && img.cols == Win);
+        {
+            TRAZA_AMBITO("hog_gradiente");
+            computeGradient(img);
+        }
+
+        TRAZA_AMBITO("hog_bloques");
+        const AxisWeights &t = axisWeights();
+        accumulateRows(t);
+        float lo = FLT_MAX, hi = -FLT_MAX;
+        float hist[blockHistSize];
+        for (int bx = 0; bx < blocksPerSide; bx++) {
+            for (int by = 0; by < blocksPerSide; by++) {
+                accumulateBlock(t, bx, by, hist);
+
+                // Descriptor en orden x-mayor de bloques, igual que HOGCache
+                float *dst = out + (bx * blocksPerSide + by) * blockHistSize;
+                normalizeBlock(hist, dst, lo, hi);
+            }
+        }
+
+        if (minMax) {
+            // Mismos coeficientes que cv::normalize(NORM_MINMAX, 0, 1)
+            double range = static_cast<double>(hi) - lo;
+            double scale = range > DBL_EPSILON ? 1.0 / range : 0.0;
+            double shift = -lo * scale;
+            const float a = static_cast<float>(scale), b = static_cast<float>(shift);
+            for (int k = 0; k < descriptorSize; k++) {
+                out[k] = out[k] * a + b;
+            }
+        }
+    }
+
+    void compute(const cv::Mat &img, std::vector<float> &descriptors, bool minMax = true) {
+        descriptors.resize(descriptorSize);
+        compute(img, descriptors.data(), minMax);
+    }
+
+private:
+    // Peso de cada posición dentro del bloque (0..Block-1) para cada celda del eje: gaussiana
+    // del bloque (sigma = Block / 4) por interpolación lineal entre centros de celda
+    struct AxisWeights {
+        float w[cellsPerBlock][Block];
+    };
+
+    static const AxisWeights &axisWeights() {
+        static const AxisWeights t = buildAxisWeights();
+        return t;
+    }
+
+    static AxisWeights buildAxisWeights() {
+        const float sigma = static_cast<float>((Block + Block) / 8.0);
+        const float scale = 1.f / (sigma * sigma * 2);
+        AxisWeights t;
+        for (int k = 0; k < Block; k++) {
+            const float d = k - Block * 0.5f;
+            const float gauss = std::exp(-(d * d) * scale);
+            const float pos = (k + 0.5f) / Cell - 0.5f;
+            for (int c = 0; c < cellsPerBlock; c++) {
+                t.w[c][k] = gauss * std::max(0.f, 1.f - std::abs(pos - c));
+            }
+        }
+        return t;
+    }
+
+    // Gradiente de toda la imagen: diferencias centradas con reflejo 101 en los bordes,
+    // magnitud y ángulo con cv::cartToPolar y reparto entre los dos bins más cercanos
+    void computeGradient(const cv::Mat &img) {
+        for (int y = 0; y < Win; y++) {
+            const uchar *cur = img.ptr<uchar>(y);
+            const uchar *prev = img.ptr<uchar>(y > 0 ? y - 1 : 1);
+            const uchar *next = img.ptr<uchar>(y < Win - 1 ? y + 1 : Win - 2);
+            float *gx = dx.ptr<float>(y);
+            float *gy = dy.ptr<float>(y);
+            gx[0] = static_cast<float>(cur[1]) - cur[1];
+            for (int x = 1; x < Win - 1; x++) {
+                gx[x] = static_cast<float>(cur[x + 1]) - cur[x - 1];
+            }
+            gx[Win - 1] = static_cast<float>(cur[Win - 2]) - cur[Win - 2];
+            for (int x = 0; x < Win; x++) {
+                gy[x] = static_cast<float>(next[x]) - prev[x];
+            }
+        }
+
+        cv::cartToPolar(dx, dy, mag, angle, false);
+
+        const float angleScale = static_cast<float>(Bins / CV_PI);
+        const float *m = mag.ptr<float>();
+        const float *a = angle.ptr<float>();
+        for (int k = 0; k < Win * Win; k++) {
+            float ang = a[k] * angleScale - 0.5f;
+            int hidx = cvFloor(ang);
+            ang -= hidx;
+            grad[k * 2] = m[k] * (1.f - ang);
+            grad[k * 2 + 1] = m[k] * ang;
+            if (hidx < 0) hidx += Bins;
+            else if (hidx >= Bins) hidx -= Bins;
+            qangle[k * 2] = static_cast<uchar>(hidx);
+            hidx++;
+            qangle[k * 2 + 1] = static_cast<uchar>(hidx < Bins ? hidx : 0);
+        }
+    }
+
+    // Histogramas parciales de cada fila: rows[(y * blocksPerSide + bx) * rowHistSize + c * Bins + bin]
+    // acumula los píxeles de la fila y dentro del bloque de columna bx, ponderados en x
+    void accumulateRows(const AxisWeights &t) {
+        std::fill(rows.begin(), rows.end(), 0.f);
+        for (int y = 0; y < Win; y++) {
+            const float *g = grad.data() + y * Win * 2;
+            const uchar *q = qangle.data() + y * Win * 2;
+            float *r = rows.data() + y * blocksPerSide * rowHistSize;
+            for (int bx = 0; bx < blocksPerSide; bx++, r += rowHistSize) {
+                const int x0 = bx * Stride;
+                for (int k = 0; k < Block; k++) {
+                    const float a0 = g[(x0 + k) * 2], a1 = g[(x0 + k) * 2 + 1];
+                    // En las imágenes binarizadas la mayoría de los píxeles no tienen gradiente
+                    if (a0 == 0.f && a1 == 0.f) continue;
+                    const int h0 = q[(x0 + k) * 2], h1 = q[(x0 + k) * 2 + 1];
+                    // Solo las celdas a menos de un ancho de celda de la posición tienen peso
+                    const int c0 = std::max(0, (k - Cell / 2) / Cell);
+                    const int c1 = std::min(cellsPerBlock - 1, (k + Cell / 2) / Cell);
+                    for (int c = c0; c <= c1; c++) {
+                        const float w = t.w[c][k];
+                        r[c * Bins + h0] += a0 * w;
+                        r[c * Bins + h1] += a1 * w;
+                    }
+                }
+            }
+        }
+    }
+
+    // Histograma del bloque (bx, by) a partir de sus Block filas parciales, ponderadas en y.
+    // Se acumula por fila de celdas (cy) sobre los rowHistSize valores contiguos de cada fila
+    // parcial y al final se reordena a celdas x-mayor, como HOGCache.
+    void accumulateBlock(const AxisWeights &t, int bx, int by, float *hist) const {
+        float acc[cellsPerBlock][rowHistSize] = {};
+        for (int i = 0; i < Block; i++) {
+            const float *r = rows.data() + ((by * Stride + i) * blocksPerSide + bx) * rowHistSize;
+            for (int cy = 0; cy < cellsPerBlock; cy++) {
+                const float w = t.w[cy][i];
+                if (w == 0.f) continue;
+                for (int k = 0; k < rowHistSize; k++) {
+                    acc[cy][k] += w * r[k];
+                }
+            }
+        }
+        for (int cx = 0; cx < cellsPerBlock; cx++) {
+            for (int cy = 0; cy < cellsPerBlock; cy++) {
+                std::copy(acc[cy] + cx * Bins, acc[cy] + (cx + 1) * Bins, hist + (cx * cellsPerBlock + cy) * Bins);
+            }
+        }
+    }
+
+    // Suma de cuadrados en 4 acumuladores parciales, como normalizeBlockHistogram
+    static float sumSquares(const float *h) {
+        float part[4] = {0.f, 0.f, 0.f, 0.f};
+        for (int i = 0; i < blockHistSize; i += 4) {
+            for (int l = 0; l < 4; l++) {
+                part[l] += h[i + l] * h[i + l];
+            }
+        }
+        return (part[0] + part[1]) + (part[2] + part[3]);
+    }
+
+    // Normalización L2Hys del bloque, escrita en 'dst', acumulando el mínimo y el máximo
+    static void normalizeBlock(float *hist, float *dst, float &lo, float &hi) {
+        static_assert(blockHistSize % 4 == 0, "El histograma de bloque debe ser múltiplo de 4");
+        float scale = 1.f / (std::sqrt(sumSquares(hist)) + blockHistSize * 0.1f);
+        const float thresh = 0.2f;
+        for (int i = 0; i < blockHistSize; i++) {
+            hist[i] = std::min(hist[i] * scale, thresh);
+        }
+        scale = 1.f / (std::sqrt(sumSquares(hist)) + 1e-3f);
+        for (int i = 0; i < blockHistSize; i++) {
+            const float v = hist[i] * scale;
+            dst[i] = v;
+            lo = std::min(lo, v);
+            hi = std::max(hi, v);
+        }
+    }
+
+    std::vector<float> grad;        // Magnitud repartida entre los dos bins de cada píxel
+    std::vector<uchar> qangle;      // Los dos bins de cada píxel
+    std::vector<float> rows;        // Histogramas parciales por fila (ver accumulateRows)
+    cv::Mat dx, dy, mag, angle;     // Buffers del gradiente reutilizados entre imágenes
+};
+
+// Configuración usada en entrenamiento y predicción (ver createHOG)
+using LogoHOG = FixedHOG<128, 16, 4, 8, 18>;
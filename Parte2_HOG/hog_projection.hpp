@@ -0,0 +1,291 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "hog_cache.hpp"
+#include "hog_features.hpp"
+
+// Proyección lineal de los descriptores HOG (LogoHOG::descriptorSize floats) a pocas dimensiones
+// antes del SVM:
+//   PCA           x' = P (x - media), con P las primeras componentes principales del entrenamiento
+//   SparseRandom  x' = R x, proyección aleatoria muy dispersa (Li, Hastie y Church): cada entrada
+//                 de R vale ±sqrt(s / k) con probabilidad 1 / s y 0 en otro caso, con s = sqrt(D)
+//
+// Como la proyección es lineal, un SVM lineal entrenado sobre x' se puede plegar de vuelta en
+// pesos sobre el descriptor completo (unproject): w · x' = (Pᵀ w) · x - (Pᵀ w) · media. Así la
+// predicción no paga la proyección, y el detector de ventana deslizante sigue funcionando igual.
+//
+// Formato del archivo (<modelo>.proj, junto al XML del SVM):
+//   cabecera (HOGProjectionHeader)
+//   PCA:          float media[D], float base[k][D]
+//   SparseRandom: int32 inicioFila[k + 1], int32 columnas[nnz], float valores[nnz]
+// La cabecera guarda el hash de HOG_PARAMS_SIGNATURE, igual que la caché de descriptores.
+class HOGProjection {
+public:
+    enum class Type : int32_t { None = 0, PCA = 1, SparseRandom = 2 };
+
+    struct HOGProjectionHeader {
+        char magic[8];
+        int32_t type;
+        int32_t inputDim;
+        int32_t outputDim;
+        int32_t nonZeros;
+        uint64_t paramsHash;
+    };
+
+    // Función para interpretar el tipo recibido por línea de comandos
+    static Type parseType(const std::string &name) {
+        if (name == "none") return Type::None;
+        if (name == "pca") return Type::PCA;
+        if (name == "random") return Type::SparseRandom;
+        CV_Error(cv::Error::StsBadArg, "Proyección desconocida: " + name + " (none|pca|random)");
+    }
+
+    // Ruta de la proyección que acompaña a un modelo: logos_svm.xml -> logos_svm.proj
+    static std::string pathFor(const std::string &modelPath) {
+        size_t dot = modelPath.find_last_of('.');
+        size_t slash = modelPath.find_last_of("/\\");
+        if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) return modelPath + ".proj";
+        return modelPath.substr(0, dot) + ".proj";
+    }
+
+    // Función para ajustar una PCA de 'dims' componentes sobre las filas de 'data' (CV_32F). Con
+    // maxSamples > 0 se usan como mucho ese número de filas, tomadas a intervalos regulares.
+    static HOGProjection fitPCA(const cv::Mat &data, int dims, int maxSamples = 0) {
+        CV_Assert(data.type() == CV_32F && data.rows > 1);
+        cv::Mat samples = data;
+        if (maxSamples > 0 && data.rows > maxSamples) {
+            samples.create(maxSamples, data.cols, CV_32F);
+            for (int i = 0; i < maxSamples; i++) {
+                cv::Mat row = samples.row(i);
+                data.row(static_cast<int>(static_cast<int64_t>(i) * data.rows / maxSamples)).copyTo(row);
+            }
+        }
+
+        // Con menos filas que columnas OpenCV diagonaliza la matriz de Gram (filas x filas), no
+        // la covarianza D x D
+        TRAZA_AMBITO("pca_ajustar");
+        cv::PCA pca(samples, cv::noArray(), cv::PCA::DATA_AS_ROW, std::min(dims, samples.rows));
+
+        HOGProjection p;
+        p.type = Type::PCA;
+        p.inputDim = data.cols;
+        p.outputDim = pca.eigenvectors.rows;
+        pca.mean.convertTo(p.mean, CV_32F);
+        pca.eigenvectors.convertTo(p.basis, CV_32F);
+        return p;
+    }
+
+    // Función para generar una proyección aleatoria dispersa de inputDim a dims dimensiones
+    static HOGProjection sparseRandom(int inputDim, int dims, uint64_t seed = 12345) {
+        CV_Assert(inputDim > 0 && dims > 0);
+        HOGProjection p;
+        p.type = Type::SparseRandom;
+        p.inputDim = inputDim;
+        p.outputDim = dims;
+
+        // Las posiciones no nulas de cada fila se sortean por saltos geométricos: el costo es
+        // proporcional a las entradas no nulas (unas D / s por fila), no a D
+        const double s = std::sqrt(static_cast<double>(inputDim));
+        const float scale = static_cast<float>(std::sqrt(s / dims));
+        std::mt19937_64 rng(seed);
+        std::geometric_distribution<int> skip(1.0 / s);
+        std::bernoulli_distribution sign(0.5);
+        p.rowStart.assign(1, 0);
+        for (int j = 0; j < dims; j++) {
+            for (int64_t d = skip(rng); d < inputDim; d += 1 + static_cast<int64_t>(skip(rng))) {
+                p.cols.push_back(static_cast<int32_t>(d));
+                p.values.push_back(sign(rng) ? scale : -scale);
+            }
+            p.rowStart.push_back(static_cast<int32_t>(p.cols.size()));
+        }
+        return p;
+    }
+
+    bool empty() const { return type == Type::None; }
+    Type kind() const { return type; }
+    int inputSize() const { return inputDim; }
+    int outputSize() const { return outputDim; }
+
+    // Bytes de los parámetros en memoria
+    size_t parameterBytes() const {
+        return (mean.total() + basis.total() + values.size()) * sizeof(float) +
+               (rowStart.size() + cols.size()) * sizeof(int32_t);
+    }
+
+    // Función para proyectar una muestra (inputDim floats) sobre 'dst' (outputDim floats)
+    void project(const float *x, float *dst) const {
+        if (type == Type::PCA) {
+            const float *m = mean.ptr<float>();
+            for (int j = 0; j < outputDim; j++) {
+                const float *b = basis.ptr<float>(j);
+                double sum = 0.0;
+                for (int d = 0; d < inputDim; d++) sum += b[d] * (x[d] - m[d]);
+                dst[j] = static_cast<float>(sum);
+            }
+            return;
+        }
+        for (int j = 0; j < outputDim; j++) {
+            double sum = 0.0;
+            for (int32_t e = rowStart[j]; e < rowStart[j + 1]; e++) sum += values[e] * x[cols[e]];
+            dst[j] = static_cast<float>(sum);
+        }
+    }
+
+    // Función para proyectar todas las filas de 'src' (N x inputDim, CV_32F) en paralelo
+    void project(const cv::Mat &src, cv::Mat &dst) const {
+        CV_Assert(!empty() && src.type() == CV_32F && src.cols == inputDim);
+        dst.create(src.rows, outputDim, CV_32F);
+        TRAZA_AMBITO("proyectar");
+        if (type == Type::PCA) {
+            // Un producto de matrices por bloque de filas ya centradas. Restar P · media después
+            // del producto saldría más barato, pero en float se cancelan casi todas las cifras.
+            cv::Mat centered;
+            for (int start = 0; start < src.rows; start += pcaBlock) {
+                const int end = std::min(src.rows, start + pcaBlock);
+                centered.create(end - start, inputDim, CV_32F);
+                for (int i = start; i < end; i++) {
+                    cv::Mat row = centered.row(i - start);
+                    cv::subtract(src.row(i), mean, row);
+                }
+                cv::Mat out = dst.rowRange(start, end);
+                cv::gemm(centered, basis, 1.0, cv::noArray(), 0.0, out, cv::GEMM_2_T);
+            }
+            return;
+        }
+        cv::parallel_for_(cv::Range(0, src.rows), [&](const cv::Range &range) {
+            for (int i = range.start; i < range.end; i++) {
+                project(src.ptr<float>(i), dst.ptr<float>(i));
+            }
+        });
+    }
+
+    // Función para plegar unos pesos lineales sobre la proyección (outputDim floats) en pesos
+    // sobre el descriptor completo: full = Pᵀ w. 'offset' recibe (Pᵀ w) · media, que se resta
+    // del producto (0 en la proyección aleatoria).
+    void unproject(const float *w, float *full, double &offset) const {
+        std::vector<double> acc(inputDim, 0.0);
+        if (type == Type::PCA) {
+            for (int j = 0; j < outputDim; j++) {
+                const float *b = basis.ptr<float>(j);
+                for (int d = 0; d < inputDim; d++) acc[d] += static_cast<double>(w[j]) * b[d];
+            }
+        } else {
+            for (int j = 0; j < outputDim; j++) {
+                for (int32_t e = rowStart[j]; e < rowStart[j + 1]; e++) acc[cols[e]] += static_cast<double>(w[j]) * values[e];
+            }
+        }
+        offset = 0.0;
+        for (int d = 0; d < inputDim; d++) {
+            full[d] = static_cast<float>(acc[d]);
+            if (type == Type::PCA) offset += acc[d] * mean.at<float>(d);
+        }
+    }
+
+    // Función para guardar la proyección. Se escribe en un temporal que luego se renombra.
+    bool save(const std::string &path) const {
+        std::string tmpPath = path + ".tmp";
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            std::cerr << "No se pudo escribir la proyección " << tmpPath << std::endl;
+            return false;
+        }
+        HOGProjectionHeader header = {};
+        std::memcpy(header.magic, "HOGPROJ1", 8);
+        header.type = static_cast<int32_t>(type);
+        header.inputDim = inputDim;
+        header.outputDim = outputDim;
+        header.nonZeros = static_cast<int32_t>(cols.size());
+        header.paramsHash = signatureHash();
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        if (type == Type::PCA) {
+            out.write(mean.ptr<char>(), inputDim * sizeof(float));
+            for (int j = 0; j < outputDim; j++) {
+                out.write(basis.ptr<char>(j), inputDim * sizeof(float));
+            }
+        } else {
+            out.write(reinterpret_cast<const char *>(rowStart.data()), rowStart.size() * sizeof(int32_t));
+            out.write(reinterpret_cast<const char *>(cols.data()), cols.size() * sizeof(int32_t));
+            out.write(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(float));
+        }
+        out.close();
+        if (!out) {
+            std::cerr << "Error al escribir la proyección " << tmpPath << std::endl;
+            return false;
+        }
+        return std::rename(tmpPath.c_str(), path.c_str()) == 0;
+    }
+
+    // Función para leer una proyección guardada. Retorna false, sin mensaje, si el archivo no
+    // existe; si existe pero no corresponde a la configuración HOG actual, avisa y la descarta.
+    bool load(const std::string &path) {
+        *this = HOGProjection();
+        std::ifstream in(path, std::ios::binary);
+        if (!in.is_open()) {
+            return false;
+        }
+        HOGProjectionHeader header;
+        bool ok = static_cast<bool>(in.read(reinterpret_cast<char *>(&header), sizeof(header))) &&
+                  std::memcmp(header.magic, "HOGPROJ1", 8) == 0 && header.paramsHash == signatureHash() &&
+                  header.inputDim > 0 && header.outputDim > 0 && header.nonZeros >= 0 &&
+                  (header.type == static_cast<int32_t>(Type::PCA) || header.type == static_cast<int32_t>(Type::SparseRandom));
+        if (ok && header.type == static_cast<int32_t>(Type::PCA)) {
+            mean.create(1, header.inputDim, CV_32F);
+            basis.create(header.outputDim, header.inputDim, CV_32F);
+            ok = in.read(mean.ptr<char>(), header.inputDim * sizeof(float)) &&
+                 in.read(basis.ptr<char>(), basis.total() * sizeof(float));
+        } else if (ok) {
+            rowStart.resize(header.outputDim + 1);
+            cols.resize(header.nonZeros);
+            values.resize(header.nonZeros);
+            ok = in.read(reinterpret_cast<char *>(rowStart.data()), rowStart.size() * sizeof(int32_t)) &&
+                 in.read(reinterpret_cast<char *>(cols.data()), cols.size() * sizeof(int32_t)) &&
+                 in.read(reinterpret_cast<char *>(values.data()), values.size() * sizeof(float));
+            for (int j = 0; ok && j < header.outputDim; j++) {
+                ok = rowStart[j] <= rowStart[j + 1];
+            }
+            ok = ok && rowStart[0] == 0 && rowStart[header.outputDim] == header.nonZeros;
+            for (size_t e = 0; ok && e < cols.size(); e++) {
+                ok = cols[e] >= 0 && cols[e] < header.inputDim;
+            }
+        }
+        if (!ok) {
+            std::cout << "Proyección " << path << " incompatible con la configuración actual: se descarta" << std::endl;
+            *this = HOGProjection();
+            return false;
+        }
+        type = static_cast<Type>(header.type);
+        inputDim = header.inputDim;
+        outputDim = header.outputDim;
+        return true;
+    }
+
+private:
+    static uint64_t signatureHash() {
+        return hashBytes(HOG_PARAMS_SIGNATURE, std::strlen(HOG_PARAMS_SIGNATURE));
+    }
+
+    // Filas centradas por producto de matrices al proyectar con la PCA
+    static constexpr int pcaBlock = 256;
+
+    Type type = Type::None;
+    int inputDim = 0;
+    int outputDim = 0;
+
+    // PCA
+    cv::Mat mean;                       // 1 x inputDim, CV_32F
+    cv::Mat basis;                      // outputDim x inputDim, CV_32F (una componente por fila)
+
+    // Proyección aleatoria dispersa, por filas (CSR)
+    std::vector<int32_t> rowStart;
+    std::vector<int32_t> cols;
+    std::vector<float> values;
+};
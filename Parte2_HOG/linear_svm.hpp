@@ -0,0 +1,207 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <opencv2/ml.hpp>
+#include <algorithm>
+#include <cfloat>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "hog_projection.hpp"
+
+// Pesos de un cv::ml::SVM C_SVC con kernel lineal, extraídos al cargar el modelo.
+//
+// OpenCV resuelve el caso multiclase como uno-contra-uno: hay una función de decisión por
+// cada par de clases (i, j) con i < j, en el orden de class_labels, y cada una vale
+//   d_ij(x) = w_ij · x - rho_ij
+// Si d_ij(x) > 0 el par vota por i; si no, por j. Gana la clase con más votos.
+//
+// Si junto al modelo hay una proyección (HOGProjection::pathFor), el SVM se entrenó sobre
+// x' = P (x - media) y al cargarlo cada w_ij se pliega en Pᵀ w_ij sobre el descriptor completo:
+// predict y classDetector reciben siempre el descriptor HOG sin proyectar.
+class LinearSVM {
+public:
+    // Resultado de evaluar una muestra
+    struct Score {
+        int label;      // Clase ganadora (idéntica a SVM::predict)
+        float raw;      // Igual que SVM::predict con RAW_OUTPUT: d(x) con dos clases, la etiqueta con más de dos
+        float margin;   // Menor d(x) de los duelos de la clase ganadora, orientado a su favor
+    };
+
+    // Función para cargar el modelo desde el XML guardado por SVM::save
+    bool load(const std::string &path) {
+        model = cv::ml::SVM::load(path);
+        if (model.empty() || model->getKernelType() != cv::ml::SVM::LINEAR) {
+            std::cerr << "El modelo " << path << " no es un SVM lineal" << std::endl;
+            return false;
+        }
+
+        // Las etiquetas de clase no se exponen en la API de SVM, se leen del propio XML
+        cv::FileStorage fs(path, cv::FileStorage::READ);
+        cv::Mat labelsMat;
+        fs["opencv_ml_svm"]["class_labels"] >> labelsMat;
+        classLabels.clear();
+        for (size_t i = 0; i < labelsMat.total(); i++) {
+            classLabels.push_back(labelsMat.at<int>(static_cast<int>(i)));
+        }
+
+        // w_ij = suma de alpha_k * sv_k para los vectores de soporte de la función de decisión.
+        // Tras entrenar con kernel lineal OpenCV ya comprime cada función a un único vector.
+        cv::Mat sv = model->getSupportVectors();
+        compressed = true;
+        int pairs = static_cast<int>(classLabels.size() * (classLabels.size() - 1) / 2);
+        pairWeights.create(pairs, sv.cols, CV_32F);
+        pairRho.assign(pairs, 0.0);
+        for (int p = 0; p < pairs; p++) {
+            cv::Mat alpha, svIdx;
+            pairRho[p] = model->getDecisionFunction(p, alpha, svIdx);
+            compressed = compressed && svIdx.total() == 1 && alpha.at<double>(0) == 1.0;
+            cv::Mat w = cv::Mat::zeros(1, sv.cols, CV_64F);
+            for (int k = 0; k < static_cast<int>(svIdx.total()); k++) {
+                cv::Mat svRow;
+                sv.row(svIdx.at<int>(k)).convertTo(svRow, CV_64F);
+                w += svRow * alpha.at<double>(k);
+            }
+            cv::Mat dst = pairWeights.row(p);
+            w.convertTo(dst, CV_32F);
+        }
+
+        // Proyección guardada junto al modelo por el entrenamiento. Si existe pero no se puede
+        // plegar, el modelo se rechaza: sus pesos tienen la dimensión reducida y predict
+        // puntuaría solo los primeros floats del descriptor completo.
+        projected = false;
+        const std::string projectionPath = HOGProjection::pathFor(path);
+        if (std::ifstream(projectionPath).is_open()) {
+            HOGProjection projection;
+            if (!projection.load(projectionPath) || projection.outputSize() != pairWeights.cols) {
+                std::cerr << "La proyección " << projectionPath << " no corresponde al modelo " << path << std::endl;
+                return false;
+            }
+            foldProjection(projection);
+        }
+        return true;
+    }
+
+    // Función para plegar la proyección en las funciones de decisión:
+    //   w · P (x - media) - rho = (Pᵀ w) · x - ((Pᵀ w) · media + rho)
+    void foldProjection(const HOGProjection &projection) {
+        CV_Assert(projection.outputSize() == pairWeights.cols);
+        cv::Mat full(pairWeights.rows, projection.inputSize(), CV_32F);
+        for (int p = 0; p < pairWeights.rows; p++) {
+            double offset;
+            projection.unproject(pairWeights.ptr<float>(p), full.ptr<float>(p), offset);
+            pairRho[p] += offset;
+        }
+        pairWeights = full;
+        projected = true;
+    }
+
+    // Función para evaluar un descriptor (varCount floats contiguos) en una sola pasada.
+    //
+    // Cada bloque de 4 valores de x se lee una vez y se acumula en todos los pares a la vez, sin
+    // copiar el descriptor a un Mat. La aritmética reproduce la de OpenCV para el kernel lineal
+    // (grupos de 4 productos en float acumulados en double y resultado redondeado a float), de
+    // modo que con un modelo comprimido la etiqueta coincide exactamente con SVM::predict. Si el
+    // modelo no está comprimido (varios vectores por función) los pesos se suman al cargarlo y
+    // el resultado puede diferir en el último bit; lo mismo ocurre con una proyección plegada.
+    Score predict(const float *x) const {
+        const int pairs = pairWeights.rows;
+        const int dim = varCount();
+        cv::AutoBuffer<double, 64> sums(pairs);
+        cv::AutoBuffer<const float *, 64> w(pairs);
+        for (int p = 0; p < pairs; p++) {
+            sums[p] = 0.0;
+            w[p] = pairWeights.ptr<float>(p);
+        }
+
+        int k = 0;
+        for (; k <= dim - 4; k += 4) {
+            const float x0 = x[k], x1 = x[k + 1], x2 = x[k + 2], x3 = x[k + 3];
+            for (int p = 0; p < pairs; p++) {
+                const float *wp = w[p] + k;
+                sums[p] += wp[0] * x0 + wp[1] * x1 + wp[2] * x2 + wp[3] * x3;
+            }
+        }
+        for (; k < dim; k++) {
+            for (int p = 0; p < pairs; p++) {
+                sums[p] += w[p][k] * x[k];
+            }
+        }
+
+        // Votación uno-contra-uno, igual que en OpenCV
+        const int classes = classCount();
+        cv::AutoBuffer<int, 16> votes(classes);
+        for (int c = 0; c < classes; c++) {
+            votes[c] = 0;
+        }
+        for (int p = 0; p < pairs; p++) {
+            sums[p] = static_cast<float>(sums[p]) - pairRho[p];
+        }
+        for (int i = 0, p = 0; i < classes; i++) {
+            for (int j = i + 1; j < classes; j++, p++) {
+                votes[sums[p] > 0 ? i : j]++;
+            }
+        }
+        int best = 0;
+        for (int c = 1; c < classes; c++) {
+            if (votes[c] > votes[best]) best = c;
+        }
+
+        double margin = DBL_MAX;
+        for (int i = 0, p = 0; i < classes; i++) {
+            for (int j = i + 1; j < classes; j++, p++) {
+                if (i == best) margin = std::min(margin, sums[p]);
+                if (j == best) margin = std::min(margin, -sums[p]);
+            }
+        }
+
+        Score score;
+        score.label = classLabels[best];
+        score.raw = classes == 2 ? static_cast<float>(sums[0]) : static_cast<float>(score.label);
+        score.margin = static_cast<float>(margin);
+        return score;
+    }
+
+    Score predict(const cv::Mat &sample) const {
+        CV_Assert(sample.type() == CV_32F && sample.isContinuous() && static_cast<int>(sample.total()) == varCount());
+        return predict(sample.ptr<float>());
+    }
+
+    int classCount() const { return static_cast<int>(classLabels.size()); }
+    int varCount() const { return pairWeights.cols; }
+
+    // Función para plegar las funciones de decisión en un detector lineal por clase, con la
+    // misma disposición que HOGDescriptor::setSVMDetector (varCount pesos y el sesgo al final).
+    // La puntuación de la clase c es la suma de sus duelos orientados a su favor:
+    //   s_c(x) = sum_{j>c} d_cj(x) - sum_{i<c} d_ic(x)
+    // que sigue siendo lineal en x.
+    std::vector<float> classDetector(int c) const {
+        cv::Mat w = cv::Mat::zeros(1, varCount(), CV_64F);
+        double bias = 0.0;
+        int p = 0;
+        for (int i = 0; i < classCount(); i++) {
+            for (int j = i + 1; j < classCount(); j++, p++) {
+                if (i != c && j != c) continue;
+                double sign = (i == c) ? 1.0 : -1.0;
+                cv::Mat row;
+                pairWeights.row(p).convertTo(row, CV_64F);
+                w += row * sign;
+                bias -= sign * pairRho[p];
+            }
+        }
+        std::vector<float> detector(varCount() + 1);
+        for (int k = 0; k < varCount(); k++) {
+            detector[k] = static_cast<float>(w.at<double>(k));
+        }
+        detector[varCount()] = static_cast<float>(bias);
+        return detector;
+    }
+
+    cv::Ptr<cv::ml::SVM> model;
+    std::vector<int> classLabels;
+    cv::Mat pairWeights;            // Una fila CV_32F por par (i, j)
+    std::vector<double> pairRho;
+    bool compressed = false;        // Un único vector de soporte con alpha = 1 por función
+    bool projected = false;         // Los pesos incluyen una proyección plegada
+};
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "hog_features.hpp"
+#include "linear_svm.hpp"
+
+// Logo encontrado por el detector (coordenadas de la imagen original)
+struct Detection {
+    cv::Rect box;
+    int label;      // Etiqueta de clase del SVM
+    float score;    // Puntuación del detector lineal de la clase
+};
+
+// Detector de logos por ventana deslizante y pirámide de escalas.
+//
+// Cada clase del SVM se pliega en un detector lineal (LinearSVM::classDetector). Las ventanas
+// de 128x128 se recorren sobre cada nivel de la pirámide en franjas horizontales de
+// 'rowsPerBand' filas de ventanas. El descriptor HOG de una franja se calcula con una sola
+// llamada a HOGDescriptor::compute, que comparte los histogramas de los bloques solapados.
+// compute calcula el gradiente de toda la imagen que recibe, así que se le pasa solo la franja
+// (una vista con rowRange, sin copiar): el trabajo por nivel es proporcional a sus píxeles y no
+// a filas x píxeles. El gradiente del borde de la vista lee los píxeles vecinos de la imagen
+// padre, por lo que los descriptores coinciden con los del nivel completo. El preprocesamiento (desenfoque, umbral adaptativo,
+// ecualización) se aplica una vez por nivel en lugar de una vez por ventana: son operaciones
+// locales y sobre una imagen ya binaria equalizeHist no cambia nada, así que solo difieren
+// los píxeles del borde de cada ventana.
+//
+// A diferencia de HOGDescriptor::detect, la puntuación respeta la normalización min-max que
+// usa el entrenamiento. Con x' = (x - min) / (max - min):
+//   w · x' + b = (w · x - min * sum(w)) / (max - min) + b
+// por lo que basta con el producto w · x del descriptor sin normalizar.
+class LogoDetector {
+public:
+    LogoDetector(const LinearSVM &model, double scaleStep = 1.25, int winStride = 16,
+                 float hitThreshold = 0.0f, float nmsThreshold = 0.3f)
+        : scaleStep(scaleStep), winStride(winStride), hitThreshold(hitThreshold), nmsThreshold(nmsThreshold) {
+        classLabels = model.classLabels;
+        int dim = model.varCount();
+        weights.create(model.classCount(), dim, CV_32F);
+        for (int c = 0; c < model.classCount(); c++) {
+            std::vector<float> detector = model.classDetector(c);
+            std::copy(detector.begin(), detector.begin() + dim, weights.ptr<float>(c));
+            bias.push_back(detector[dim]);
+            weightSum.push_back(cv::sum(weights.row(c))[0]);
+        }
+    }
+
+    // Función para detectar logos en una imagen en escala de grises
+    std::vector<Detection> detect(const cv::Mat &gray) const {
+        const cv::Size win(128, 128);
+
+        // Niveles de la pirámide: la imagen se reduce hasta que deja de caber una ventana
+        std::vector<cv::Mat> levels;
+        std::vector<double> scales;
+        for (double scale = 1.0; gray.cols / scale >= win.width && gray.rows / scale >= win.height; scale *= scaleStep) {
+            TRAZA_AMBITO("piramide_nivel");
+            cv::Mat level;
+            cv::resize(gray, level, cv::Size(cvRound(gray.cols / scale), cvRound(gray.rows / scale)), 0, 0, cv::INTER_AREA);
+            cv::GaussianBlur(level, level, cv::Size(3, 3), 0);
+            cv::adaptiveThreshold(level, level, 255, cv::ADAPTIVE_THRESH_GAUSSIAN_C, cv::THRESH_BINARY, 11, 2);
+            cv::equalizeHist(level, level);
+            levels.push_back(level);
+            scales.push_back(scale);
+        }
+
+        // Una tarea por franja de filas de ventanas de cada nivel, repartidas entre todos los
+        // núcleos. Las franjas vecinas se solapan en win.height - winStride filas de píxeles.
+        struct BandTask { int level; int y; int rows; };
+        std::vector<BandTask> tasks;
+        for (size_t l = 0; l < levels.size(); l++) {
+            const int windowRows = (levels[l].rows - win.height) / winStride + 1;
+            for (int r = 0; r < windowRows; r += rowsPerBand) {
+                tasks.push_back({static_cast<int>(l), r * winStride, std::min(rowsPerBand, windowRows - r)});
+            }
+        }
+
+        std::vector<std::vector<Detection>> found(tasks.size());
+        cv::parallel_for_(cv::Range(0, static_cast<int>(tasks.size())), [&](const cv::Range &range) {
+            cv::HOGDescriptor hog = createHOG();
+            const int dim = weights.cols;
+            std::vector<float> descriptors;
+            std::vector<cv::Point> locations;
+            for (int t = range.start; t < range.end; t++) {
+                TRAZA_AMBITO("franja_ventanas");
+                const BandTask &task = tasks[t];
+                const cv::Mat &level = levels[task.level];
+                const double scale = scales[task.level];
+                const cv::Mat band = level.rowRange(task.y, task.y + (task.rows - 1) * winStride + win.height);
+
+                // Posiciones relativas a la franja
+                locations.clear();
+                for (int r = 0; r < task.rows; r++) {
+                    for (int x = 0; x + win.width <= level.cols; x += winStride) {
+                        locations.push_back(cv::Point(x, r * winStride));
+                    }
+                }
+                hog.compute(band, descriptors, cv::Size(winStride, winStride), cv::Size(0, 0), locations);
+
+                for (size_t k = 0; k < locations.size(); k++) {
+                    cv::Mat x(1, dim, CV_32F, descriptors.data() + k * dim);
+                    double minVal, maxVal;
+                    cv::minMaxLoc(x, &minVal, &maxVal);
+                    double range01 = maxVal - minVal;
+                    if (range01 <= 0) continue;
+
+                    int best = -1;
+                    double bestScore = hitThreshold;
+                    for (int c = 0; c < weights.rows; c++) {
+                        double s = (weights.row(c).dot(x) - minVal * weightSum[c]) / range01 + bias[c];
+                        if (s > bestScore) {
+                            bestScore = s;
+                            best = c;
+                        }
+                    }
+                    if (best >= 0) {
+                        cv::Rect box(cvRound(locations[k].x * scale), cvRound((task.y + locations[k].y) * scale),
+                                     cvRound(win.width * scale), cvRound(win.height * scale));
+                        found[t].push_back({box, classLabels[best], static_cast<float>(bestScore)});
+                    }
+                }
+            }
+        });
+
+        std::vector<Detection> candidates;
+        for (const auto &f : found) {
+            candidates.insert(candidates.end(), f.begin(), f.end());
+        }
+        return nonMaximumSuppression(candidates);
+    }
+
+private:
+    // Supresión de no máximos por clase: se conserva la detección con mayor puntuación y se
+    // descartan las de la misma clase que la solapen por encima de nmsThreshold (IoU).
+    std::vector<Detection> nonMaximumSuppression(std::vector<Detection> candidates) const {
+        TRAZA_AMBITO("nms");
+        std::stable_sort(candidates.begin(), candidates.end(),
+                         [](const Detection &a, const Detection &b) { return a.score > b.score; });
+        std::vector<Detection> kept;
+        for (const auto &d : candidates) {
+            bool suppressed = false;
+            for (const auto &k : kept) {
+                if (k.label != d.label) continue;
+                double inter = (d.box & k.box).area();
+                double iou = inter / (d.box.area() + k.box.area() - inter);
+                if (iou > nmsThreshold) {
+                    suppressed = true;
+                    break;
+                }
+            }
+            if (!suppressed) {
+                kept.push_back(d);
+            }
+        }
+        return kept;
+    }
+
+    // Filas de ventanas por franja: con winStride 16, una franja de 4 filas mide 176 píxeles de
+    // alto y su gradiente cubre 2.75 veces los 64 píxeles que avanza (8 veces con una fila)
+    static constexpr int rowsPerBand = 4;
+
+    double scaleStep;
+    int winStride;
+    float hitThreshold;
+    float nmsThreshold;
+
+    cv::Mat weights;                // Una fila CV_32F por clase
+    std::vector<double> bias;
+    std::vector<double> weightSum;
+    std::vector<int> classLabels;
+};
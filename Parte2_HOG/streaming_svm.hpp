@@ -0,0 +1,346 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include "descriptor_shards.hpp"
+#include "../comun/cola_acotada.hpp"
+
+// SVM lineal uno-contra-resto entrenado por Pegasos sobre fragmentos en disco
+// (descriptor_shards.hpp), sin cargar nunca el conjunto completo.
+//
+// Un hilo lector carga los fragmentos en el orden de cada época (barajado con la semilla) y los
+// deja en una cola acotada de 'prefetch' elementos, así que la lectura del siguiente fragmento
+// se solapa con el entrenamiento del actual. En memoria hay como mucho prefetch + 2 fragmentos
+// (los de la cola, el que se está leyendo y el que se está usando) más dos vectores de pesos
+// por clase: el presupuesto no depende del número total de muestras.
+//
+// Dentro de cada fragmento las filas también se recorren en un orden barajado. Cada clase es un
+// problema binario independiente (ella contra el resto), así que las clases se entrenan en
+// paralelo sobre el mismo fragmento. Por clase se usa Pegasos con w = s · v para que el
+// encogimiento (1 - 1/t) cueste O(1), proyección sobre la bola de radio 1/sqrt(lambda) y el
+// sesgo como un componente más (con valor 'biasFeature'). El modelo final es el promedio de los
+// pesos al terminar cada fragmento (ponderado por sus filas), desde la segunda época si hay más
+// de una; con average = false es el último.
+//
+// save escribe el modelo como un cv::ml::SVM lineal C_SVC, que cargan SVM::load y LinearSVM. Con
+// las puntuaciones s_c(x) = w_c · x + b_c, la función del par (i, j) es
+//   d_ij(x) = s_i(x) - s_j(x) = (w_i - w_j) · x - (b_j - b_i)
+// y la clase con mayor puntuación gana todos sus duelos: la votación uno-contra-uno de OpenCV da
+// la misma clase que el máximo de las puntuaciones uno-contra-resto.
+class StreamingSVM {
+public:
+    struct Params {
+        double lambda = 1e-4;       // Regularización (del orden de 1 / (C · muestras))
+        int epochs = 5;
+        uint64_t seed = 1;
+        size_t prefetch = 2;        // Fragmentos leídos por adelantado
+        bool average = true;
+        double biasFeature = 1.0;
+    };
+
+    // Función para entrenar sobre los fragmentos indicados. Retorna false si no hay datos.
+    bool train(const std::vector<std::string> &shards, const Params &params) {
+        if (shards.empty()) return false;
+
+        // Las clases salen de las etiquetas de todos los fragmentos (solo se leen las etiquetas)
+        std::set<int> labelSet;
+        size_t largestShard = 0, totalRows = 0;
+        dim = 0;
+        for (const auto &path : shards) {
+            DescriptorShard shard;
+            if (!shard.read(path, true)) continue;
+            if (dim != 0 && shard.dim != dim) {
+                std::cerr << "El fragmento " << path << " tiene otra dimensión" << std::endl;
+                return false;
+            }
+            dim = shard.dim;
+            labelSet.insert(shard.labels.begin(), shard.labels.end());
+            largestShard = std::max(largestShard, shard.size());
+            totalRows += shard.size();
+        }
+        classLabels.assign(labelSet.begin(), labelSet.end());
+        if (classLabels.size() < 2 || dim == 0) {
+            std::cerr << "Se necesitan al menos dos clases para entrenar" << std::endl;
+            return false;
+        }
+        const double shardMB = largestShard * (dim * sizeof(float) + sizeof(int32_t)) / (1024.0 * 1024.0);
+        std::cout << "Entrenamiento por fragmentos: " << totalRows << " filas en " << shards.size()
+                  << " fragmentos, memoria de fragmentos <= " << (params.prefetch + 2) * shardMB << " MB" << std::endl;
+
+        const int classes = static_cast<int>(classLabels.size());
+        std::vector<ClassState> states(classes);
+        for (auto &state : states) state.v.assign(dim + 1, 0.0);
+        std::vector<double> averaged(static_cast<size_t>(classes) * (dim + 1), 0.0);
+        double averagedWeight = 0.0;
+        const int averageFrom = params.average && params.epochs > 1 ? 1 : 0;
+
+        // Lector: carga los fragmentos de cada época, en orden barajado, por delante del entrenamiento
+        ColaAcotada<DescriptorShard> queue(params.prefetch);
+        std::thread reader([&] {
+            std::vector<size_t> order(shards.size());
+            for (int epoch = 0; epoch < params.epochs; epoch++) {
+                std::iota(order.begin(), order.end(), 0);
+                std::mt19937_64 rng(params.seed + epoch);
+                std::shuffle(order.begin(), order.end(), rng);
+                for (size_t k : order) {
+                    DescriptorShard shard;
+                    {
+                        TRAZA_AMBITO("leer_fragmento");
+                        if (!shard.read(shards[k]) || shard.dim != dim) continue;
+                    }
+                    shard.epoch = epoch;
+                    shard.index = static_cast<int>(k);
+                    if (!queue.poner(std::move(shard))) return;
+                }
+            }
+            queue.cerrar();
+        });
+
+        uint64_t t = 0;
+        int currentEpoch = -1;
+        size_t epochRows = 0, epochCorrect = 0;
+        double epochHinge = 0.0;
+        cv::TickMeter tm;
+        tm.start();
+        DescriptorShard shard;
+        while (queue.sacar(shard)) {
+            if (shard.epoch != currentEpoch) {
+                if (currentEpoch >= 0) reportEpoch(currentEpoch, epochRows, epochCorrect, epochHinge, tm);
+                currentEpoch = shard.epoch;
+                epochRows = epochCorrect = 0;
+                epochHinge = 0.0;
+            }
+
+            // Orden de las filas: depende solo de la semilla, la época y el fragmento
+            std::vector<size_t> order(shard.size());
+            std::iota(order.begin(), order.end(), 0);
+            const int32_t key[2] = {shard.epoch, shard.index};
+            std::mt19937_64 rng(hashBytes(key, sizeof(key), params.seed));
+            std::shuffle(order.begin(), order.end(), rng);
+
+            // Normas de las filas, compartidas por todas las clases
+            std::vector<double> norms(shard.size());
+            for (size_t i = 0; i < shard.size(); i++) {
+                const float *x = shard.row(i);
+                double n = params.biasFeature * params.biasFeature;
+                for (int d = 0; d < dim; d++) n += static_cast<double>(x[d]) * x[d];
+                norms[i] = n;
+            }
+
+            // Puntuación de cada fila antes de actualizar (validación progresiva)
+            std::vector<double> scores(shard.size() * classes);
+            {
+                TRAZA_AMBITO("pegasos");
+                cv::parallel_for_(cv::Range(0, classes), [&](const cv::Range &range) {
+                    for (int c = range.start; c < range.end; c++) {
+                        uint64_t tc = t;
+                        for (size_t k = 0; k < order.size(); k++) {
+                            const size_t i = order[k];
+                            scores[i * classes + c] = states[c].step(shard.row(i), norms[i], dim,
+                                                                     shard.labels[i] == classLabels[c] ? 1 : -1, ++tc,
+                                                                     params.lambda, params.biasFeature);
+                        }
+                    }
+                });
+            }
+            t += shard.size();
+
+            for (size_t i = 0; i < shard.size(); i++) {
+                const double *s = &scores[i * classes];
+                const int best = static_cast<int>(std::max_element(s, s + classes) - s);
+                epochCorrect += classLabels[best] == shard.labels[i];
+                for (int c = 0; c < classes; c++) {
+                    const double y = shard.labels[i] == classLabels[c] ? 1.0 : -1.0;
+                    epochHinge += std::max(0.0, 1.0 - y * s[c]);
+                }
+            }
+            epochRows += shard.size();
+
+            if (shard.epoch >= averageFrom) {
+                const double weight = static_cast<double>(shard.size());
+                for (int c = 0; c < classes; c++) {
+                    double *a = &averaged[static_cast<size_t>(c) * (dim + 1)];
+                    for (int d = 0; d <= dim; d++) a[d] += weight * states[c].s * states[c].v[d];
+                }
+                averagedWeight += weight;
+            }
+        }
+        reader.join();
+        if (currentEpoch >= 0) reportEpoch(currentEpoch, epochRows, epochCorrect, epochHinge, tm);
+        if (t == 0) return false;
+
+        // Pesos finales: el promedio o el último iterado
+        weights.create(classes, dim, CV_32F);
+        bias.assign(classes, 0.0);
+        for (int c = 0; c < classes; c++) {
+            for (int d = 0; d <= dim; d++) {
+                const double w = params.average && averagedWeight > 0
+                                     ? averaged[static_cast<size_t>(c) * (dim + 1) + d] / averagedWeight
+                                     : states[c].s * states[c].v[d];
+                if (d < dim) {
+                    weights.at<float>(c, d) = static_cast<float>(w);
+                } else {
+                    bias[c] = w * params.biasFeature;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Función para clasificar un descriptor: clase con mayor puntuación
+    int predict(const float *x) const {
+        int best = 0;
+        double bestScore = -HUGE_VAL;
+        for (int c = 0; c < weights.rows; c++) {
+            const float *w = weights.ptr<float>(c);
+            double s = bias[c];
+            for (int d = 0; d < dim; d++) s += static_cast<double>(w[d]) * x[d];
+            if (s > bestScore) {
+                bestScore = s;
+                best = c;
+            }
+        }
+        return classLabels[best];
+    }
+
+    // Función para medir la precisión sobre fragmentos de prueba, leídos de uno en uno
+    double evaluate(const std::vector<std::string> &shards) const {
+        size_t rows = 0, correct = 0;
+        DescriptorShard shard;
+        for (const auto &path : shards) {
+            if (!shard.read(path) || shard.dim != dim) continue;
+            for (size_t i = 0; i < shard.size(); i++) {
+                correct += predict(shard.row(i)) == shard.labels[i];
+            }
+            rows += shard.size();
+        }
+        return rows > 0 ? 100.0 * correct / rows : 0.0;
+    }
+
+    // Función para guardar el modelo con el formato de cv::ml::SVM (ver arriba)
+    bool save(const std::string &path) const {
+        cv::FileStorage fs(path, cv::FileStorage::WRITE);
+        if (!fs.isOpened()) {
+            std::cerr << "No se pudo crear " << path << std::endl;
+            return false;
+        }
+        const int classes = weights.rows;
+        const int pairs = classes * (classes - 1) / 2;
+        fs << "opencv_ml_svm" << "{";
+        fs << "format" << 3;
+        fs << "svmType" << "C_SVC";
+        fs << "kernel" << "{" << "type" << "LINEAR" << "}";
+        fs << "C" << 1.0;
+        fs << "var_count" << dim;
+        fs << "class_count" << classes;
+        fs << "class_labels" << cv::Mat(classLabels, true);
+        fs << "sv_total" << pairs;
+
+        // Un vector de soporte por par: w_i - w_j
+        fs << "support_vectors" << "[";
+        std::vector<float> sv(dim);
+        for (int i = 0; i < classes; i++) {
+            for (int j = i + 1; j < classes; j++) {
+                const float *wi = weights.ptr<float>(i), *wj = weights.ptr<float>(j);
+                for (int d = 0; d < dim; d++) sv[d] = wi[d] - wj[d];
+                fs << "[:";
+                fs.writeRaw("f", sv.data(), sv.size() * sizeof(float));
+                fs << "]";
+            }
+        }
+        fs << "]";
+
+        fs << "decision_functions" << "[";
+        for (int i = 0, p = 0; i < classes; i++) {
+            for (int j = i + 1; j < classes; j++, p++) {
+                const double alpha = 1.0;
+                fs << "{" << "sv_count" << 1 << "rho" << bias[j] - bias[i] << "alpha" << "[:";
+                fs.writeRaw("d", &alpha, sizeof(alpha));
+                fs << "]" << "index" << "[:";
+                fs.writeRaw("i", &p, sizeof(p));
+                fs << "]" << "}";
+            }
+        }
+        fs << "]";
+        fs << "}";
+        return true;
+    }
+
+    int varCount() const { return dim; }
+    int classCount() const { return static_cast<int>(classLabels.size()); }
+
+    std::vector<int> classLabels;
+    cv::Mat weights;                // Una fila CV_32F por clase
+    std::vector<double> bias;
+
+private:
+    // Estado de Pegasos de una clase: w = s · v (el último componente de v es el sesgo)
+    struct ClassState {
+        std::vector<double> v;
+        double s = 1.0;
+        double norm2 = 0.0;         // ||v||²
+
+        // Paso t con la muestra x (||x||² = xNorm2, incluido el sesgo). Retorna la puntuación
+        // w · x antes del paso.
+        double step(const float *x, double xNorm2, int dim, int y, uint64_t t, double lambda, double biasFeature) {
+            double dot = v[dim] * biasFeature;
+            for (int d = 0; d < dim; d++) dot += v[d] * x[d];
+            const double score = s * dot;
+
+            // w <- (1 - eta · lambda) w, con eta = 1 / (lambda t); en t = 1 el factor es 0
+            const double eta = 1.0 / (lambda * static_cast<double>(t));
+            const double shrink = 1.0 - 1.0 / static_cast<double>(t);
+            if (shrink <= 0.0) {
+                std::fill(v.begin(), v.end(), 0.0);
+                s = 1.0;
+                norm2 = 0.0;
+                dot = 0.0;
+            } else {
+                s *= shrink;
+            }
+
+            // Si la muestra viola el margen: w <- w + eta y x
+            if (y * score < 1.0) {
+                const double a = eta * y / s;
+                for (int d = 0; d < dim; d++) v[d] += a * x[d];
+                v[dim] += a * biasFeature;
+                norm2 += 2.0 * a * dot + a * a * xNorm2;
+            }
+
+            // Proyección sobre la bola de radio 1 / sqrt(lambda)
+            const double norm = s * std::sqrt(std::max(norm2, 0.0));
+            const double radius = 1.0 / std::sqrt(lambda);
+            if (norm > radius) s *= radius / norm;
+
+            // Se vuelve a escalar v antes de que s pierda precisión
+            if (s < 1e-6) {
+                for (double &value : v) value *= s;
+                norm2 *= s * s;
+                s = 1.0;
+            }
+            return score;
+        }
+    };
+
+    static void reportEpoch(int epoch, size_t rows, size_t correct, double hinge, cv::TickMeter &tm) {
+        tm.stop();
+        const double seconds = tm.getTimeSec();
+        std::cout << "Época " << epoch + 1 << ": " << rows << " muestras, precisión progresiva "
+                  << (rows > 0 ? 100.0 * correct / rows : 0.0) << "%, pérdida hinge media "
+                  << (rows > 0 ? hinge / rows : 0.0) << " (" << (seconds > 0 ? rows / seconds : 0.0)
+                  << " muestras/s)" << std::endl;
+        tm.reset();
+        tm.start();
+    }
+
+    int dim = 0;
+};
@@ -0,0 +1,1200 @@
+// Micro-benchmarks de las etapas de extracción de características y clasificación.
+//
+// Cada caso se ejecuta 'warmup' veces sin medir y luego 'runs' veces sobre el mismo conjunto de
+// imágenes; se informa la mediana, el mínimo y la media por ejecución. Con --json se guardan los
+// resultados y con --baseline se comparan contra un archivo anterior: si la mediana de algún
+// caso empeora más de --tolerance (fracción), el programa termina con código 1.
+//
+// Antes de medir se ejecutan las validaciones numéricas (cada optimización contra su versión de
+// referencia). Si alguna falla el programa termina con código 1 sin medir ni escribir --json;
+// con --validate solo se ejecutan las validaciones (make check).
+//
+//   ./bench.bin --validate
+//   ./bench.bin --runs=10 --json=actual.json --baseline=base.json
+
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cfloat>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <numeric>
+#include <string>
+#include <vector>
+#include "../Parte2_HOG/hog_features.hpp"
+#include "../Parte2_HOG/augmentation.hpp"
+#include "../Parte2_HOG/hog_projection.hpp"
+#include "../Parte2_HOG/linear_svm.hpp"
+#include "../Parte2_HOG/descriptor_shards.hpp"
+#include "../Parte2_HOG/streaming_svm.hpp"
+#include "../preparacion/momentos.hpp"
+#include "../preparacion/hu_esqueleto.hpp"
+#include "../momentos/app/src/main/cpp/momentos_core.hpp"
+#include "../comun/knn.hpp"
+#include "../comun/dataset_binario.hpp"
+#include "../comun/centroides.hpp"
+#include "../comun/zernike.hpp"
+#include "../comun/traza.hpp"
+
+using namespace cv;
+using namespace std;
+namespace fs = std::filesystem;
+
+// Caso de benchmark: una pasada completa sobre sus entradas, que procesa 'items' elementos
+struct BenchCase {
+    string name;
+    size_t items;
+    function<void()> run;
+};
+
+// Resultado de un caso, en milisegundos por pasada
+struct BenchResult {
+    string name;
+    size_t items;
+    double median;
+    double min;
+    double mean;
+};
+
+// Resultado de una validación numérica y el mensaje si falla
+struct Validation {
+    bool ok;
+    string failure;
+};
+
+// Evita que el compilador descarte los cálculos cuyo resultado no se usa
+static volatile double sink = 0.0;
+
+// Función para cargar hasta 'maxImages' imágenes de una carpeta (recorriendo subcarpetas)
+vector<Mat> loadImages(const string &folder, int flags, size_t maxImages) {
+    vector<string> paths;
+    if (fs::exists(folder)) {
+        for (const auto &entry : fs::recursive_directory_iterator(folder)) {
+            if (entry.is_regular_file()) paths.push_back(entry.path().string());
+        }
+    }
+    sort(paths.begin(), paths.end());
+
+    vector<Mat> images;
+    for (const auto &path : paths) {
+        if (images.size() >= maxImages) break;
+        Mat img = imread(path, flags);
+        if (!img.empty()) images.push_back(img);
+    }
+    return images;
+}
+
+// Función para medir un caso
+BenchResult measure(const BenchCase &bench, int warmup, int runs) {
+    for (int i = 0; i < warmup; i++) {
+        bench.run();
+    }
+    vector<double> times;
+    for (int i = 0; i < runs; i++) {
+        TickMeter tm;
+        tm.start();
+        bench.run();
+        tm.stop();
+        times.push_back(tm.getTimeMilli());
+    }
+    sort(times.begin(), times.end());
+    double median = times.size() % 2 ? times[times.size() / 2]
+                                     : (times[times.size() / 2 - 1] + times[times.size() / 2]) / 2.0;
+    double mean = accumulate(times.begin(), times.end(), 0.0) / times.size();
+    return {bench.name, bench.items, median, times.front(), mean};
+}
+
+// Función para guardar los resultados en JSON
+void saveResults(const string &path, const vector<BenchResult> &results) {
+    FileStorage fs(path, FileStorage::WRITE | FileStorage::FORMAT_JSON);
+    fs << "results" << "[";
+    for (const auto &r : results) {
+        fs << "{" << "name" << r.name << "items" << static_cast<int>(r.items)
+           << "median_ms" << r.median << "min_ms" << r.min << "mean_ms" << r.mean << "}";
+    }
+    fs << "]";
+}
+
+// Función para comparar contra una línea base. Devuelve el número de regresiones.
+int compareBaseline(const string &path, const vector<BenchResult> &results, double tolerance) {
+    FileStorage fs(path, FileStorage::READ);
+    if (!fs.isOpened()) {
+        cerr << "No se pudo abrir la línea base " << path << endl;
+        return 0;
+    }
+
+    int regressions = 0;
+    cout << "\nComparación con " << path << " (tolerancia " << tolerance * 100 << "%)" << endl;
+    for (const auto &node : fs["results"]) {
+        string name = (string)node["name"];
+        double baseMedian = (double)node["median_ms"];
+        auto it = find_if(results.begin(), results.end(), [&](const BenchResult &r) { return r.name == name; });
+        if (it == results.end() || baseMedian <= 0) continue;
+
+        double change = it->median / baseMedian - 1.0;
+        bool regression = change > tolerance;
+        regressions += regression;
+        cout << left << setw(32) << name << right << setw(10) << baseMedian << " -> " << setw(10) << it->median
+             << " ms (" << showpos << change * 100 << noshowpos << "%)" << (regression ? "  REGRESIÓN" : "") << endl;
+    }
+    return regressions;
+}
+
+// Función para comparar LogoHOG con cv::HOGDescriptor. Devuelve la mayor diferencia absoluta
+// entre componentes de los descriptores normalizados.
+double validateFixedHOG(const vector<Mat> &images) {
+    double maxDiff = 0.0;
+    vector<float> fixed, reference;
+    for (const auto &img : images) {
+        computeHOG(img, fixed);
+        computeHOGOpenCV(img, reference);
+        CV_Assert(fixed.size() == reference.size());
+        for (size_t k = 0; k < fixed.size(); k++) {
+            maxDiff = max(maxDiff, static_cast<double>(fabs(fixed[k] - reference[k])));
+        }
+    }
+    return maxDiff;
+}
+
+// Función para comprobar una proyección HOG sobre los descriptores de 'data': la proyección por
+// lotes frente a la de una muestra (relativa al mayor componente de la fila), el plegado de unos
+// pesos aleatorios (w · Px frente a (Pᵀ w) · x - offset) y la ida y vuelta por archivo. Devuelve
+// la mayor diferencia relativa.
+double validateProjection(const HOGProjection &projection, const Mat &data) {
+    const string path = (fs::temp_directory_path() / "bench_proyeccion.proj").string();
+    HOGProjection loaded;
+    if (!projection.save(path) || !loaded.load(path)) return DBL_MAX;
+    fs::remove(path);
+
+    Mat batch, reloaded;
+    projection.project(data, batch);
+    loaded.project(data, reloaded);
+    double maxDiff = norm(batch, reloaded, NORM_INF) > 0 ? DBL_MAX : 0.0;
+
+    RNG rng(7);
+    vector<float> w(projection.outputSize()), full(projection.inputSize()), single(projection.outputSize());
+    for (float &v : w) v = static_cast<float>(rng.gaussian(1.0));
+    double offset;
+    projection.unproject(w.data(), full.data(), offset);
+    for (int i = 0; i < data.rows; i++) {
+        const float *x = data.ptr<float>(i);
+        projection.project(x, single.data());
+        double projected = 0.0, folded = -offset, scale = 0.0, rowScale = 1e-12;
+        for (int j = 0; j < projection.outputSize(); j++) {
+            rowScale = max(rowScale, static_cast<double>(fabs(single[j])));
+        }
+        for (int j = 0; j < projection.outputSize(); j++) {
+            maxDiff = max(maxDiff, fabs(batch.at<float>(i, j) - single[j]) / rowScale);
+            projected += static_cast<double>(w[j]) * single[j];
+            scale += fabs(w[j] * single[j]);
+        }
+        for (int d = 0; d < projection.inputSize(); d++) folded += static_cast<double>(full[d]) * x[d];
+        maxDiff = max(maxDiff, fabs(projected - folded) / max(scale, 1e-12));
+    }
+    return maxDiff;
+}
+
+// Función para validar la exportación de StreamingSVM: entrena sobre fragmentos sintéticos
+// separables (etiquetas no consecutivas) en una carpeta temporal, guarda el modelo y lo vuelve a
+// cargar con cv::ml::SVM::load y con LinearSVM; ambos deben predecir lo mismo que
+// StreamingSVM::predict en todas las filas. También comprueba que un fragmento truncado se omita.
+// Devuelve el número de discrepancias, o -1 si el entrenamiento o la carga fallan.
+int validateStreamingSVM() {
+    const fs::path folder = fs::temp_directory_path() / "bench_streaming";
+    fs::remove_all(folder);
+    const string prefix = (folder / "svm").string();
+    const string modelPath = (folder / "svm.xml").string();
+    const int dim = 48;
+    const vector<int> classLabels = {1, 2, 4, 7};
+    {
+        DescriptorShardWriter writer(prefix, dim, 128);
+        RNG rng(11);
+        vector<float> x(dim);
+        for (int i = 0; i < 1000; i++) {
+            const int c = i % static_cast<int>(classLabels.size());
+            for (int d = 0; d < dim; d++) {
+                x[d] = static_cast<float>(rng.gaussian(0.3)) + (d % classLabels.size() == static_cast<size_t>(c) ? 1.0f : 0.0f);
+            }
+            writer.write(classLabels[c], x.data());
+        }
+    }
+
+    StreamingSVM streaming;
+    StreamingSVM::Params params;
+    params.epochs = 3;
+    int mismatches = -1;
+    LinearSVM linear;
+    if (streaming.train(listShards(prefix), params) && streaming.save(modelPath) && linear.load(modelPath)) {
+        Ptr<ml::SVM> svm = ml::SVM::load(modelPath);
+        if (!svm.empty() && linear.varCount() == dim) {
+            mismatches = 0;
+            DescriptorShard shard;
+            for (const auto &path : listShards(prefix)) {
+                if (!shard.read(path)) {
+                    mismatches++;
+                    continue;
+                }
+                for (size_t i = 0; i < shard.size(); i++) {
+                    const int expected = streaming.predict(shard.row(i));
+                    Mat sample(1, dim, CV_32F, const_cast<float *>(shard.row(i)));
+                    mismatches += static_cast<int>(svm->predict(sample)) != expected;
+                    mismatches += linear.predict(shard.row(i)).label != expected;
+                }
+            }
+
+            const string truncated = (folder / "truncado.shard").string();
+            fs::copy_file(listShards(prefix).front(), truncated);
+            fs::resize_file(truncated, fs::file_size(truncated) - sizeof(float));
+            mismatches += shard.read(truncated);
+        }
+    }
+    fs::remove_all(folder);
+    return mismatches;
+}
+
+// Función para comparar momentosHuFigura con la cadena de OpenCV (máscara + cv::moments).
+// Devuelve la mayor diferencia relativa entre momentos de Hu.
+double validateMomentosFigura(const vector<Mat> &images) {
+    double maxDiff = 0.0;
+    for (const auto &img : images) {
+        vector<double> fused = momentos::momentosHuFigura(img);
+        Moments m = moments(momentos::preprocesarImagen(img), true);
+        double reference[7];
+        HuMoments(m, reference);
+        for (int k = 0; k < 7; k++) {
+            double scale = max(fabs(reference[k]), 1e-300);
+            maxDiff = max(maxDiff, fabs(fused[k] - reference[k]) / scale);
+        }
+    }
+    return maxDiff;
+}
+
+// Conversión RGB_565 -> BGR que hacía bitmapToMat en la librería nativa, píxel a píxel
+Mat rgb565ABGR(const Mat &src) {
+    Mat bgr(src.rows, src.cols, CV_8UC3);
+    for (int y = 0; y < src.rows; y++) {
+        const uint16_t *p = src.ptr<uint16_t>(y);
+        for (int x = 0; x < src.cols; x++) {
+            uint8_t r = (p[x] >> 11) & 0x1F, g = (p[x] >> 5) & 0x3F, b = p[x] & 0x1F;
+            bgr.at<Vec3b>(y, x) = Vec3b((b * 255) / 31, (g * 255) / 63, (r * 255) / 31);
+        }
+    }
+    return bgr;
+}
+
+// Bitmaps sintéticos a partir de las figuras: RGBA_8888 y RGB_565, con filas más largas que la
+// imagen (stride != ancho * bytes) como las que puede entregar AndroidBitmap_lockPixels
+void makeBitmaps(const vector<Mat> &images, vector<Mat> &rgba, vector<Mat> &rgb565) {
+    for (const auto &img : images) {
+        Mat full(img.rows, img.cols + 3, CV_8UC4, Scalar::all(0));
+        Mat roi = full(Rect(0, 0, img.cols, img.rows));
+        cvtColor(img, roi, COLOR_BGR2RGBA);
+        rgba.push_back(roi);
+
+        Mat full565(img.rows, img.cols + 5, CV_8UC2, Scalar::all(0));
+        Mat roi565 = full565(Rect(0, 0, img.cols, img.rows));
+        cvtColor(img, roi565, COLOR_BGR2BGR565);
+        rgb565.push_back(roi565);
+    }
+}
+
+// Función para comparar momentosHuFigura sobre los bitmaps con la ruta anterior (bitmapToMat a
+// BGR + cadena de OpenCV). Devuelve la mayor diferencia relativa entre momentos de Hu.
+double validateBitmaps(const vector<Mat> &rgba, const vector<Mat> &rgb565) {
+    double maxDiff = 0.0;
+    auto compare = [&](const vector<double> &fused, const Mat &bgr) {
+        double reference[7];
+        HuMoments(moments(momentos::preprocesarImagen(bgr), true), reference);
+        for (int k = 0; k < 7; k++) {
+            maxDiff = max(maxDiff, fabs(fused[k] - reference[k]) / max(fabs(reference[k]), 1e-300));
+        }
+    };
+    for (const auto &img : rgba) {
+        Mat bgr;
+        cvtColor(img, bgr, COLOR_RGBA2BGR);
+        compare(momentos::momentosHuFigura(img, mascara::FormatoPixel::RGBA), bgr);
+    }
+    for (const auto &img : rgb565) {
+        compare(momentos::momentosHuFigura(img, mascara::FormatoPixel::RGB565), rgb565ABGR(img));
+    }
+    return maxDiff;
+}
+
+// Función para comparar la máscara actualizada por zonas (umbralizarZona) con la recalculada
+// desde cero. Cada figura se "dibuja" sobre un lienzo blanco copiando bloques en orden aleatorio
+// y tras cada bloque se comparan los momentos de Hu. Devuelve el número de diferencias.
+int validateIncremental(const vector<Mat> &images) {
+    RNG rng(12345);
+    int mismatches = 0;
+    for (const auto &img : images) {
+        Mat lienzo(img.size(), CV_8UC3, Scalar(255, 255, 255));
+        mascara::MascaraBits dibujo;
+        mascara::umbralizarImagen(lienzo.ptr<uchar>(), lienzo.step[0], lienzo.cols, lienzo.rows,
+                                  mascara::FormatoPixel::BGR, 235, dibujo);
+        for (int paso = 0; paso < 8; paso++) {
+            int x = rng.uniform(0, img.cols), y = rng.uniform(0, img.rows);
+            Rect zona = Rect(x, y, rng.uniform(1, img.cols / 2 + 2), rng.uniform(1, img.rows / 2 + 2)) &
+                        Rect(0, 0, img.cols, img.rows);
+            img(zona).copyTo(lienzo(zona));
+            mascara::umbralizarZona(lienzo.ptr<uchar>(), lienzo.step[0], mascara::FormatoPixel::BGR, 235, zona, dibujo);
+            mismatches += momentos::momentosHuUmbralizada(dibujo) != momentos::momentosHuFigura(lienzo);
+        }
+    }
+    return mismatches;
+}
+
+// Momentos de Zernike calculados como mb_zernike2D (pychrm): polinomios radiales con
+// factoriales y potencias, y atan2, cos y sin por píxel. Es la referencia de comun/zernike.hpp.
+vector<double> zernikeReferencia(const Mat &binaria, int orden, double radio) {
+    auto factorial = [](int n) {
+        long double f = 1;
+        for (int i = 2; i <= n; i++) f *= i;
+        return f;
+    };
+    vector<double> X, Y, P;
+    double suma = 0, m10 = 0, m01 = 0;
+    for (int y = 0; y < binaria.rows; y++) {
+        for (int x = 0; x < binaria.cols; x++) {
+            const double v = binaria.at<uchar>(y, x);
+            if (v == 0) continue;
+            X.push_back(x + 1);
+            Y.push_back(y + 1);
+            P.push_back(v);
+            suma += v;
+            m10 += (x + 1) * v;
+            m01 += (y + 1) * v;
+        }
+    }
+    vector<double> z;
+    for (int n = 0; n <= orden; n++) {
+        for (int l = n % 2; l <= n; l += 2) {
+            double re = 0, im = 0;
+            for (size_t i = 0; i < P.size() && suma > 0; i++) {
+                const double x = (X[i] - m10 / suma) / radio, y = (Y[i] - m01 / suma) / radio;
+                const double r = sqrt(x * x + y * y);
+                if (r > 1.0) continue;
+                double rnl = 0;
+                for (int s = 0; s <= (n - l) / 2; s++) {
+                    const long double c = factorial(n - s) /
+                                          (factorial(s) * factorial((n + l) / 2 - s) * factorial((n - l) / 2 - s));
+                    rnl += (s % 2 ? -1.0 : 1.0) * static_cast<double>(c) * pow(r, n - 2 * s);
+                }
+                const double a = atan2(y, x);
+                re += P[i] / suma * rnl * cos(l * a);
+                im -= P[i] / suma * rnl * sin(l * a);
+            }
+            z.push_back((n + 1) / CV_PI * sqrt(re * re + im * im));
+        }
+    }
+    return z;
+}
+
+// Entrada de la esqueletización en calculateHuMoments: 160 x 160 (o 'lado'), umbral inverso
+// en 235, erosión y dilatación 3 x 3
+Mat binarizarEsqueleto(const Mat &img, int lado = 160) {
+    Mat r, gris, binaria;
+    resize(img, r, Size(lado, lado), 0, 0, INTER_LINEAR);
+    cvtColor(r, gris, COLOR_BGR2GRAY);
+    threshold(gris, binaria, 235, 255, THRESH_BINARY_INV);
+    Mat kernel = getStructuringElement(MORPH_RECT, Size(3, 3));
+    erode(binaria, binaria, kernel);
+    dilate(binaria, binaria, kernel);
+    return binaria;
+}
+
+// Esqueletización de Zhang-Suen como cv::ximgproc::thinning: cada subiteración recorre la
+// imagen completa y se repite hasta que una iteración no cambia nada. Es la referencia de
+// comun/esqueleto.hpp.
+Mat zhangSuenReferencia(const Mat &binaria) {
+    Mat img = binaria / 255, anterior;
+    do {
+        img.copyTo(anterior);
+        for (int iter = 0; iter < 2; iter++) {
+            Mat marca = Mat::zeros(img.size(), CV_8U);
+            for (int i = 1; i < img.rows - 1; i++) {
+                for (int j = 1; j < img.cols - 1; j++) {
+                    if (img.at<uchar>(i, j) == 0) continue;
+                    const int p2 = img.at<uchar>(i - 1, j), p3 = img.at<uchar>(i - 1, j + 1);
+                    const int p4 = img.at<uchar>(i, j + 1), p5 = img.at<uchar>(i + 1, j + 1);
+                    const int p6 = img.at<uchar>(i + 1, j), p7 = img.at<uchar>(i + 1, j - 1);
+                    const int p8 = img.at<uchar>(i, j - 1), p9 = img.at<uchar>(i - 1, j - 1);
+                    const int a = (p2 == 0 && p3 == 1) + (p3 == 0 && p4 == 1) + (p4 == 0 && p5 == 1) +
+                                  (p5 == 0 && p6 == 1) + (p6 == 0 && p7 == 1) + (p7 == 0 && p8 == 1) +
+                                  (p8 == 0 && p9 == 1) + (p9 == 0 && p2 == 1);
+                    const int b = p2 + p3 + p4 + p5 + p6 + p7 + p8 + p9;
+                    const int m1 = iter == 0 ? p2 * p4 * p6 : p2 * p4 * p8;
+                    const int m2 = iter == 0 ? p4 * p6 * p8 : p2 * p6 * p8;
+                    if (a == 1 && b >= 2 && b <= 6 && m1 == 0 && m2 == 0) marca.at<uchar>(i, j) = 1;
+                }
+            }
+            img &= ~marca;
+        }
+    } while (norm(img, anterior, NORM_INF) > 0);
+    return img * 255;
+}
+
+// Función para comparar esqueleto::zhangSuen con la referencia. Devuelve el número de imágenes
+// con algún píxel distinto.
+int validateEsqueleto(const vector<Mat> &binarias) {
+    int mismatches = 0;
+    for (const auto &b : binarias) {
+        Mat rapido;
+        esqueleto::zhangSuen(b, rapido);
+        mismatches += norm(rapido, zhangSuenReferencia(b), NORM_INF) > 0;
+    }
+    return mismatches;
+}
+
+// Función para comparar zernike::momentos con la referencia (y la versión paralela con la
+// secuencial) en cada imagen binarizada. Devuelve la diferencia máxima, relativa a la magnitud
+// del momento o a 1e-3 si es menor; infinito si cambia el número de momentos o si el
+// resultado paralelo no es idéntico.
+double validateZernike(const vector<Mat> &binarias, int orden) {
+    double maxDiff = 0.0;
+    for (const auto &b : binarias) {
+        const double radio = min(b.cols, b.rows) / 2.0;
+        vector<double> a = zernike::momentos(b, orden, radio), r = zernikeReferencia(b, orden, radio);
+        if (a.size() != r.size() || a != zernike::momentos(b, orden, radio, false)) {
+            return numeric_limits<double>::infinity();
+        }
+        for (size_t i = 0; i < a.size(); i++) {
+            maxDiff = max(maxDiff, abs(a[i] - r[i]) / max(abs(r[i]), 1e-3));
+        }
+    }
+    return maxDiff;
+}
+
+// Función para comparar momentosLote (base en float32) con zernike::momentos centrado en la
+// imagen, y la base guardada en disco con la construida. Devuelve la diferencia máxima relativa
+// a la magnitud del momento (o a 1e-3); infinito si la base leída no es idéntica.
+double validateZernikeLote(const vector<Mat> &binarias, int lado, int orden) {
+    const string carpeta = fs::temp_directory_path().string();
+    const string ruta = carpeta + "/zernike_" + to_string(lado) + "_" + to_string(orden) + ".base";
+    fs::remove(ruta);
+    auto base = zernike::obtenerBase(lado, orden, carpeta);
+    zernike::Base leida;
+    if (!leida.cargar(ruta, lado, orden) || norm(leida.matriz, base->matriz, NORM_INF) != 0) {
+        return numeric_limits<double>::infinity();
+    }
+    Mat lote = zernike::momentosLote(binarias, *base);
+    double maxDiff = 0.0;
+    for (size_t i = 0; i < binarias.size(); i++) {
+        vector<double> r = zernike::momentos(binarias[i], orden, lado / 2.0, false, zernike::Centro::Imagen);
+        for (size_t j = 0; j < r.size(); j++) {
+            maxDiff = max(maxDiff, abs(lote.at<double>(static_cast<int>(i), static_cast<int>(j)) - r[j]) / max(abs(r[j]), 1e-3));
+        }
+    }
+    return maxDiff;
+}
+
+// Referencias sintéticas para el k-NN: los vectores de 'base' repetidos con ruido gaussiano
+vector<pair<string, vector<double>>> syntheticReferences(const vector<vector<double>> &base, size_t n) {
+    RNG rng(4321);
+    vector<pair<string, vector<double>>> refs;
+    refs.reserve(n);
+    for (size_t i = 0; i < n && !base.empty(); i++) {
+        vector<double> v = base[i % base.size()];
+        for (double &x : v) x += rng.gaussian(0.05);
+        refs.push_back({to_string(i % 3), v});
+    }
+    return refs;
+}
+
+// Función para comparar el VP-tree con la búsqueda exhaustiva (k = 1 y k = 5). Devuelve el
+// número de consultas con algún vecino distinto.
+int validateKNN(const knn::IndiceKNN &indice, const vector<vector<float>> &consultas) {
+    int mismatches = 0;
+    for (const auto &q : consultas) {
+        for (int k : {1, 5}) {
+            vector<knn::Vecino> a = indice.buscar(q.data(), k), b = indice.buscarFuerzaBruta(q.data(), k);
+            bool same = a.size() == b.size();
+            for (size_t i = 0; same && i < a.size(); i++) {
+                same = a[i].indice == b[i].indice && a[i].distancia == b[i].distancia;
+            }
+            mismatches += !same;
+        }
+    }
+    return mismatches;
+}
+
+// Función para comparar un conjunto binario con las filas de las que se escribió (valores
+// redondeados a float32). Devuelve el número de filas distintas.
+int validateDataset(const dataset::DatasetMapeado &binario, const vector<pair<string, vector<double>>> &filas) {
+    if (binario.filas() != filas.size()) return static_cast<int>(max(binario.filas(), filas.size()));
+    int mismatches = 0;
+    vector<pair<string, vector<double>>> pares = binario.aPares();
+    for (size_t i = 0; i < filas.size(); i++) {
+        bool same = pares[i].first == filas[i].first && pares[i].second.size() == filas[i].second.size();
+        for (size_t d = 0; same && d < filas[i].second.size(); d++) {
+            same = pares[i].second[d] == static_cast<float>(filas[i].second[d]);
+        }
+        mismatches += !same;
+    }
+    return mismatches;
+}
+
+// Función para comparar el almacén de centroides con la media y la varianza en dos pasadas. La
+// mitad de las muestras se agrega, se guarda y se relee antes de agregar el resto (y las
+// repetidas), como en ejecuciones sucesivas de Principal; antes de releer se simula una ejecución
+// interrumpida que guardó el registro de imágenes pero no el almacén. Devuelve la diferencia
+// relativa máxima.
+double validateCentroides(const vector<pair<string, vector<double>>> &filas) {
+    const string ruta = (fs::temp_directory_path() / "bench_centroides.csv").string();
+    const string rutaRegistro = centroides::RegistroImagenes::rutaPara(ruta);
+    fs::remove(ruta);
+    fs::remove(rutaRegistro);
+    centroides::Almacen almacen;
+    centroides::RegistroImagenes registro;
+    almacen.cargar(ruta);
+    registro.cargar(rutaRegistro, almacen.numMuestras());
+    const size_t mitad = filas.size() / 2;
+    bool registroValido = true;
+    for (size_t i = 0; i < filas.size(); i++) {
+        if (i == mitad) {
+            registroValido = registro.guardar(rutaRegistro) && almacen.guardar(ruta);
+            // Ejecución interrumpida: la clave de la muestra 'mitad' llega al registro, no al almacén
+            registro.anotar(to_string(i));
+            registro.guardar(rutaRegistro);
+            almacen = centroides::Almacen();
+            almacen.cargar(ruta);
+            registroValido = registroValido && registro.cargar(rutaRegistro, almacen.numMuestras()) &&
+                             (i == 0 || registro.incorporada("0")) && !registro.incorporada(to_string(i));
+        }
+        const string clave = to_string(i);
+        if (registro.incorporada(clave)) continue;
+        if (almacen.agregar(filas[i].first, filas[i].second)) registro.anotar(clave);
+    }
+    // El registro reescrito tras la interrupción cubre exactamente las muestras del almacén
+    registroValido = registroValido && registro.guardar(rutaRegistro) && almacen.guardar(ruta) &&
+                     registro.cargar(rutaRegistro, almacen.numMuestras()) &&
+                     registro.numImagenes() == filas.size();
+    // Un almacén de otro descriptor no debe aceptar el archivo
+    centroides::Almacen otro("contorno");
+    const bool otroRechazado = !otro.cargar(ruta) && otro.numMuestras() == 0;
+    fs::remove(ruta);
+    fs::remove(rutaRegistro);
+    if (!otroRechazado || !registroValido) return DBL_MAX;
+
+    map<string, vector<const vector<double> *>> porClase;
+    for (const auto &fila : filas) porClase[fila.first].push_back(&fila.second);
+    if (almacen.numClases() != porClase.size()) return DBL_MAX;
+    double maxDiff = 0.0;
+    for (const auto &[clase, muestras] : porClase) {
+        const centroides::Estadistica *e = almacen.clase(clase);
+        if (e == nullptr || e->n != static_cast<long long>(muestras.size())) return DBL_MAX;
+        const vector<double> varianza = e->varianza();
+        for (size_t d = 0; d < muestras[0]->size(); d++) {
+            double media = 0.0, m2 = 0.0;
+            for (const auto *m : muestras) media += (*m)[d];
+            media /= muestras.size();
+            for (const auto *m : muestras) m2 += ((*m)[d] - media) * ((*m)[d] - media);
+            const double var = muestras.size() > 1 ? m2 / (muestras.size() - 1) : 0.0;
+            maxDiff = max(maxDiff, abs(e->media[d] - media) / max(abs(media), 1e-12));
+            maxDiff = max(maxDiff, abs(varianza[d] - var) / max(var, 1e-12));
+        }
+    }
+    return maxDiff;
+}
+
+// Función para leer un archivo completo en memoria
+string readFile(const string &path) {
+    ifstream in(path, ios::binary);
+    return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+// Clasificación original de la librería nativa: interpreta el CSV y normaliza cada referencia
+// en cada llamada, con distancias en double
+string clasificarCSV(const string &contenido, const vector<double> &consulta) {
+    string mejorClase = "Desconocido";
+    double menorDistancia = DBL_MAX;
+    for (const auto &[clase, vec] : momentos::parsearMomentosCSV(contenido)) {
+        double distancia = momentos::calcularDistancia(consulta, momentos::normalizar(vec));
+        if (distancia < menorDistancia) {
+            menorDistancia = distancia;
+            mejorClase = clase;
+        }
+    }
+    return mejorClase;
+}
+
+// Función para comparar ModeloReferencias con la clasificación original. Devuelve el número de
+// consultas con distinta clase.
+int validateModelo(const string &contenido, const vector<vector<double>> &consultas) {
+    momentos::ModeloReferencias modelo = momentos::ModeloReferencias::desdeCSV(contenido);
+    int mismatches = 0;
+    for (const auto &q : consultas) {
+        mismatches += modelo.clasificar(q).clase != clasificarCSV(contenido, q);
+    }
+    return mismatches;
+}
+
+int main(int argc, char **argv) {
+    const String keys =
+        "{help h   |       | Muestra esta ayuda }"
+        "{runs     | 10    | Ejecuciones medidas por caso }"
+        "{warmup   | 2     | Ejecuciones de calentamiento por caso }"
+        "{max      | 64    | Máximo de imágenes por conjunto de entrada }"
+        "{filter   |       | Solo ejecuta los casos cuyo nombre contiene este texto }"
+        "{json     |       | Archivo JSON donde guardar los resultados }"
+        "{baseline |       | Archivo JSON de referencia para detectar regresiones }"
+        "{validate |       | Solo ejecuta las validaciones, sin medir tiempos (make check) }"
+        "{tolerance| 0.10  | Empeoramiento relativo de la mediana que se considera regresión }"
+        "{hog_tolerance| 1e-5 | Diferencia máxima admitida entre LogoHOG y cv::HOGDescriptor }"
+        "{hu_tolerance| 1e-6 | Diferencia relativa máxima admitida entre momentosHuFigura y OpenCV }"
+        "{zernike_tolerance| 1e-8 | Diferencia relativa máxima admitida entre zernike::momentos y la referencia }"
+        "{lote_tolerance| 1e-3 | Diferencia relativa máxima admitida entre momentosLote (float32) y zernike::momentos }"
+        "{proj_tolerance| 1e-4 | Diferencia relativa máxima admitida en la proyección HOG (lotes, plegado y archivo) }"
+        "{proj_dims| 256  | Dimensiones de las proyecciones HOG de los casos proyeccion/ }"
+        "{figures  | ../all-images | Carpeta con las figuras (círculos, cuadrados, triángulos) }"
+        "{logos    | ../Parte2_HOG/images | Carpeta con las imágenes de logos }"
+        "{csv      | ../preparacion/momentos_hu.csv | CSV de momentos de referencia }"
+        "{modelo   | ../momentos/app/src/main/assets/momentos.csv | CSV de referencias de la librería nativa }"
+        "{knn      | 100000 | Referencias sintéticas del mayor conjunto de los casos knn/ }"
+        "{traza    | traza.json | Archivo de trazas por etapa (solo si se compila con TRAZA=1) }";
+    CommandLineParser parser(argc, argv, keys);
+    parser.about("Micro-benchmarks de extracción de características y clasificación");
+    if (parser.has("help")) {
+        parser.printMessage();
+        return 0;
+    }
+
+    const int runs = max(1, parser.get<int>("runs"));
+    const int warmup = max(0, parser.get<int>("warmup"));
+    const size_t maxImages = static_cast<size_t>(max(1, parser.get<int>("max")));
+    const string filter = parser.get<string>("filter");
+
+    vector<Mat> figures = loadImages(parser.get<string>("figures"), IMREAD_COLOR, maxImages);
+    vector<Mat> logos = loadImages(parser.get<string>("logos"), IMREAD_GRAYSCALE, maxImages);
+    auto references = leerMomentosDesdeCSV(parser.get<string>("csv"));
+    cout << "Entradas: " << figures.size() << " figuras, " << logos.size() << " logos, "
+         << references.size() << " referencias" << endl;
+
+    // Consultas para los clasificadores por distancia, calculadas una sola vez
+    vector<vector<double>> queries;
+    for (const auto &img : figures) {
+        queries.push_back(normalizar(calcularMomentosHu(preprocesarImagen(img))));
+    }
+
+    // Validación numérica del HOG especializado contra OpenCV
+    bool hogValid = true;
+    if (!logos.empty()) {
+        double hogDiff = validateFixedHOG(logos);
+        hogValid = hogDiff <= parser.get<double>("hog_tolerance");
+        cout << "LogoHOG vs cv::HOGDescriptor: diferencia máxima " << hogDiff
+             << (hogValid ? " (dentro de la tolerancia)" : " (FUERA DE TOLERANCIA)") << endl;
+    }
+
+    // Proyecciones de los descriptores HOG de los logos (PCA y aleatoria dispersa)
+    Mat logoDescriptors;
+    HOGProjection logoPCA, logoRandom;
+    bool projectionValid = true;
+    if (logos.size() > 1) {
+        HOGBatchExtractor::computeBatchParallel(logos, logoDescriptors);
+        const int dims = max(1, parser.get<int>("proj_dims"));
+        logoPCA = HOGProjection::fitPCA(logoDescriptors, dims);
+        logoRandom = HOGProjection::sparseRandom(logoDescriptors.cols, dims);
+        const double projectionDiff =
+            max(validateProjection(logoPCA, logoDescriptors), validateProjection(logoRandom, logoDescriptors));
+        projectionValid = projectionDiff <= parser.get<double>("proj_tolerance");
+        cout << "Proyección HOG (PCA " << logoPCA.outputSize() << ", aleatoria " << logoRandom.outputSize()
+             << "): diferencia relativa máxima " << projectionDiff
+             << (projectionValid ? " (dentro de la tolerancia)" : " (FUERA DE TOLERANCIA)") << endl;
+    }
+
+    // Entrenamiento por fragmentos: el modelo exportado debe predecir igual al recargarlo
+    const int streamingMismatches = validateStreamingSVM();
+    cout << "StreamingSVM exportado vs cv::ml::SVM y LinearSVM: " << streamingMismatches << " discrepancias" << endl;
+
+    // Validación de los momentos por tramos contra la cadena de OpenCV
+    bool huValid = true;
+    if (!figures.empty()) {
+        double huDiff = validateMomentosFigura(figures);
+        huValid = huDiff <= parser.get<double>("hu_tolerance");
+        cout << "momentosHuFigura vs cv::moments: diferencia relativa máxima " << huDiff
+             << (huValid ? " (dentro de la tolerancia)" : " (FUERA DE TOLERANCIA)") << endl;
+    }
+
+    // Validación de la umbralización directa de bitmaps (RGBA_8888 y RGB_565) con buffers sintéticos
+    vector<Mat> bitmapsRGBA, bitmaps565;
+    makeBitmaps(figures, bitmapsRGBA, bitmaps565);
+    if (!figures.empty()) {
+        double bitmapDiff = validateBitmaps(bitmapsRGBA, bitmaps565);
+        huValid = huValid && bitmapDiff <= parser.get<double>("hu_tolerance");
+        cout << "Bitmaps RGBA/RGB565 vs bitmapToMat + cv::moments: diferencia relativa máxima " << bitmapDiff
+             << (bitmapDiff <= parser.get<double>("hu_tolerance") ? " (dentro de la tolerancia)" : " (FUERA DE TOLERANCIA)")
+             << endl;
+    }
+
+    // Validación de la máscara incremental del dibujo en vivo contra el recálculo completo
+    int incrementalMismatches = 0;
+    if (!figures.empty()) {
+        incrementalMismatches = validateIncremental(figures);
+        cout << "Máscara por zonas vs recálculo completo: " << incrementalMismatches << " diferencias" << endl;
+    }
+
+    // Verificación cruzada de los momentos del polígono del contorno con los de la máscara
+    // rellena: es una aproximación (el polígono pasa por los centros de los píxeles del borde),
+    // así que solo se informa cuántas figuras cambian de clase y la mayor diferencia en H1
+    vector<Mat> figuresX4;
+    for (const auto &img : figures) {
+        Mat grande;
+        resize(img, grande, Size(), 4, 4, INTER_NEAREST);
+        figuresX4.push_back(grande);
+    }
+    {
+        momentos::ModeloReferencias modelo = momentos::ModeloReferencias::desdeCSV(readFile(parser.get<string>("modelo")));
+        int sameClass = 0;
+        double maxH1 = 0.0;
+        for (const auto &img : figures) {
+            vector<double> raster = momentos::momentosHuFigura(img);
+            vector<double> poligono = momentos::momentosHuContorno(img);
+            if (raster[0] > 0) maxH1 = max(maxH1, fabs(poligono[0] - raster[0]) / raster[0]);
+            sameClass += modelo.clasificar(momentos::normalizar(momentos::transformarHu(raster))).clase ==
+                         modelo.clasificar(momentos::normalizar(momentos::transformarHu(poligono))).clase;
+        }
+        if (!figures.empty()) {
+            cout << "momentosHuContorno vs máscara rellena: " << sameClass << " de " << figures.size()
+                 << " figuras con la misma clase, diferencia relativa máxima en H1 " << maxH1 << endl;
+        }
+    }
+
+    // Validación de los momentos de Zernike (Kintner) contra la definición con factoriales, en
+    // orden 4 (el de Principal_V1) y 16
+    vector<Mat> zernikeFigures, zernikeFiguresX4;
+    for (const auto &img : figures) zernikeFigures.push_back(binarizarZernike(img));
+    for (const auto &img : figuresX4) zernikeFiguresX4.push_back(binarizarZernike(img));
+    bool zernikeValid = true;
+    if (!zernikeFigures.empty()) {
+        const double zernikeDiff = max(validateZernike(zernikeFigures, 4), validateZernike(zernikeFigures, 16));
+        zernikeValid = zernikeDiff <= parser.get<double>("zernike_tolerance");
+        cout << "zernike::momentos vs definición con factoriales: diferencia relativa máxima " << zernikeDiff
+             << (zernikeValid ? " (dentro de la tolerancia)" : " (FUERA DE TOLERANCIA)") << endl;
+    }
+
+    // Base precalculada: figuras escaladas a 64 x 64, momentos de orden 20 en lote
+    const int ladoLote = 64, ordenLote = 20;
+    vector<Mat> zernikeFigures64;
+    for (const auto &img : figures) zernikeFigures64.push_back(binarizarZernike(img, ladoLote));
+    if (!zernikeFigures64.empty()) {
+        const double loteDiff = validateZernikeLote(zernikeFigures64, ladoLote, ordenLote);
+        const bool loteValid = loteDiff <= parser.get<double>("lote_tolerance");
+        zernikeValid = zernikeValid && loteValid;
+        cout << "zernike::momentosLote vs zernike::momentos: diferencia relativa máxima " << loteDiff
+             << (loteValid ? " (dentro de la tolerancia)" : " (FUERA DE TOLERANCIA)") << endl;
+    }
+
+    // Validación de la esqueletización contra la versión de ximgproc, a 160 x 160 (la de
+    // calculateHuMoments) y a 640 x 640
+    vector<Mat> esqueletoFigures, esqueletoFiguresX4;
+    for (const auto &img : figures) {
+        esqueletoFigures.push_back(binarizarEsqueleto(img));
+        esqueletoFiguresX4.push_back(binarizarEsqueleto(img, 640));
+    }
+    int esqueletoMismatches = 0;
+    if (!esqueletoFigures.empty()) {
+        esqueletoMismatches = validateEsqueleto(esqueletoFigures) + validateEsqueleto(esqueletoFiguresX4);
+        cout << "esqueleto::zhangSuen vs Zhang-Suen de referencia: " << esqueletoMismatches
+             << " imágenes distintas" << endl;
+    }
+
+    // Validación del modelo de referencias persistente contra la clasificación original: cada
+    // figura y cada referencia del CSV (normalizada) como consulta
+    const string modeloCSV = readFile(parser.get<string>("modelo"));
+    vector<vector<double>> androidQueries;
+    for (const auto &img : figures) {
+        androidQueries.push_back(momentos::normalizar(momentos::transformarHu(momentos::momentosHuFigura(img))));
+    }
+    for (const auto &ref : momentos::parsearMomentosCSV(modeloCSV)) {
+        androidQueries.push_back(momentos::normalizar(ref.second));
+    }
+    int modeloMismatches = 0;
+    if (!modeloCSV.empty()) {
+        modeloMismatches = validateModelo(modeloCSV, androidQueries);
+        cout << "ModeloReferencias vs clasificación original: " << modeloMismatches << " de "
+             << androidQueries.size() << " consultas con distinta clase" << endl;
+    }
+
+    // Índices k-NN sobre referencias sintéticas de tamaño creciente, comprobados contra la
+    // búsqueda exhaustiva; las consultas son las mismas para todos los tamaños
+    vector<knn::IndiceKNN> indices;
+    vector<vector<float>> knnQueries;
+    int knnMismatches = 0;
+    {
+        RNG rng(99);
+        for (size_t i = 0; i < 256 && !androidQueries.empty(); i++) {
+            const vector<double> &q = androidQueries[i % androidQueries.size()];
+            vector<float> v(q.begin(), q.end());
+            for (float &x : v) x += static_cast<float>(rng.gaussian(0.1));
+            knnQueries.push_back(v);
+        }
+        const size_t maxKNN = static_cast<size_t>(max(1, parser.get<int>("knn")));
+        for (size_t n = 1000; !knnQueries.empty(); n *= 10) {
+            indices.emplace_back(syntheticReferences(androidQueries, min(n, maxKNN)), knn::Metrica::Manhattan);
+            knnMismatches += validateKNN(indices.back(), knnQueries);
+            if (n >= maxKNN) break;
+        }
+        if (!indices.empty()) {
+            cout << "k-NN VP-tree vs fuerza bruta: " << knnMismatches << " consultas distintas" << endl;
+        }
+    }
+
+    // Formato binario de momentos: ida y vuelta del conjunto sintético más grande por CSV y .bin
+    const string datasetCSV = (fs::temp_directory_path() / "bench_dataset.csv").string();
+    const string datasetBin = (fs::temp_directory_path() / "bench_dataset.bin").string();
+    int datasetMismatches = 0;
+    size_t datasetRows = 0;
+    if (!androidQueries.empty()) {
+        vector<pair<string, vector<double>>> filas =
+            syntheticReferences(androidQueries, static_cast<size_t>(max(1, parser.get<int>("knn"))));
+        datasetRows = filas.size();
+        dataset::escribirCSV(datasetCSV, filas);
+        dataset::escribirBinario(datasetBin, filas);
+        dataset::DatasetMapeado binario(datasetBin);
+        datasetMismatches = validateDataset(binario, filas);
+        // CSV -> binario -> CSV -> binario debe dar el mismo archivo
+        const string csv2 = datasetCSV + ".2.csv", bin2 = datasetBin + ".2.bin";
+        dataset::escribirCSV(csv2, binario.aPares());
+        dataset::escribirBinario(bin2, dataset::leerCSV(csv2));
+        datasetMismatches += readFile(bin2) != readFile(datasetBin);
+        // Un conjunto con una fila de otra dimensión se rechaza y deja intacto el archivo anterior
+        if (filas.size() > 1) {
+            vector<pair<string, vector<double>>> irregulares = filas;
+            irregulares.back().second.pop_back();
+            datasetMismatches += dataset::escribirBinario(datasetBin, irregulares);
+            datasetMismatches += validateDataset(dataset::DatasetMapeado(datasetBin), filas);
+        }
+        fs::remove(csv2);
+        fs::remove(bin2);
+        cout << "Dataset binario (" << datasetRows << " filas): " << datasetMismatches << " diferencias" << endl;
+    }
+
+    // Centroides por Welford: mismas medias y varianzas que dos pasadas sobre muestras con una
+    // media grande frente a su dispersión (donde E[x²] - E[x]² pierde todas las cifras)
+    bool centroidesValid = true;
+    vector<pair<string, vector<double>>> muestrasCentroides;
+    if (!androidQueries.empty()) {
+        muestrasCentroides = syntheticReferences(androidQueries, 4096);
+        for (auto &muestra : muestrasCentroides) {
+            for (double &v : muestra.second) v += 1e6;
+        }
+        const double centroidesDiff = validateCentroides(muestrasCentroides);
+        centroidesValid = centroidesDiff <= 1e-6;
+        cout << "Centroides Welford vs dos pasadas: diferencia relativa máxima " << centroidesDiff << endl;
+    }
+
+    // Las validaciones se comprueban antes de medir: si alguna falla no se mide nada ni se escribe
+    // --json, para que una línea base nunca salga de un binario que calcula mal
+    const vector<Validation> validations = {
+        {hogValid, "LogoHOG no coincide con cv::HOGDescriptor"},
+        {projectionValid, "La proyección HOG no es coherente entre lotes, plegado y archivo"},
+        {streamingMismatches == 0, "El modelo exportado por StreamingSVM no predice igual al cargarlo"},
+        {knnMismatches == 0, "El VP-tree no coincide con la búsqueda exhaustiva"},
+        {esqueletoMismatches == 0, "esqueleto::zhangSuen no coincide con la esqueletización de referencia"},
+        {zernikeValid, "zernike::momentos no coincide con la definición de referencia"},
+        {centroidesValid, "centroides::Almacen no coincide con la media y la varianza en dos pasadas"},
+        {datasetMismatches == 0, "El dataset binario no reproduce las filas originales"},
+        {incrementalMismatches == 0, "La máscara por zonas no coincide con el recálculo completo"},
+        {modeloMismatches == 0, "ModeloReferencias no coincide con la clasificación original"},
+        {huValid, "momentosHuFigura no coincide con la cadena de OpenCV"},
+    };
+    int failures = 0;
+    for (const auto &v : validations) {
+        if (!v.ok) {
+            cerr << v.failure << endl;
+            failures++;
+        }
+    }
+    if (failures > 0) {
+        cerr << failures << " validación(es) fallida(s): no se miden tiempos" << endl;
+        return 1;
+    }
+    cout << "Validaciones correctas: " << validations.size() << endl;
+    if (parser.has("validate")) {
+        return 0;
+    }
+
+    vector<BenchCase> cases;
+    if (!logos.empty()) {
+        cases.push_back({"hog/computeHOG", logos.size(), [&] {
+            vector<float> descriptors;
+            for (const auto &img : logos) {
+                computeHOG(img, descriptors);
+                sink = sink + descriptors[0];
+            }
+        }});
+        cases.push_back({"hog/computeHOGOpenCV", logos.size(), [&] {
+            vector<float> descriptors;
+            for (const auto &img : logos) {
+                computeHOGOpenCV(img, descriptors);
+                sink = sink + descriptors[0];
+            }
+        }});
+        cases.push_back({"hog/preprocessHOG", logos.size(), [&] {
+            Mat dst;
+            for (const auto &img : logos) {
+                preprocessHOG(img, dst);
+                sink = sink + dst.data[0];
+            }
+        }});
+        if (!logoDescriptors.empty()) {
+            const string dims = to_string(parser.get<int>("proj_dims"));
+            cases.push_back({"proyeccion/ajustePCA/" + dims, logos.size(), [&] {
+                sink = sink + HOGProjection::fitPCA(logoDescriptors, parser.get<int>("proj_dims")).outputSize();
+            }});
+            cases.push_back({"proyeccion/pca/" + dims, logos.size(), [&] {
+                Mat projected;
+                logoPCA.project(logoDescriptors, projected);
+                sink = sink + projected.at<float>(0);
+            }});
+            cases.push_back({"proyeccion/aleatoria/" + dims, logos.size(), [&] {
+                Mat projected;
+                logoRandom.project(logoDescriptors, projected);
+                sink = sink + projected.at<float>(0);
+            }});
+        }
+        cases.push_back({"hog/augmentImage", logos.size(), [&] {
+            vector<Mat> augmented;
+            for (const auto &img : logos) {
+                augmented.clear();
+                augmentImage(img, augmented, 0);
+                sink = sink + augmented.size();
+            }
+        }});
+    }
+    if (!figures.empty()) {
+        cases.push_back({"preparacion/calcularMomentosHu", figures.size(), [&] {
+            for (const auto &img : figures) {
+                sink = sink + calcularMomentosHu(preprocesarImagen(img))[0];
+            }
+        }});
+        cases.push_back({"preparacion/calculateHuMoments", figures.size(), [&] {
+            vector<double> hu;
+            for (const auto &img : figures) {
+                calculateHuMoments(img, hu);
+                sink = sink + hu[0];
+            }
+        }});
+        cases.push_back({"esqueleto/referencia/160", esqueletoFigures.size(), [&] {
+            for (const auto &b : esqueletoFigures) {
+                sink = sink + zhangSuenReferencia(b).rows;
+            }
+        }});
+        for (const auto *conjunto : {&esqueletoFigures, &esqueletoFiguresX4}) {
+            const string lado = to_string(conjunto->front().cols);
+            cases.push_back({"esqueleto/zhangSuen/" + lado, conjunto->size(), [&, conjunto] {
+                Mat salida;
+                for (const auto &b : *conjunto) {
+                    esqueleto::zhangSuen(b, salida);
+                    sink = sink + salida.rows;
+                }
+            }});
+        }
+        cases.push_back({"android/preprocesarImagen", figures.size(), [&] {
+            for (const auto &img : figures) {
+                Mat mask = momentos::preprocesarImagen(img);
+                sink = sink + momentos::transformarHu(momentos::calcularMomentosHu(mask))[0];
+            }
+        }});
+        cases.push_back({"android/momentosHuFigura", figures.size(), [&] {
+            for (const auto &img : figures) {
+                sink = sink + momentos::transformarHu(momentos::momentosHuFigura(img))[0];
+            }
+        }});
+        cases.push_back({"android/momentosHuContorno", figures.size(), [&] {
+            for (const auto &img : figures) {
+                sink = sink + momentos::momentosHuContorno(img)[0];
+            }
+        }});
+        // Mismas figuras en un lienzo 4 veces mayor: el relleno y el recorrido de la máscara crecen
+        // con el área; los momentos del contorno, con el número de vértices
+        cases.push_back({"android/rellenoX4", figuresX4.size(), [&] {
+            for (const auto &img : figuresX4) {
+                sink = sink + momentos::calcularMomentosHu(momentos::preprocesarImagen(img))[0];
+            }
+        }});
+        cases.push_back({"android/contornoX4", figuresX4.size(), [&] {
+            for (const auto &img : figuresX4) {
+                sink = sink + momentos::momentosHuContorno(img)[0];
+            }
+        }});
+        cases.push_back({"android/umbralizarZona", figures.size(), [&] {
+            // Un trazo de 24 x 24 píxeles sobre la máscara ya umbralizada, y la consulta
+            for (const auto &img : figures) {
+                mascara::MascaraBits dibujo;
+                mascara::umbralizarImagen(img.ptr<uchar>(), img.step[0], img.cols, img.rows,
+                                          mascara::FormatoPixel::BGR, 235, dibujo);
+                mascara::umbralizarZona(img.ptr<uchar>(), img.step[0], mascara::FormatoPixel::BGR, 235,
+                                        Rect(img.cols / 2 - 12, img.rows / 2 - 12, 24, 24), dibujo);
+                sink = sink + momentos::momentosHuUmbralizada(dibujo)[0];
+            }
+        }});
+        // Consulta del dibujo en vivo en un lienzo de teléfono: copia de la máscara (lo que se hace
+        // bajo el candado) y cierre, relleno y momentos de todo el lienzo, como consultarDibujo
+        mascara::MascaraBits lienzo;
+        {
+            Mat canvas(1794, 1080, CV_8UC3, Scalar::all(255));
+            const vector<Point> triangulo = {{540, 360}, {160, 1350}, {920, 1350}};
+            polylines(canvas, triangulo, true, Scalar::all(0), 10);
+            mascara::umbralizarImagen(canvas.ptr<uchar>(), canvas.step[0], canvas.cols, canvas.rows,
+                                      mascara::FormatoPixel::BGR, 235, lienzo);
+        }
+        cases.push_back({"android/consultarDibujo/1080x1794", 1, [&, lienzo] {
+            mascara::MascaraBits copia = lienzo;
+            sink = sink + momentos::momentosHuUmbralizada(copia)[0];
+        }});
+        cases.push_back({"android/bitmapToMatRGBA", bitmapsRGBA.size(), [&] {
+            for (const auto &img : bitmapsRGBA) {
+                Mat bgr = img.clone();
+                cvtColor(bgr, bgr, COLOR_RGBA2BGR);
+                sink = sink + momentos::momentosHuFigura(bgr)[0];
+            }
+        }});
+        cases.push_back({"android/bitmapRGBA", bitmapsRGBA.size(), [&] {
+            for (const auto &img : bitmapsRGBA) {
+                sink = sink + momentos::momentosHuFigura(img, mascara::FormatoPixel::RGBA)[0];
+            }
+        }});
+        cases.push_back({"android/bitmapRGB565", bitmaps565.size(), [&] {
+            for (const auto &img : bitmaps565) {
+                sink = sink + momentos::momentosHuFigura(img, mascara::FormatoPixel::RGB565)[0];
+            }
+        }});
+    }
+    if (!modeloCSV.empty() && !androidQueries.empty()) {
+        cases.push_back({"android/clasificarCSV", androidQueries.size(), [&] {
+            for (const auto &q : androidQueries) {
+                sink = sink + clasificarCSV(modeloCSV, q).size();
+            }
+        }});
+        momentos::ModeloReferencias modelo = momentos::ModeloReferencias::desdeCSV(modeloCSV);
+        cases.push_back({"android/modeloReferencias", androidQueries.size(), [&, modelo] {
+            for (const auto &q : androidQueries) {
+                sink = sink + modelo.clasificar(q).distancia;
+            }
+        }});
+    }
+    for (const auto &indice : indices) {
+        const string n = to_string(indice.size());
+        cases.push_back({"knn/vptree/" + n, knnQueries.size(), [&] {
+            for (const auto &q : knnQueries) {
+                sink = sink + indice.buscar(q.data(), 5)[0].distancia;
+            }
+        }});
+        cases.push_back({"knn/fuerzaBruta/" + n, knnQueries.size(), [&] {
+            for (const auto &q : knnQueries) {
+                sink = sink + indice.buscarFuerzaBruta(q.data(), 5)[0].distancia;
+            }
+        }});
+    }
+    if (!zernikeFigures.empty()) {
+        cases.push_back({"zernike/referencia/4", zernikeFigures.size(), [&] {
+            for (const auto &img : zernikeFigures) {
+                sink = sink + zernikeReferencia(img, 4, min(img.cols, img.rows) / 2.0)[0];
+            }
+        }});
+        for (int orden : {4, 20}) {
+            cases.push_back({"zernike/kintner/" + to_string(orden), zernikeFigures.size(), [&, orden] {
+                for (const auto &img : zernikeFigures) {
+                    sink = sink + zernike::momentos(img, orden, min(img.cols, img.rows) / 2.0)[0];
+                }
+            }});
+        }
+        cases.push_back({"zernike/kintnerX4/20", zernikeFiguresX4.size(), [&] {
+            for (const auto &img : zernikeFiguresX4) {
+                sink = sink + zernike::momentos(img, 20, min(img.cols, img.rows) / 2.0)[0];
+            }
+        }});
+        cases.push_back({"zernike/kintner64/20", zernikeFigures64.size(), [&] {
+            for (const auto &img : zernikeFigures64) {
+                sink = sink + zernike::momentos(img, ordenLote, ladoLote / 2.0, true, zernike::Centro::Imagen)[0];
+            }
+        }});
+        auto base = zernike::obtenerBase(ladoLote, ordenLote);
+        cases.push_back({"zernike/lote64/20", zernikeFigures64.size(), [&, base] {
+            sink = sink + zernike::momentosLote(zernikeFigures64, *base).at<double>(0, 0);
+        }});
+    }
+    if (datasetRows > 0) {
+        const string n = to_string(datasetRows);
+        cases.push_back({"dataset/leerCSV/" + n, datasetRows, [&] {
+            sink = sink + leerMomentosDesdeCSV(datasetCSV).size();
+        }});
+        cases.push_back({"dataset/mapear/" + n, datasetRows, [&] {
+            dataset::DatasetMapeado binario(datasetBin);
+            sink = sink + binario.filas();
+        }});
+        cases.push_back({"dataset/indiceCSV/" + n, datasetRows, [&] {
+            sink = sink + knn::IndiceKNN(leerMomentosDesdeCSV(datasetCSV), knn::Metrica::Manhattan).size();
+        }});
+        cases.push_back({"dataset/indiceBinario/" + n, datasetRows, [&] {
+            dataset::DatasetMapeado binario(datasetBin);
+            vector<int> etiquetas(binario.etiquetas(), binario.etiquetas() + binario.filas());
+            sink = sink + knn::IndiceKNN(binario.clases(), move(etiquetas), binario.porFilas(), binario.dimension(),
+                                         knn::Metrica::Manhattan).size();
+        }});
+    }
+    if (!muestrasCentroides.empty()) {
+        cases.push_back({"centroides/agregar", muestrasCentroides.size(), [&] {
+            centroides::Almacen almacen;
+            for (const auto &[clase, muestra] : muestrasCentroides) almacen.agregar(clase, muestra);
+            sink = sink + almacen.clase("0")->media[0];
+        }});
+        cases.push_back({"centroides/mahalanobis", queries.size(), [&] {
+            centroides::Almacen almacen;
+            for (const auto &[clase, muestra] : muestrasCentroides) almacen.agregar(clase, muestra);
+            for (const auto &q : queries) sink = sink + almacen.clasificar(q).size();
+        }});
+    }
+    if (!queries.empty() && !references.empty()) {
+        cases.push_back({"clasificador/manhattan", queries.size(), [&] {
+            for (const auto &q : queries) {
+                double best = DBL_MAX;
+                for (const auto &ref : references) {
+                    best = min(best, calcularDistancia(q, ref.second));
+                }
+                sink = sink + best;
+            }
+        }});
+        cases.push_back({"clasificador/euclidea", queries.size(), [&] {
+            for (const auto &q : queries) {
+                double best = DBL_MAX;
+                for (const auto &ref : references) {
+                    best = min(best, distanciaEuclidea(q, ref.second));
+                }
+                sink = sink + best;
+            }
+        }});
+    }
+
+    vector<BenchResult> results;
+    cout << left << setw(32) << "caso" << right << setw(12) << "mediana ms" << setw(12) << "mín ms"
+         << setw(12) << "media ms" << setw(14) << "elementos/s" << endl;
+    for (const auto &bench : cases) {
+        if (!filter.empty() && bench.name.find(filter) == string::npos) continue;
+        BenchResult r = measure(bench, warmup, runs);
+        results.push_back(r);
+        double rate = r.median > 0 ? r.items / (r.median / 1000.0) : 0.0;
+        cout << left << setw(32) << r.name << right << fixed << setprecision(3) << setw(12) << r.median
+             << setw(12) << r.min << setw(12) << r.mean << setprecision(1) << setw(14) << rate << endl;
+        cout.unsetf(ios::fixed);
+        cout << setprecision(6);
+    }
+
+    TRAZA_VOLCAR(parser.get<string>("traza"));
+
+    if (parser.has("json")) {
+        saveResults(parser.get<string>("json"), results);
+    }
+    if (parser.has("baseline")) {
+        int regressions = compareBaseline(parser.get<string>("baseline"), results, parser.get<double>("tolerance"));
+        if (regressions > 0) {
+            cerr << regressions << " caso(s) con regresión" << endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,289 @@
+#pragma once
+
+// Centroides por clase con media y varianza acumuladas (algoritmo de Welford).
+//
+//   centroides::Almacen almacen("hu");                    // tipo de descriptor de las muestras
+//   almacen.cargar("centroides_hu.csv");                  // si no existe, empieza vacío
+//   centroides::RegistroImagenes registro;                // imágenes ya contadas (opcional)
+//   const std::string claves = centroides::RegistroImagenes::rutaPara("centroides_hu.csv");
+//   registro.cargar(claves, almacen.numMuestras());
+//   if (!registro.incorporada("circle/c1.png") && almacen.agregar("Circulo", momentos)) {
+//       registro.anotar("circle/c1.png");
+//   }
+//   if (registro.guardar(claves)) almacen.guardar("centroides_hu.csv");  // registro primero
+//   std::string clase = almacen.clasificar(consulta);      // Mahalanobis diagonal
+//
+// Por clase solo se guardan el número de muestras, la media y la suma de cuadrados de las
+// diferencias (M2): el almacén ocupa O(clases) en memoria y en disco, agregar una imagen cuesta
+// O(dimensión) y nunca hace falta volver a leer las anteriores. Welford actualiza la media antes
+// de acumular M2, así que no pierde precisión como la fórmula E[x²] - E[x]² cuando la varianza
+// es pequeña frente a la media. El archivo se escribe entero (una línea por clase) en un
+// temporal que reemplaza al anterior, así que una ejecución interrumpida no deja registros a medias.
+//
+// La cabecera registra qué descriptor produjo las estadísticas (por ejemplo "hu" o "contorno"):
+// un archivo de otro tipo se rechaza al cargarlo en lugar de mezclar sus muestras con las nuevas.
+//
+// Formato (texto, doubles con 17 cifras para releerlos sin pérdidas):
+//   centroides,<dimensión>,<descriptor>
+//   clase,<nombre>,<n>,<media 1..d>,<M2 1..d>
+//
+// Las estadísticas no recuerdan qué imágenes las formaron, así que para no contar dos veces una
+// imagen entre ejecuciones hace falta una clave por imagen (clase/archivo). Esas claves son
+// O(imágenes) y por eso van aparte, en RegistroImagenes: un archivo de texto que solo crece (una
+// clave por línea) y al que cada ejecución añade únicamente las imágenes nuevas. Quien no
+// necesita evitar duplicados (el benchmark, la aplicación) usa solo el almacén.
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <set>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace centroides {
+
+// Media y M2 de una clase
+struct Estadistica {
+    long long n = 0;
+    std::vector<double> media, m2;
+
+    // Función para incorporar una muestra (actualización de Welford)
+    void agregar(const std::vector<double> &muestra) {
+        if (n == 0) {
+            media.assign(muestra.size(), 0.0);
+            m2.assign(muestra.size(), 0.0);
+        }
+        n++;
+        for (size_t i = 0; i < muestra.size(); i++) {
+            const double delta = muestra[i] - media[i];
+            media[i] += delta / n;
+            m2[i] += delta * (muestra[i] - media[i]);
+        }
+    }
+
+    // Varianza muestral por componente (0 con menos de dos muestras)
+    std::vector<double> varianza() const {
+        std::vector<double> v(m2.size(), 0.0);
+        if (n < 2) return v;
+        for (size_t i = 0; i < m2.size(); i++) v[i] = m2[i] / (n - 1);
+        return v;
+    }
+};
+
+class Almacen {
+public:
+    explicit Almacen(std::string descriptor = "hu") : nombreDescriptor(std::move(descriptor)) {}
+
+    // Función para leer un almacén guardado. Si el archivo no existe el almacén queda vacío y
+    // retorna true; retorna false si existe pero está dañado o es de otro descriptor.
+    bool cargar(const std::string &ruta) {
+        estadisticas.clear();
+        dim = 0;
+        std::ifstream in(ruta);
+        if (!in.is_open()) return true;
+        std::string linea;
+        while (std::getline(in, linea)) {
+            if (linea.empty()) continue;
+            std::stringstream ss(linea);
+            std::string tipo, campo;
+            std::getline(ss, tipo, ',');
+            try {
+                if (tipo == "centroides") {
+                    std::getline(ss, campo, ',');
+                    dim = std::stoi(campo);
+                    if (!std::getline(ss, campo) || campo != nombreDescriptor) {
+                        dim = 0;
+                        return false;
+                    }
+                } else if (tipo == "clase") {
+                    std::pair<std::string, Estadistica> registro;
+                    std::getline(ss, registro.first, ',');
+                    std::getline(ss, campo, ',');
+                    registro.second.n = std::stoll(campo);
+                    registro.second.media.resize(dim);
+                    registro.second.m2.resize(dim);
+                    for (int i = 0; i < 2 * dim; i++) {
+                        if (!std::getline(ss, campo, ',')) return false;
+                        (i < dim ? registro.second.media[i] : registro.second.m2[i - dim]) = std::stod(campo);
+                    }
+                    estadisticas.push_back(std::move(registro));
+                } else {
+                    return false;
+                }
+            } catch (...) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Función para guardar el almacén reemplazando el archivo anterior de una vez
+    bool guardar(const std::string &ruta) const {
+        const std::string temporal = ruta + ".tmp";
+        {
+            std::ofstream out(temporal);
+            if (!out.is_open()) return false;
+            out.precision(17);
+            out << "centroides," << dim << "," << nombreDescriptor << "\n";
+            for (const auto &[clase, e] : estadisticas) {
+                out << "clase," << clase << "," << e.n;
+                for (double v : e.media) out << "," << v;
+                for (double v : e.m2) out << "," << v;
+                out << "\n";
+            }
+            if (!out) return false;
+        }
+        return std::rename(temporal.c_str(), ruta.c_str()) == 0;
+    }
+
+    // Función para agregar una muestra a su clase. Retorna false (sin agregarla) si la dimensión
+    // no coincide con la de las muestras anteriores.
+    bool agregar(const std::string &clase, const std::vector<double> &muestra) {
+        if (muestra.empty() || (dim != 0 && static_cast<int>(muestra.size()) != dim)) return false;
+        dim = static_cast<int>(muestra.size());
+        buscarOCrear(clase).agregar(muestra);
+        return true;
+    }
+
+    // Función para obtener la estadística de una clase (nullptr si no existe)
+    const Estadistica *clase(const std::string &nombre) const {
+        for (const auto &registro : estadisticas) {
+            if (registro.first == nombre) return &registro.second;
+        }
+        return nullptr;
+    }
+
+    // Centroides como pares (clase, media), en el orden en que aparecieron las clases
+    std::vector<std::pair<std::string, std::vector<double>>> medias() const {
+        std::vector<std::pair<std::string, std::vector<double>>> pares;
+        for (const auto &[nombre, e] : estadisticas) pares.push_back({nombre, e.media});
+        return pares;
+    }
+
+    // Distancia de Mahalanobis con covarianza diagonal: sqrt(sum (x - media)² / varianza). La
+    // varianza se acota por debajo con 'minimaVarianza' para las componentes constantes y las
+    // clases con una sola muestra.
+    static double mahalanobis(const Estadistica &e, const std::vector<double> &x, double minimaVarianza = 1e-12) {
+        const std::vector<double> v = e.varianza();
+        double suma = 0.0;
+        for (size_t i = 0; i < x.size() && i < e.media.size(); i++) {
+            const double d = x[i] - e.media[i];
+            suma += d * d / std::max(v[i], minimaVarianza);
+        }
+        return std::sqrt(suma);
+    }
+
+    // Función para clasificar por la menor distancia de Mahalanobis diagonal a cada centroide
+    std::string clasificar(const std::vector<double> &x, double minimaVarianza = 1e-12) const {
+        std::string mejor = "Desconocido";
+        double menor = std::numeric_limits<double>::infinity();
+        for (const auto &[nombre, e] : estadisticas) {
+            const double d = mahalanobis(e, x, minimaVarianza);
+            if (d < menor) {
+                menor = d;
+                mejor = nombre;
+            }
+        }
+        return mejor;
+    }
+
+    const std::string &descriptor() const { return nombreDescriptor; }
+    int dimension() const { return dim; }
+    size_t numClases() const { return estadisticas.size(); }
+    long long numMuestras() const {
+        long long total = 0;
+        for (const auto &registro : estadisticas) total += registro.second.n;
+        return total;
+    }
+
+private:
+    Estadistica &buscarOCrear(const std::string &nombre) {
+        for (auto &registro : estadisticas) {
+            if (registro.first == nombre) return registro.second;
+        }
+        estadisticas.push_back({nombre, Estadistica{}});
+        return estadisticas.back().second;
+    }
+
+    // Pocas clases: un vector conserva el orden de aparición y la búsqueda lineal basta
+    std::vector<std::pair<std::string, Estadistica>> estadisticas;
+    std::string nombreDescriptor;
+    int dim = 0;
+};
+
+// Claves de las imágenes que ya forman parte de un almacén, en un archivo aparte que solo crece.
+// Se guarda antes que el almacén: si la ejecución se interrumpe entre los dos, el registro tiene
+// claves de más, y al cargarlo solo cuentan las 'total' primeras (las que cubren las
+// estadísticas guardadas). Las sobrantes se descartan al guardar reescribiendo el archivo.
+class RegistroImagenes {
+public:
+    // Ruta del registro que acompaña a un almacén
+    static std::string rutaPara(const std::string &rutaAlmacen) { return rutaAlmacen + ".imagenes"; }
+
+    // Función para leer las claves que cubren las 'total' muestras del almacén. Retorna false si
+    // el registro tiene menos (falta o se borró): entonces el almacén debe empezar de cero.
+    bool cargar(const std::string &ruta, long long total) {
+        claves.clear();
+        pendientes.clear();
+        reescribir = false;
+        std::ifstream in(ruta);
+        std::string clave;
+        long long leidas = 0;
+        while (leidas < total && std::getline(in, clave)) {
+            claves.insert(clave);
+            leidas++;
+        }
+        reescribir = leidas == total && static_cast<bool>(std::getline(in, clave));
+        return leidas == total;
+    }
+
+    // Función para saber si una imagen ya forma parte de las estadísticas
+    bool incorporada(const std::string &clave) const { return claves.count(clave) > 0; }
+
+    // Función para registrar una imagen recién agregada al almacén
+    void anotar(const std::string &clave) {
+        if (claves.insert(clave).second) pendientes.push_back(clave);
+    }
+
+    // Función para añadir al archivo las claves nuevas (O(imágenes nuevas)). Solo si quedaron
+    // claves de una ejecución interrumpida, o si el almacén empezó de cero, se reescribe entero.
+    bool guardar(const std::string &ruta) {
+        if (reescribir) {
+            const std::string temporal = ruta + ".tmp";
+            {
+                std::ofstream out(temporal);
+                if (!out.is_open()) return false;
+                for (const auto &clave : claves) out << clave << "\n";
+                if (!out) return false;
+            }
+            if (std::rename(temporal.c_str(), ruta.c_str()) != 0) return false;
+        } else if (!pendientes.empty()) {
+            std::ofstream out(ruta, std::ios::app);
+            if (!out.is_open()) return false;
+            for (const auto &clave : pendientes) out << clave << "\n";
+            if (!out.flush()) return false;
+        }
+        pendientes.clear();
+        reescribir = false;
+        return true;
+    }
+
+    // Función para vaciar el registro cuando el almacén se vuelve a calcular desde cero
+    void reiniciar() {
+        claves.clear();
+        pendientes.clear();
+        reescribir = true;
+    }
+
+    size_t numImagenes() const { return claves.size(); }
+
+private:
+    std::set<std::string> claves;
+    std::vector<std::string> pendientes;
+    bool reescribir = false;
+};
+
+} // namespace centroides
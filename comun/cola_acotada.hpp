@@ -0,0 +1,59 @@
+#pragma once
+
+// Cola acotada para etapas productor/consumidor. 'poner' espera mientras la cola está llena y
+// 'sacar' mientras está vacía, así que la memoria de los elementos pendientes nunca supera
+// 'capacidad'. Cuando los productores terminan llaman a 'cerrar': los consumidores vacían lo
+// que queda y 'sacar' retorna false.
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+template <typename T>
+class ColaAcotada {
+public:
+    explicit ColaAcotada(size_t capacidad) : capacidad(capacidad > 0 ? capacidad : 1) {}
+
+    ColaAcotada(const ColaAcotada &) = delete;
+    ColaAcotada &operator=(const ColaAcotada &) = delete;
+
+    // Encola un elemento. Retorna false (sin encolarlo) si la cola ya se cerró.
+    bool poner(T valor) {
+        std::unique_lock<std::mutex> lock(mtx);
+        noLlena.wait(lock, [this] { return cerrada || elementos.size() < capacidad; });
+        if (cerrada) return false;
+        elementos.push_back(std::move(valor));
+        noVacia.notify_one();
+        return true;
+    }
+
+    // Saca el elemento más antiguo. Retorna false si la cola está cerrada y vacía.
+    bool sacar(T &valor) {
+        std::unique_lock<std::mutex> lock(mtx);
+        noVacia.wait(lock, [this] { return cerrada || !elementos.empty(); });
+        if (elementos.empty()) return false;
+        valor = std::move(elementos.front());
+        elementos.pop_front();
+        noLlena.notify_one();
+        return true;
+    }
+
+    // No se aceptan más elementos; los pendientes se pueden seguir sacando
+    void cerrar() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            cerrada = true;
+        }
+        noLlena.notify_all();
+        noVacia.notify_all();
+    }
+
+private:
+    size_t capacidad;
+    std::mutex mtx;
+    std::condition_variable noLlena, noVacia;
+    std::deque<T> elementos;
+    bool cerrada = false;
+};
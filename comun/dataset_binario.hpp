@@ -0,0 +1,333 @@
+#pragma once
+
+// Formato binario de conjuntos de momentos (referencias, datasets, centroides), pensado para
+// cargarse con un único mmap en lugar de interpretar un CSV línea a línea.
+//
+// Disposición del archivo (little-endian; cada sección empieza en un múltiplo de 64 bytes):
+//
+//   Cabecera        magia "MOMBIN01", versión, dimensión, filas, número de clases y la posición
+//                   de cada sección
+//   Diccionario     numClases + 1 posiciones (uint32) dentro del bloque de texto que sigue y
+//                   los nombres de clase concatenados, sin terminador
+//   Etiquetas       int32 por fila: índice de su clase en el diccionario
+//   Datos           float32 por columnas: los 'filas' valores de la característica 0, luego los
+//                   de la 1, etc.
+//
+// Abrir un archivo solo mapea y valida la cabecera: no hay copia ni una reserva de memoria por
+// fila. Los datos quedan en la caché de páginas del sistema y se comparten entre procesos.
+// Los valores se guardan en float32, así que al convertir desde CSV se pierde la precisión
+// por encima de ~7 cifras significativas.
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace dataset {
+
+constexpr char magia[8] = {'M', 'O', 'M', 'B', 'I', 'N', '0', '1'};
+constexpr uint32_t version = 1;
+constexpr uint64_t alineacion = 64;
+
+struct Cabecera {
+    char magia[8];
+    uint32_t version;
+    uint32_t dimension;
+    uint64_t filas;
+    uint32_t numClases;
+    uint32_t reservado;
+    uint64_t posDiccionario;
+    uint64_t posEtiquetas;
+    uint64_t posDatos;
+    uint64_t tamano;        // Tamaño total del archivo, para detectar archivos truncados
+};
+
+inline uint64_t alinear(uint64_t pos) {
+    return (pos + alineacion - 1) / alineacion * alineacion;
+}
+
+// Función para escribir un conjunto (clase, vector) en formato binario. Todas las filas deben
+// tener la misma dimensión que la primera: si alguna no la tiene, se informa cuántas y no se
+// escribe nada. El archivo se escribe en un temporal que luego se renombra, así que un lector
+// que lo tenga mapeado conserva la versión anterior y una escritura interrumpida no deja un
+// archivo truncado con una cabecera válida.
+inline bool escribirBinario(const std::string &ruta, const std::vector<std::pair<std::string, std::vector<double>>> &filas) {
+    const uint32_t dimension = filas.empty() ? 0 : static_cast<uint32_t>(filas[0].second.size());
+    std::vector<std::string> clases;
+    std::map<std::string, int32_t> idClase;
+    std::vector<int32_t> etiquetas;
+    std::vector<size_t> validas;
+    size_t descartadas = 0;
+    for (size_t i = 0; i < filas.size(); i++) {
+        if (filas[i].second.size() != dimension) {
+            if (descartadas++ == 0) {
+                std::cerr << "Fila " << i << ": dimensión " << filas[i].second.size() << " en lugar de " << dimension
+                          << std::endl;
+            }
+            continue;
+        }
+        auto it = idClase.emplace(filas[i].first, static_cast<int32_t>(clases.size())).first;
+        if (it->second == static_cast<int32_t>(clases.size())) clases.push_back(filas[i].first);
+        etiquetas.push_back(it->second);
+        validas.push_back(i);
+    }
+    if (descartadas > 0) {
+        std::cerr << descartadas << " de " << filas.size() << " filas con otra dimensión: no se escribe " << ruta
+                  << std::endl;
+        return false;
+    }
+
+    // Diccionario: posiciones y texto
+    std::vector<uint32_t> posiciones(1, 0);
+    std::string texto;
+    for (const auto &c : clases) {
+        texto += c;
+        posiciones.push_back(static_cast<uint32_t>(texto.size()));
+    }
+
+    Cabecera cab = {};
+    std::memcpy(cab.magia, magia, sizeof(magia));
+    cab.version = version;
+    cab.dimension = dimension;
+    cab.filas = validas.size();
+    cab.numClases = static_cast<uint32_t>(clases.size());
+    cab.posDiccionario = alinear(sizeof(Cabecera));
+    cab.posEtiquetas = alinear(cab.posDiccionario + posiciones.size() * sizeof(uint32_t) + texto.size());
+    cab.posDatos = alinear(cab.posEtiquetas + cab.filas * sizeof(int32_t));
+    cab.tamano = cab.posDatos + cab.filas * dimension * sizeof(float);
+
+    std::vector<char> buf(cab.tamano, 0);
+    std::memcpy(buf.data(), &cab, sizeof(cab));
+    std::memcpy(buf.data() + cab.posDiccionario, posiciones.data(), posiciones.size() * sizeof(uint32_t));
+    std::memcpy(buf.data() + cab.posDiccionario + posiciones.size() * sizeof(uint32_t), texto.data(), texto.size());
+    std::memcpy(buf.data() + cab.posEtiquetas, etiquetas.data(), etiquetas.size() * sizeof(int32_t));
+    float *datos = reinterpret_cast<float *>(buf.data() + cab.posDatos);
+    for (uint32_t d = 0; d < dimension; d++) {
+        for (size_t i = 0; i < validas.size(); i++) {
+            datos[d * validas.size() + i] = static_cast<float>(filas[validas[i]].second[d]);
+        }
+    }
+
+    const std::string temporal = ruta + ".tmp";
+    {
+        std::ofstream out(temporal, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            std::cerr << "No se pudo crear el archivo " << temporal << std::endl;
+            return false;
+        }
+        out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+        out.close();
+        if (!out) {
+            std::cerr << "No se pudo escribir el archivo " << temporal << std::endl;
+            std::remove(temporal.c_str());
+            return false;
+        }
+    }
+    if (std::rename(temporal.c_str(), ruta.c_str()) != 0) {
+        std::cerr << "No se pudo reemplazar el archivo " << ruta << std::endl;
+        std::remove(temporal.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Conjunto binario mapeado en memoria (solo lectura). Se puede mover pero no copiar.
+class DatasetMapeado {
+public:
+    DatasetMapeado() = default;
+    explicit DatasetMapeado(const std::string &ruta) { abrir(ruta); }
+    ~DatasetMapeado() { cerrar(); }
+
+    DatasetMapeado(const DatasetMapeado &) = delete;
+    DatasetMapeado &operator=(const DatasetMapeado &) = delete;
+    DatasetMapeado(DatasetMapeado &&otro) noexcept { *this = std::move(otro); }
+    DatasetMapeado &operator=(DatasetMapeado &&otro) noexcept {
+        if (this != &otro) {
+            cerrar();
+            base = otro.base;
+            tam = otro.tam;
+            otro.base = nullptr;
+            otro.tam = 0;
+        }
+        return *this;
+    }
+
+    // Mapea el archivo y valida la cabecera. Retorna false (con un mensaje) si no es válido.
+    bool abrir(const std::string &ruta) {
+        cerrar();
+        int fd = ::open(ruta.c_str(), O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "No se pudo abrir el archivo " << ruta << std::endl;
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Cabecera)) {
+            std::cerr << "Archivo binario de momentos no válido: " << ruta << std::endl;
+            ::close(fd);
+            return false;
+        }
+        void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) {
+            std::cerr << "No se pudo mapear el archivo " << ruta << std::endl;
+            return false;
+        }
+        base = static_cast<const char *>(p);
+        tam = static_cast<size_t>(st.st_size);
+        if (!valido()) {
+            std::cerr << "Archivo binario de momentos no válido o de otra versión: " << ruta << std::endl;
+            cerrar();
+            return false;
+        }
+        return true;
+    }
+
+    bool abierto() const { return base != nullptr; }
+    size_t filas() const { return cabecera().filas; }
+    int dimension() const { return static_cast<int>(cabecera().dimension); }
+    int numClases() const { return static_cast<int>(cabecera().numClases); }
+
+    std::string clase(int c) const {
+        const uint32_t *pos = reinterpret_cast<const uint32_t *>(base + cabecera().posDiccionario);
+        const char *texto = reinterpret_cast<const char *>(pos + numClases() + 1);
+        return std::string(texto + pos[c], pos[c + 1] - pos[c]);
+    }
+
+    std::vector<std::string> clases() const {
+        std::vector<std::string> nombres;
+        for (int c = 0; c < numClases(); c++) nombres.push_back(clase(c));
+        return nombres;
+    }
+
+    const int32_t *etiquetas() const { return reinterpret_cast<const int32_t *>(base + cabecera().posEtiquetas); }
+
+    // Los filas() valores de la característica d
+    const float *columna(int d) const {
+        return reinterpret_cast<const float *>(base + cabecera().posDatos) + static_cast<size_t>(d) * filas();
+    }
+
+    // Copia los datos fila a fila (filas() x dimension()) en un único arreglo
+    std::vector<float> porFilas() const {
+        std::vector<float> datos(filas() * dimension());
+        for (int d = 0; d < dimension(); d++) {
+            const float *col = columna(d);
+            for (size_t i = 0; i < filas(); i++) datos[i * dimension() + d] = col[i];
+        }
+        return datos;
+    }
+
+    // Conversión al formato de los lectores de CSV, para el código que aún lo usa
+    std::vector<std::pair<std::string, std::vector<double>>> aPares() const {
+        std::vector<std::string> nombres = clases();
+        std::vector<std::pair<std::string, std::vector<double>>> pares(filas());
+        for (size_t i = 0; i < filas(); i++) {
+            pares[i].first = nombres[etiquetas()[i]];
+            pares[i].second.resize(dimension());
+            for (int d = 0; d < dimension(); d++) pares[i].second[d] = columna(d)[i];
+        }
+        return pares;
+    }
+
+private:
+    const Cabecera &cabecera() const { return *reinterpret_cast<const Cabecera *>(base); }
+
+    bool valido() const {
+        const Cabecera &c = cabecera();
+        if (std::memcmp(c.magia, magia, sizeof(magia)) != 0 || c.version != version || c.tamano != tam) return false;
+        if (c.posDiccionario < sizeof(Cabecera) || c.posEtiquetas < c.posDiccionario || c.posDatos < c.posEtiquetas) {
+            return false;
+        }
+        if (c.posEtiquetas + c.filas * sizeof(int32_t) > c.posDatos) return false;
+        if (c.posDatos + c.filas * c.dimension * sizeof(float) > tam) return false;
+        // El diccionario debe caber antes de las etiquetas y las etiquetas apuntar a clases existentes
+        const uint64_t finPosiciones = c.posDiccionario + (uint64_t(c.numClases) + 1) * sizeof(uint32_t);
+        if (finPosiciones > c.posEtiquetas) return false;
+        const uint32_t *pos = reinterpret_cast<const uint32_t *>(base + c.posDiccionario);
+        if (finPosiciones + pos[c.numClases] > c.posEtiquetas) return false;
+        for (uint32_t i = 0; i < c.numClases; i++) {
+            if (pos[i] > pos[i + 1]) return false;
+        }
+        const int32_t *e = reinterpret_cast<const int32_t *>(base + c.posEtiquetas);
+        for (uint64_t i = 0; i < c.filas; i++) {
+            if (e[i] < 0 || static_cast<uint32_t>(e[i]) >= c.numClases) return false;
+        }
+        return true;
+    }
+
+    void cerrar() {
+        if (base) munmap(const_cast<char *>(base), tam);
+        base = nullptr;
+        tam = 0;
+    }
+
+    const char *base = nullptr;
+    size_t tam = 0;
+};
+
+// Función para saber si una ruta es un conjunto binario (por la extensión .bin)
+inline bool esBinario(const std::string &ruta) {
+    return ruta.size() >= 4 && ruta.compare(ruta.size() - 4, 4, ".bin") == 0;
+}
+
+// Función para leer un CSV de momentos para convertirlo: clase en la primera columna, luego
+// 'ignorar' columnas que no son características (por ejemplo, el nombre de archivo de
+// figureshu.csv) y los valores. Con 'cabecera' se salta la primera línea.
+inline std::vector<std::pair<std::string, std::vector<double>>> leerCSV(const std::string &ruta, bool cabecera = false,
+                                                                       int ignorar = 0) {
+    std::vector<std::pair<std::string, std::vector<double>>> filas;
+    std::ifstream archivo(ruta);
+    if (!archivo.is_open()) {
+        std::cerr << "No se pudo abrir el archivo " << ruta << std::endl;
+        return filas;
+    }
+    std::string linea;
+    if (cabecera) std::getline(archivo, linea);
+    while (std::getline(archivo, linea)) {
+        if (!linea.empty() && linea.back() == '\r') linea.pop_back();
+        if (linea.empty()) continue;
+        std::stringstream ss(linea);
+        std::string clase, token;
+        std::getline(ss, clase, ',');
+        for (int i = 0; i < ignorar; i++) std::getline(ss, token, ',');
+        std::vector<double> valores;
+        while (std::getline(ss, token, ',')) {
+            try {
+                valores.push_back(std::stod(token));
+            } catch (...) {
+                // Ignorar errores de conversión
+            }
+        }
+        filas.push_back({clase, valores});
+    }
+    return filas;
+}
+
+// Función para escribir un conjunto como CSV (clase,v1,...,vN por línea)
+inline bool escribirCSV(const std::string &ruta, const std::vector<std::pair<std::string, std::vector<double>>> &filas) {
+    std::ofstream out(ruta);
+    if (!out.is_open()) {
+        std::cerr << "No se pudo crear el archivo " << ruta << std::endl;
+        return false;
+    }
+    out.precision(9);
+    for (const auto &[clase, valores] : filas) {
+        out << clase;
+        for (double v : valores) out << "," << v;
+        out << "\n";
+    }
+    return static_cast<bool>(out);
+}
+
+} // namespace dataset
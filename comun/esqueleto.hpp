@@ -0,0 +1,166 @@
+#pragma once
+
+// Esqueletización de Zhang-Suen sin el módulo ximgproc de opencv_contrib.
+//
+// Produce el mismo esqueleto que cv::ximgproc::thinning(..., THINNING_ZHANGSUEN): los píxeles
+// con valor >= 128 son figura, los del borde de la imagen nunca se borran (pero cuentan como
+// vecinos) y cada subiteración decide con el estado anterior a ella y borra todo de una vez.
+//
+// La diferencia está en qué píxeles se revisan:
+// - La imagen se empaqueta en bits (una palabra de 64 bits por cada 64 píxeles de una fila) y
+//   la primera pasada recorre palabra a palabra, saltando las vacías y sacando los píxeles de
+//   cada palabra con ctz.
+// - La decisión de borrar es una consulta a una tabla de 256 entradas por subiteración, indexada
+//   por los 8 vecinos.
+// - Si ningún vecino de un píxel cambió desde la última vez que se evaluó con la misma tabla (dos
+//   subiteraciones atrás), la decisión no puede cambiar. Por eso, tras las dos primeras
+//   subiteraciones solo se revisan los píxeles de la frontera: los vecinos de lo borrado en las
+//   dos subiteraciones anteriores. El algoritmo termina cuando dos subiteraciones seguidas no
+//   borran nada, que es el mismo punto fijo en el que se detiene ximgproc.
+
+#include <opencv2/core.hpp>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+namespace esqueleto {
+
+// Tablas de Zhang-Suen: tabla[s][vecinos] indica si un píxel de figura se borra en la
+// subiteración s. Bits de 'vecinos': 0 = p2 (norte), 1 = p3 (noreste), 2 = p4 (este),
+// 3 = p5 (sureste), 4 = p6 (sur), 5 = p7 (suroeste), 6 = p8 (oeste), 7 = p9 (noroeste).
+inline const std::array<std::array<bool, 256>, 2> &tablasZhangSuen() {
+    static const std::array<std::array<bool, 256>, 2> tablas = [] {
+        std::array<std::array<bool, 256>, 2> t{};
+        for (int v = 0; v < 256; v++) {
+            int p[10];  // p[2]..p[9]
+            for (int k = 0; k < 8; k++) p[k + 2] = (v >> k) & 1;
+            int a = 0, b = 0;
+            for (int k = 2; k <= 9; k++) {
+                const int siguiente = k == 9 ? p[2] : p[k + 1];
+                a += p[k] == 0 && siguiente == 1;
+                b += p[k];
+            }
+            const bool comun = a == 1 && b >= 2 && b <= 6;
+            t[0][v] = comun && p[2] * p[4] * p[6] == 0 && p[4] * p[6] * p[8] == 0;
+            t[1][v] = comun && p[2] * p[4] * p[8] == 0 && p[2] * p[6] * p[8] == 0;
+        }
+        return t;
+    }();
+    return tablas;
+}
+
+// Imagen binaria empaquetada por filas, 64 píxeles por palabra
+class ImagenBits {
+public:
+    explicit ImagenBits(const cv::Mat &img) : ancho(img.cols), alto(img.rows), palabras((img.cols + 63) / 64) {
+        bits.assign(static_cast<size_t>(alto) * palabras, 0);
+        for (int y = 0; y < alto; y++) {
+            const uchar *fila = img.ptr<uchar>(y);
+            uint64_t *destino = &bits[static_cast<size_t>(y) * palabras];
+            for (int x = 0; x < ancho; x++) {
+                if (fila[x] >= 128) destino[x >> 6] |= uint64_t(1) << (x & 63);
+            }
+        }
+    }
+
+    bool get(int y, int x) const { return (fila(y)[x >> 6] >> (x & 63)) & 1; }
+    void borrar(int y, int x) { bits[static_cast<size_t>(y) * palabras + (x >> 6)] &= ~(uint64_t(1) << (x & 63)); }
+    const uint64_t *fila(int y) const { return &bits[static_cast<size_t>(y) * palabras]; }
+
+    // Los 8 vecinos de un píxel interior, en el orden de las tablas
+    int vecinos(int y, int x) const {
+        return get(y - 1, x) | get(y - 1, x + 1) << 1 | get(y, x + 1) << 2 | get(y + 1, x + 1) << 3 |
+               get(y + 1, x) << 4 | get(y + 1, x - 1) << 5 | get(y, x - 1) << 6 | get(y - 1, x - 1) << 7;
+    }
+
+    // Función para volver a una imagen CV_8U con 0 y 255
+    cv::Mat aMat() const {
+        cv::Mat img = cv::Mat::zeros(alto, ancho, CV_8U);
+        for (int y = 0; y < alto; y++) {
+            uchar *destino = img.ptr<uchar>(y);
+            for (int x = 0; x < ancho; x++) destino[x] = get(y, x) ? 255 : 0;
+        }
+        return img;
+    }
+
+    int ancho, alto, palabras;
+
+private:
+    std::vector<uint64_t> bits;
+};
+
+// Función para esqueletizar una imagen binaria CV_8UC1 (equivalente a
+// cv::ximgproc::thinning(entrada, salida, cv::ximgproc::THINNING_ZHANGSUEN))
+inline void zhangSuen(const cv::Mat &entrada, cv::Mat &salida) {
+    CV_Assert(entrada.type() == CV_8UC1);
+    const auto &tablas = tablasZhangSuen();
+    ImagenBits img(entrada);
+    const int ancho = img.ancho, alto = img.alto;
+    if (ancho < 3 || alto < 3) {
+        salida = img.aMat();
+        return;
+    }
+
+    // Candidatos de la primera subiteración: todos los píxeles de figura interiores
+    std::vector<int> candidatos;
+    for (int y = 1; y < alto - 1; y++) {
+        const uint64_t *fila = img.fila(y);
+        for (int w = 0; w < img.palabras; w++) {
+            for (uint64_t palabra = fila[w]; palabra != 0; palabra &= palabra - 1) {
+                const int x = w * 64 + __builtin_ctzll(palabra);
+                if (x >= 1 && x < ancho - 1) candidatos.push_back(y * ancho + x);
+            }
+        }
+    }
+
+    // 'marca' evita repetir un píxel en la frontera de una subiteración
+    std::vector<int> marca(static_cast<size_t>(ancho) * alto, -1);
+    std::vector<int> borrados, borradosAnterior, frontera;
+    int sinCambios = 0;
+    for (int s = 0; sinCambios < 2; s++) {
+        const auto &tabla = tablas[s & 1];
+
+        // Decidir con el estado anterior a la subiteración y después borrar
+        borrados.clear();
+        for (int p : candidatos) {
+            const int y = p / ancho, x = p % ancho;
+            if (img.get(y, x) && tabla[img.vecinos(y, x)]) borrados.push_back(p);
+        }
+        for (int p : borrados) img.borrar(p / ancho, p % ancho);
+        sinCambios = borrados.empty() ? sinCambios + 1 : 0;
+
+        // Candidatos de la siguiente: todos en la segunda subiteración (aún no se evaluaron con
+        // la otra tabla); después, los vecinos interiores de lo borrado en las dos últimas
+        if (s == 0) {
+            borradosAnterior.swap(borrados);
+            candidatos.erase(std::remove_if(candidatos.begin(), candidatos.end(),
+                                            [&](int p) { return !img.get(p / ancho, p % ancho); }),
+                             candidatos.end());
+            continue;
+        }
+        frontera.clear();
+        for (const auto *lista : {&borradosAnterior, &borrados}) {
+            for (int p : *lista) {
+                const int y = p / ancho, x = p % ancho;
+                for (int dy = -1; dy <= 1; dy++) {
+                    for (int dx = -1; dx <= 1; dx++) {
+                        const int vy = y + dy, vx = x + dx;
+                        if (vy < 1 || vy >= alto - 1 || vx < 1 || vx >= ancho - 1) continue;
+                        const int v = vy * ancho + vx;
+                        if (marca[v] != s && img.get(vy, vx)) {
+                            marca[v] = s;
+                            frontera.push_back(v);
+                        }
+                    }
+                }
+            }
+        }
+        candidatos.swap(frontera);
+        borradosAnterior.swap(borrados);
+    }
+    salida = img.aMat();
+}
+
+} // namespace esqueleto
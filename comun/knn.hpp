@@ -0,0 +1,284 @@
+#pragma once
+
+// Clasificación por k vecinos más cercanos sobre vectores de momentos.
+//
+//   knn::IndiceKNN indice(referencias, knn::Metrica::Manhattan);   // pares (clase, vector)
+//   std::string clase = indice.clasificar(consulta, 5, knn::Voto::Ponderado);
+//
+// Las referencias se copian a un único arreglo contiguo de float (una fila por referencia). Con
+// pocas referencias la búsqueda es por fuerza bruta; a partir de 'minimoArbol' se construye un
+// VP-tree (vantage point tree): cada nodo elige un punto y separa los demás por la mediana de su
+// distancia a él, y la búsqueda descarta las ramas que la desigualdad triangular deja fuera del
+// radio de los k mejores. Por eso las dos métricas son distancias de verdad (L1 y L2, no L2 al
+// cuadrado). Las hojas guardan hasta 'tamHoja' puntos seguidos y se recorren por fuerza bruta,
+// igual que el conjunto completo cuando es pequeño: distancias por bloques de filas contiguas.
+//
+// Los empates de distancia se resuelven por el orden de las referencias, así que con k = 1 el
+// resultado es el mismo que el de un recorrido lineal que se queda con el primer mínimo.
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace knn {
+
+enum class Metrica {
+    Manhattan,  // L1, como calcularDistancia
+    Euclidea    // L2, como distanciaEuclidea
+};
+
+enum class Voto {
+    Mayoria,    // La clase más frecuente entre los k vecinos (empate: la del vecino más cercano)
+    Ponderado   // Cada vecino vota con peso 1 / (distancia + 1e-6)
+};
+
+// Un vecino encontrado: índice de la referencia (en el orden de entrada) y su distancia
+struct Vecino {
+    int indice;
+    float distancia;
+};
+
+// Orden de los vecinos: por distancia y, a igual distancia, por índice
+inline bool antes(const Vecino &a, const Vecino &b) {
+    return a.distancia < b.distancia || (a.distancia == b.distancia && a.indice < b.indice);
+}
+
+// Función para calcular la distancia entre dos vectores de 'dimension' floats
+inline float distancia(const float *a, const float *b, int dimension, Metrica metrica) {
+    float suma = 0.f;
+    if (metrica == Metrica::Manhattan) {
+        for (int d = 0; d < dimension; d++) {
+            suma += std::fabs(a[d] - b[d]);
+        }
+        return suma;
+    }
+    for (int d = 0; d < dimension; d++) {
+        const float diff = a[d] - b[d];
+        suma += diff * diff;
+    }
+    return std::sqrt(suma);
+}
+
+class IndiceKNN {
+public:
+    static constexpr size_t minimoArbol = 1024;
+    static constexpr int tamHoja = 16;
+
+    IndiceKNN() = default;
+
+    IndiceKNN(const std::vector<std::pair<std::string, std::vector<double>>> &referencias, Metrica metrica)
+        : metrica(metrica) {
+        std::map<std::string, int> idClase;
+        for (const auto &[clase, vec] : referencias) {
+            if (dimension == 0) dimension = static_cast<int>(vec.size());
+            if (vec.empty() || static_cast<int>(vec.size()) != dimension) continue;
+            auto it = idClase.emplace(clase, static_cast<int>(clases.size())).first;
+            if (it->second == static_cast<int>(clases.size())) clases.push_back(clase);
+            etiquetas.push_back(it->second);
+            for (double v : vec) datos.push_back(static_cast<float>(v));
+        }
+        construir();
+    }
+
+    // A partir de datos ya codificados (por ejemplo, un dataset::DatasetMapeado): nombres de
+    // clase, la clase de cada fila y las filas contiguas (etiquetas.size() x dimension)
+    IndiceKNN(std::vector<std::string> clases, std::vector<int> etiquetas, std::vector<float> datos, int dimension,
+              Metrica metrica)
+        : metrica(metrica), dimension(dimension), clases(std::move(clases)), etiquetas(std::move(etiquetas)),
+          datos(std::move(datos)) {
+        construir();
+    }
+
+    size_t size() const { return etiquetas.size(); }
+    int dimensiones() const { return dimension; }
+    bool usaArbol() const { return !nodos.empty(); }
+    const std::string &clase(int indice) const { return clases[etiquetas[indice]]; }
+
+    // Los k vecinos más cercanos a 'consulta' (dimensiones() valores), del más cercano al más lejano
+    std::vector<Vecino> buscar(const float *consulta, int k) const {
+        std::vector<Vecino> mejores;
+        k = std::min<int>(k, static_cast<int>(size()));
+        if (k <= 0) return mejores;
+        mejores.reserve(k + 1);
+        if (usaArbol()) {
+            buscarNodo(0, consulta, k, mejores);
+        } else {
+            recorrer(0, static_cast<int>(size()), consulta, k, mejores);
+        }
+        return ordenar(mejores);
+    }
+
+    std::vector<Vecino> buscar(const std::vector<double> &consulta, int k) const {
+        std::vector<float> q(consulta.begin(), consulta.end());
+        return buscar(q.data(), k);
+    }
+
+    // Búsqueda exhaustiva, sin el árbol (referencia para comprobar el VP-tree)
+    std::vector<Vecino> buscarFuerzaBruta(const float *consulta, int k) const {
+        std::vector<Vecino> mejores;
+        k = std::min<int>(k, static_cast<int>(size()));
+        if (k <= 0) return mejores;
+        recorrer(0, static_cast<int>(size()), consulta, k, mejores);
+        return ordenar(mejores);
+    }
+
+    // Clase asignada por votación entre los k vecinos más cercanos ("Desconocido" si no hay datos)
+    std::string clasificar(const std::vector<double> &consulta, int k = 1, Voto voto = Voto::Mayoria) const {
+        return votar(buscar(consulta, k), voto);
+    }
+
+    // Función para votar la clase entre vecinos ya buscados (ordenados del más cercano al más
+    // lejano, como los devuelve buscar); permite reutilizar una búsqueda para la distancia y el voto
+    std::string votar(const std::vector<Vecino> &vecinos, Voto voto = Voto::Mayoria) const {
+        if (vecinos.empty()) return "Desconocido";
+        // Votos por clase; como los vecinos vienen ordenados, la primera aparición de cada clase
+        // es su vecino más cercano y sirve para desempatar
+        std::vector<double> votos(clases.size(), 0.0);
+        std::vector<int> primero(clases.size(), -1);
+        for (size_t i = 0; i < vecinos.size(); i++) {
+            const int c = etiquetas[vecinos[i].indice];
+            votos[c] += voto == Voto::Mayoria ? 1.0 : 1.0 / (vecinos[i].distancia + 1e-6);
+            if (primero[c] < 0) primero[c] = static_cast<int>(i);
+        }
+        int mejor = etiquetas[vecinos[0].indice];
+        for (int c = 0; c < static_cast<int>(clases.size()); c++) {
+            if (primero[c] < 0) continue;
+            if (votos[c] > votos[mejor] || (votos[c] == votos[mejor] && primero[c] < primero[mejor])) mejor = c;
+        }
+        return clases[mejor];
+    }
+
+private:
+    // Pasa los índices del montículo a índices originales y ordena del más cercano al más lejano
+    std::vector<Vecino> ordenar(std::vector<Vecino> &mejores) const {
+        for (auto &v : mejores) v.indice = original[v.indice];
+        std::sort(mejores.begin(), mejores.end(), antes);
+        return mejores;
+    }
+
+    // Nodo del VP-tree sobre el rango [inicio, fin) de 'datos'. En un nodo interno el punto de
+    // vista es 'inicio', 'dentro' tiene los puntos a distancia <= umbral y 'fuera' los >= umbral.
+    struct Nodo {
+        int inicio, fin;
+        float umbral;
+        int dentro, fuera;   // -1 en las hojas
+    };
+
+    // Función para añadir a 'mejores' (montículo de máximos con los k mejores) los puntos del
+    // rango [inicio, fin). Las distancias se calculan por bloques sobre filas contiguas, un bucle
+    // sin saltos que el compilador vectoriza; solo las que no superan el radio tocan el montículo.
+    void recorrer(int inicio, int fin, const float *consulta, int k, std::vector<Vecino> &mejores) const {
+        constexpr int bloque = 64;
+        float dist[bloque];
+        for (int b = inicio; b < fin; b += bloque) {
+            const int n = std::min(bloque, fin - b);
+            const float *p = datos.data() + static_cast<size_t>(b) * dimension;
+            for (int i = 0; i < n; i++) {
+                dist[i] = distancia(consulta, p + static_cast<size_t>(i) * dimension, dimension, metrica);
+            }
+            for (int i = 0; i < n; i++) {
+                if (static_cast<int>(mejores.size()) == k && dist[i] > mejores.front().distancia) continue;
+                proponer({b + i, dist[i]}, k, mejores);
+            }
+        }
+    }
+
+    // Los índices dentro del montículo son posiciones en 'datos'; el desempate usa el índice
+    // original para que el resultado no dependa de cómo se reordenó el arreglo
+    void proponer(Vecino v, int k, std::vector<Vecino> &mejores) const {
+        auto peor = [&](const Vecino &a, const Vecino &b) {
+            return a.distancia < b.distancia || (a.distancia == b.distancia && original[a.indice] < original[b.indice]);
+        };
+        if (static_cast<int>(mejores.size()) < k) {
+            mejores.push_back(v);
+            std::push_heap(mejores.begin(), mejores.end(), peor);
+        } else if (peor(v, mejores.front())) {
+            std::pop_heap(mejores.begin(), mejores.end(), peor);
+            mejores.back() = v;
+            std::push_heap(mejores.begin(), mejores.end(), peor);
+        }
+    }
+
+    void buscarNodo(int n, const float *consulta, int k, std::vector<Vecino> &mejores) const {
+        const Nodo &nodo = nodos[n];
+        if (nodo.dentro < 0) {
+            recorrer(nodo.inicio, nodo.fin, consulta, k, mejores);
+            return;
+        }
+        const float d = distancia(consulta, datos.data() + static_cast<size_t>(nodo.inicio) * dimension, dimension,
+                                  metrica);
+        proponer({nodo.inicio, d}, k, mejores);
+        auto radio = [&] {
+            return static_cast<int>(mejores.size()) < k ? std::numeric_limits<float>::infinity()
+                                                         : mejores.front().distancia;
+        };
+        // Primero la rama del lado de la consulta, que suele reducir el radio antes de la otra
+        if (d <= nodo.umbral) {
+            if (d - radio() <= nodo.umbral) buscarNodo(nodo.dentro, consulta, k, mejores);
+            if (d + radio() >= nodo.umbral) buscarNodo(nodo.fuera, consulta, k, mejores);
+        } else {
+            if (d + radio() >= nodo.umbral) buscarNodo(nodo.fuera, consulta, k, mejores);
+            if (d - radio() <= nodo.umbral) buscarNodo(nodo.dentro, consulta, k, mejores);
+        }
+    }
+
+    void construir() {
+        original.resize(size());
+        for (size_t i = 0; i < original.size(); i++) original[i] = static_cast<int>(i);
+        if (size() < minimoArbol) return;
+
+        // Se construye sobre una permutación de índices y al final se reordena 'datos' para que
+        // cada hoja y cada rama queden en memoria contigua
+        std::vector<int> orden = original;
+        std::vector<float> dist(size());
+        std::mt19937 rng(12345);
+        construirNodo(orden, dist, 0, static_cast<int>(size()), rng);
+
+        std::vector<float> reordenados(datos.size());
+        for (size_t i = 0; i < orden.size(); i++) {
+            std::copy_n(datos.begin() + static_cast<size_t>(orden[i]) * dimension, dimension,
+                        reordenados.begin() + i * dimension);
+        }
+        datos.swap(reordenados);
+        original.swap(orden);
+    }
+
+    int construirNodo(std::vector<int> &orden, std::vector<float> &dist, int inicio, int fin, std::mt19937 &rng) {
+        const int n = static_cast<int>(nodos.size());
+        nodos.push_back({inicio, fin, 0.f, -1, -1});
+        if (fin - inicio <= tamHoja) return n;
+
+        // Punto de vista al azar (con semilla fija) y mediana de las distancias al resto
+        std::swap(orden[inicio], orden[inicio + rng() % (fin - inicio)]);
+        const float *vista = datos.data() + static_cast<size_t>(orden[inicio]) * dimension;
+        for (int i = inicio + 1; i < fin; i++) {
+            dist[orden[i]] = distancia(vista, datos.data() + static_cast<size_t>(orden[i]) * dimension, dimension, metrica);
+        }
+        const int medio = (inicio + 1 + fin) / 2;
+        std::nth_element(orden.begin() + inicio + 1, orden.begin() + medio, orden.begin() + fin,
+                         [&](int a, int b) { return dist[a] < dist[b]; });
+        const float umbral = dist[orden[medio]];
+
+        const int dentro = construirNodo(orden, dist, inicio + 1, medio, rng);
+        const int fuera = construirNodo(orden, dist, medio, fin, rng);
+        nodos[n].umbral = umbral;
+        nodos[n].dentro = dentro;
+        nodos[n].fuera = fuera;
+        return n;
+    }
+
+    Metrica metrica = Metrica::Manhattan;
+    int dimension = 0;
+    std::vector<std::string> clases;    // Nombre de cada clase
+    std::vector<int> etiquetas;         // Clase de cada referencia, por índice original
+    std::vector<float> datos;           // size() x dimension, en el orden del árbol
+    std::vector<int> original;          // Índice original de cada fila de 'datos'
+    std::vector<Nodo> nodos;            // Vacío si la búsqueda es por fuerza bruta
+};
+
+} // namespace knn
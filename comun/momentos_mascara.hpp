@@ -0,0 +1,456 @@
+#pragma once
+
+// Momentos de una máscara binaria calculados por tramos (runs) de píxeles.
+//
+// Sustituye la cadena cvtColor -> threshold -> morphologyEx -> findContours -> drawContours ->
+// moments de la librería nativa por dos pasadas:
+//   1. Por filas: color a gris (mismos coeficientes enteros que cvtColor) y umbral en un solo
+//      bucle, y cierre morfológico 3x3 sobre filas empaquetadas en bits (64 píxeles por
+//      palabra). De cada fila solo se guardan sus tramos de primer plano.
+//   2. Sobre los tramos: se marca el fondo conectado con el borde de la imagen (4-vecindad, la
+//      misma que usa findContours para el fondo), se rellena todo lo demás y se separan las
+//      regiones rellenas con 8-vecindad. Cada región acumula sus momentos tramo a tramo.
+// La región con más píxeles equivale al contorno externo de mayor área rellenado con
+// drawContours(FILLED). Los momentos de cada tramo se obtienen con fórmulas cerradas de sumas de
+// potencias, en enteros, por lo que coinciden con cv::moments(mask, true) sobre la misma máscara.
+//
+// Diferencias con la cadena original: el contorno elegido es el de más píxeles rellenos en lugar
+// del de mayor contourArea (el área del polígono que pasa por los centros del borde); solo
+// difieren si dos figuras tienen casi la misma área. Una región de una sola fila o columna se
+// descarta, igual que un contorno de área 0.
+//
+// Para un dibujo que cambia poco a poco, la máscara umbralizada se conserva entre llamadas y se
+// actualiza solo en las zonas modificadas (umbralizarZona), en O(píxeles nuevos). Los momentos de
+// la figura rellena no se pueden actualizar igual de forma exacta: un trazo que cierra la figura
+// rellena de golpe todo su interior y el cierre depende de los vecinos. Así que cierre, relleno
+// y momentos se recalculan sobre los bits, en O(alto * ancho / 64 + tramos), sin volver a leer
+// la imagen.
+
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+namespace mascara {
+
+// Orden de los canales de la imagen de entrada
+enum class FormatoPixel {
+    Gris,   // CV_8UC1
+    BGR,    // CV_8UC3 de imread
+    RGBA,   // CV_8UC4 de un Bitmap ARGB_8888 de Android
+    RGB565  // CV_8UC2 de un Bitmap RGB_565 de Android (uint16 con R en los bits altos)
+};
+
+// Número de bytes por píxel de cada formato
+inline int bytesPorPixel(FormatoPixel formato) {
+    switch (formato) {
+    case FormatoPixel::Gris: return 1;
+    case FormatoPixel::BGR: return 3;
+    case FormatoPixel::RGBA: return 4;
+    case FormatoPixel::RGB565: return 2;
+    }
+    return 0;
+}
+
+// Tramo horizontal [x0, x1) de la fila y
+struct Tramo {
+    int y, x0, x1;
+};
+
+// Momentos espaciales crudos (los mismos campos m00..m03 de cv::Moments)
+struct MomentosCrudos {
+    double m00 = 0, m10 = 0, m01 = 0, m20 = 0, m11 = 0, m02 = 0, m30 = 0, m21 = 0, m12 = 0, m03 = 0;
+
+    // Suma un tramo con fórmulas cerradas: s_k = suma de x^k para x en [x0, x1)
+    void sumarTramo(const Tramo &t) {
+        auto f1 = [](int64_t n) { return n * (n + 1) / 2; };                  // 0 + 1 + ... + n
+        auto f2 = [](int64_t n) { return n * (n + 1) * (2 * n + 1) / 6; };    // 0 + 1 + ... + n^2
+        const int64_t a = t.x0 - 1, b = t.x1 - 1;
+        const int64_t s0 = t.x1 - t.x0;
+        const int64_t s1 = f1(b) - f1(a);
+        const int64_t s2 = f2(b) - f2(a);
+        const int64_t s3 = f1(b) * f1(b) - f1(a) * f1(a);
+        const double y = t.y, y2 = y * y;
+        m00 += s0;
+        m10 += s1;
+        m01 += y * s0;
+        m20 += s2;
+        m11 += y * s1;
+        m02 += y2 * s0;
+        m30 += s3;
+        m21 += y * s2;
+        m12 += y2 * s1;
+        m03 += y2 * y * s0;
+    }
+
+    cv::Moments aMoments() const {
+        return cv::Moments(m00, m10, m01, m20, m11, m02, m30, m21, m12, m03);
+    }
+};
+
+// Máscara binaria empaquetada: el bit (x % 64) de la palabra x / 64 de cada fila es el píxel x
+class MascaraBits {
+public:
+    void crear(int ancho, int alto) {
+        this->ancho = ancho;
+        this->alto = alto;
+        palabras = (ancho + 63) / 64;
+        bits.assign(static_cast<size_t>(palabras) * alto, 0);
+    }
+
+    uint64_t *fila(int y) { return bits.data() + static_cast<size_t>(y) * palabras; }
+    const uint64_t *fila(int y) const { return bits.data() + static_cast<size_t>(y) * palabras; }
+
+    // Bits válidos de la última palabra de cada fila
+    uint64_t mascaraFinal() const {
+        return (ancho % 64) ? (~0ULL >> (64 - ancho % 64)) : ~0ULL;
+    }
+
+    int ancho = 0, alto = 0, palabras = 0;
+
+private:
+    std::vector<uint64_t> bits;
+};
+
+// Coeficientes de cvtColor (COLOR_*2GRAY) para 8 bits: 0.114 / 0.587 / 0.299 en punto fijo de 15 bits
+constexpr int grisB = 3735, grisG = 19235, grisR = 9798;
+
+// Aporte de cada canal de un píxel RGB_565 a la suma del gris. Cada canal se expande a 8 bits
+// como lo hacía bitmapToMat (v * 255 / 31 o v * 255 / 63), así que el gris es el mismo que el de
+// la imagen BGR que se generaba antes.
+struct TablasRGB565 {
+    int r[32], g[64], b[32];
+
+    TablasRGB565() {
+        for (int v = 0; v < 32; v++) {
+            r[v] = (v * 255 / 31) * grisR;
+            b[v] = (v * 255 / 31) * grisB;
+        }
+        for (int v = 0; v < 64; v++) {
+            g[v] = (v * 255 / 63) * grisG;
+        }
+    }
+};
+
+inline const TablasRGB565 &tablasRGB565() {
+    static const TablasRGB565 tablas;
+    return tablas;
+}
+
+// Función para umbralizar una fila en color: 1 si el gris es <= umbral (THRESH_BINARY_INV), 0 si
+// no. El gris se calcula con la aritmética entera de cvtColor, con redondeo.
+inline void filaUmbral(const uchar *src, int ancho, FormatoPixel formato, int umbral, uchar *dst) {
+    const int cb = grisB, cg = grisG, cr = grisR, redondeo = 1 << 14;
+    // gris <= umbral  <=>  suma + redondeo < (umbral + 1) << 15
+    const int limite = ((umbral + 1) << 15) - redondeo;
+    switch (formato) {
+    case FormatoPixel::Gris:
+        for (int x = 0; x < ancho; x++) {
+            dst[x] = src[x] <= umbral;
+        }
+        break;
+    case FormatoPixel::BGR:
+        for (int x = 0; x < ancho; x++) {
+            const uchar *p = src + x * 3;
+            dst[x] = p[0] * cb + p[1] * cg + p[2] * cr < limite;
+        }
+        break;
+    case FormatoPixel::RGBA:
+        for (int x = 0; x < ancho; x++) {
+            const uchar *p = src + x * 4;
+            dst[x] = p[2] * cb + p[1] * cg + p[0] * cr < limite;
+        }
+        break;
+    case FormatoPixel::RGB565: {
+        const TablasRGB565 &t = tablasRGB565();
+        for (int x = 0; x < ancho; x++) {
+            uint16_t p;
+            std::memcpy(&p, src + x * 2, 2);
+            dst[x] = t.r[p >> 11] + t.g[(p >> 5) & 0x3F] + t.b[p & 0x1F] < limite;
+        }
+        break;
+    }
+    }
+}
+
+// Función para empaquetar una fila de 0/1 en bits, de 8 en 8 píxeles: al multiplicar 8 bytes
+// 0/1 por 0x0102040810204080 cada byte queda en su bit del byte alto
+inline void empaquetarFila(const uchar *bits01, int ancho, uint64_t *dst) {
+    for (int w = 0; w * 64 < ancho; w++) {
+        const int n = std::min(64, ancho - w * 64);
+        const uchar *b = bits01 + w * 64;
+        uint64_t palabra = 0;
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            uint64_t ocho;
+            std::memcpy(&ocho, b + i, 8);
+            palabra |= ((ocho * 0x0102040810204080ULL) >> 56) << i;
+        }
+        for (; i < n; i++) {
+            palabra |= static_cast<uint64_t>(b[i]) << i;
+        }
+        dst[w] = palabra;
+    }
+}
+
+// Vecindad horizontal de 3 píxeles de una fila empaquetada: OR (dilatación) o AND (erosión).
+// Los píxeles fuera de la imagen valen 0 en la dilatación y 1 en la erosión, como el borde por
+// defecto de dilate/erode.
+inline void vecindadHorizontal(const uint64_t *src, int palabras, uint64_t final, bool erosion, uint64_t *dst) {
+    const uint64_t fuera = erosion ? ~0ULL : 0ULL;
+    auto palabra = [&](int w) -> uint64_t {
+        if (w < 0 || w >= palabras) return fuera;
+        return w == palabras - 1 ? ((src[w] & final) | (fuera & ~final)) : src[w];
+    };
+    for (int w = 0; w < palabras; w++) {
+        const uint64_t c = palabra(w);
+        const uint64_t izq = (c << 1) | (palabra(w - 1) >> 63);
+        const uint64_t der = (c >> 1) | (palabra(w + 1) << 63);
+        dst[w] = erosion ? (c & izq & der) : (c | izq | der);
+    }
+    dst[palabras - 1] &= final;
+}
+
+// Función para la primera parte de la pasada 1: color -> gris -> umbral, empaquetado en bits.
+// 'src' apunta a la primera fila, 'paso' es el número de bytes entre filas. Es la única función
+// que lee la imagen: al terminar ya se puede liberar (por ejemplo, desbloquear un Bitmap).
+inline void umbralizarImagen(const uchar *src, size_t paso, int ancho, int alto, FormatoPixel formato, int umbral,
+                             MascaraBits &umbralizada) {
+    umbralizada.crear(ancho, alto);
+    std::vector<uchar> fila01(ancho);
+    for (int y = 0; y < alto; y++) {
+        filaUmbral(src + y * paso, ancho, formato, umbral, fila01.data());
+        empaquetarFila(fila01.data(), ancho, umbralizada.fila(y));
+    }
+}
+
+// Función para volver a umbralizar solo la zona 'zona' de una imagen ya umbralizada con
+// umbralizarImagen (por ejemplo, lo que cambió en un lienzo desde la última llamada). Cuesta
+// O(píxeles de la zona); 'src' apunta a la primera fila de la imagen completa.
+inline void umbralizarZona(const uchar *src, size_t paso, FormatoPixel formato, int umbral, cv::Rect zona,
+                           MascaraBits &umbralizada) {
+    zona = zona & cv::Rect(0, 0, umbralizada.ancho, umbralizada.alto);
+    if (zona.empty()) return;
+    const int bpp = bytesPorPixel(formato);
+    std::vector<uchar> fila01(zona.width);
+    for (int y = zona.y; y < zona.y + zona.height; y++) {
+        filaUmbral(src + y * paso + zona.x * bpp, zona.width, formato, umbral, fila01.data());
+        uint64_t *f = umbralizada.fila(y);
+        for (int i = 0; i < zona.width; i++) {
+            const int x = zona.x + i;
+            const uint64_t bit = 1ULL << (x % 64);
+            f[x / 64] = fila01[i] ? (f[x / 64] | bit) : (f[x / 64] & ~bit);
+        }
+    }
+}
+
+// Función para la segunda parte de la pasada 1: cierre 3x3 de la máscara umbralizada,
+// directamente a tramos
+inline void tramosCierre(const MascaraBits &umbralizada, std::vector<Tramo> &tramos, std::vector<int> &inicioFila) {
+    const int ancho = umbralizada.ancho, alto = umbralizada.alto;
+    MascaraBits dilatada;
+    dilatada.crear(ancho, alto);
+    const int palabras = umbralizada.palabras;
+    const uint64_t final = umbralizada.mascaraFinal();
+    std::vector<uint64_t> v(palabras);
+
+    // Dilatación: OR horizontal de cada fila y OR vertical de las filas vecinas (fuera = 0)
+    std::vector<uint64_t> hPrev(palabras, 0), hCur(palabras), hNext(palabras);
+    vecindadHorizontal(umbralizada.fila(0), palabras, final, false, hCur.data());
+    for (int y = 0; y < alto; y++) {
+        if (y + 1 < alto) {
+            vecindadHorizontal(umbralizada.fila(y + 1), palabras, final, false, hNext.data());
+        } else {
+            std::fill(hNext.begin(), hNext.end(), 0);
+        }
+        uint64_t *d = dilatada.fila(y);
+        for (int w = 0; w < palabras; w++) {
+            d[w] = hPrev[w] | hCur[w] | hNext[w];
+        }
+        std::swap(hPrev, hCur);
+        std::swap(hCur, hNext);
+    }
+
+    // Erosión: AND horizontal y AND vertical (fuera = 1) y extracción de tramos de cada fila
+    tramos.clear();
+    inicioFila.assign(alto + 1, 0);
+    std::fill(hPrev.begin(), hPrev.end(), ~0ULL);
+    vecindadHorizontal(dilatada.fila(0), palabras, final, true, hCur.data());
+    for (int y = 0; y < alto; y++) {
+        if (y + 1 < alto) {
+            vecindadHorizontal(dilatada.fila(y + 1), palabras, final, true, hNext.data());
+        } else {
+            std::fill(hNext.begin(), hNext.end(), ~0ULL);
+        }
+        for (int w = 0; w < palabras; w++) {
+            v[w] = hPrev[w] & hCur[w] & hNext[w];
+        }
+        v[palabras - 1] &= final;
+
+        inicioFila[y] = static_cast<int>(tramos.size());
+        int x = 0;
+        while (x < ancho) {
+            // Siguiente bit a 1 desde x
+            int w = x / 64;
+            uint64_t resto = v[w] & (~0ULL << (x % 64));
+            while (!resto && ++w < palabras) resto = v[w];
+            if (!resto) break;
+            const int x0 = w * 64 + __builtin_ctzll(resto);
+            // Siguiente bit a 0 desde x0
+            w = x0 / 64;
+            resto = ~v[w] & (~0ULL << (x0 % 64));
+            while (!resto && ++w < palabras) resto = ~v[w];
+            const int x1 = resto ? std::min(ancho, w * 64 + __builtin_ctzll(resto)) : ancho;
+            tramos.push_back({y, x0, x1});
+            x = x1;
+        }
+
+        std::swap(hPrev, hCur);
+        std::swap(hCur, hNext);
+    }
+    inicioFila[alto] = static_cast<int>(tramos.size());
+}
+
+// Función para la pasada 1 completa: color -> gris -> umbral -> cierre 3x3, directamente a tramos
+inline void tramosUmbralCierre(const uchar *src, size_t paso, int ancho, int alto, FormatoPixel formato,
+                               int umbral, std::vector<Tramo> &tramos, std::vector<int> &inicioFila) {
+    MascaraBits umbralizada;
+    umbralizarImagen(src, paso, ancho, alto, formato, umbral, umbralizada);
+    tramosCierre(umbralizada, tramos, inicioFila);
+}
+
+// Conjuntos disjuntos para unir tramos conectados
+class Uniones {
+public:
+    explicit Uniones(size_t n) : padre(n) { std::iota(padre.begin(), padre.end(), 0); }
+
+    int raiz(int i) {
+        while (padre[i] != i) {
+            padre[i] = padre[padre[i]];
+            i = padre[i];
+        }
+        return i;
+    }
+
+    void unir(int a, int b) {
+        a = raiz(a);
+        b = raiz(b);
+        if (a != b) padre[std::max(a, b)] = std::min(a, b);
+    }
+
+private:
+    std::vector<int> padre;
+};
+
+// Función para unir los tramos de filas consecutivas que se tocan. Con 8-vecindad basta con que
+// se toquen en diagonal; con 4-vecindad tienen que compartir alguna columna.
+inline void unirFilas(const std::vector<Tramo> &tramos, const std::vector<int> &inicioFila, bool ochoVecindad,
+                      Uniones &uniones) {
+    const int holgura = ochoVecindad ? 1 : 0;
+    for (size_t y = 1; y + 1 < inicioFila.size(); y++) {
+        int a = inicioFila[y - 1];
+        const int finA = inicioFila[y];
+        for (int b = inicioFila[y]; b < inicioFila[y + 1]; b++) {
+            while (a < finA && tramos[a].x1 + holgura <= tramos[b].x0) a++;
+            for (int k = a; k < finA && tramos[k].x0 < tramos[b].x1 + holgura; k++) {
+                uniones.unir(k, b);
+            }
+        }
+    }
+}
+
+// Función para la pasada 2: relleno de huecos y momentos de la región rellena con más píxeles
+inline MomentosCrudos momentosRegionMayor(const std::vector<Tramo> &frente, const std::vector<int> &inicioFrente,
+                                          int ancho) {
+    const int alto = static_cast<int>(inicioFrente.size()) - 1;
+
+    // Tramos de fondo: huecos entre los tramos de primer plano de cada fila
+    std::vector<Tramo> fondo;
+    std::vector<int> inicioFondo(alto + 1);
+    for (int y = 0; y < alto; y++) {
+        inicioFondo[y] = static_cast<int>(fondo.size());
+        int x = 0;
+        for (int k = inicioFrente[y]; k < inicioFrente[y + 1]; k++) {
+            if (frente[k].x0 > x) fondo.push_back({y, x, frente[k].x0});
+            x = frente[k].x1;
+        }
+        if (x < ancho) fondo.push_back({y, x, ancho});
+    }
+    inicioFondo[alto] = static_cast<int>(fondo.size());
+
+    // Fondo exterior: componentes (4-vecindad) que tocan el borde de la imagen
+    Uniones unionesFondo(fondo.size());
+    unirFilas(fondo, inicioFondo, false, unionesFondo);
+    std::vector<char> exterior(fondo.size(), 0);
+    for (size_t k = 0; k < fondo.size(); k++) {
+        const Tramo &t = fondo[k];
+        if (t.y == 0 || t.y == alto - 1 || t.x0 == 0 || t.x1 == ancho) {
+            exterior[unionesFondo.raiz(static_cast<int>(k))] = 1;
+        }
+    }
+
+    // Tramos rellenos: todo lo que queda entre tramos de fondo exterior
+    std::vector<Tramo> relleno;
+    std::vector<int> inicioRelleno(alto + 1);
+    for (int y = 0; y < alto; y++) {
+        inicioRelleno[y] = static_cast<int>(relleno.size());
+        int x = 0;
+        for (int k = inicioFondo[y]; k < inicioFondo[y + 1]; k++) {
+            if (!exterior[unionesFondo.raiz(k)]) continue;
+            if (fondo[k].x0 > x) relleno.push_back({y, x, fondo[k].x0});
+            x = fondo[k].x1;
+        }
+        if (x < ancho) relleno.push_back({y, x, ancho});
+    }
+    inicioRelleno[alto] = static_cast<int>(relleno.size());
+
+    // Regiones rellenas (8-vecindad, como los contornos de primer plano) y sus momentos
+    Uniones uniones(relleno.size());
+    unirFilas(relleno, inicioRelleno, true, uniones);
+    std::vector<MomentosCrudos> regiones(relleno.size());
+    std::vector<cv::Rect> cajas(relleno.size());
+    for (size_t k = 0; k < relleno.size(); k++) {
+        const int r = uniones.raiz(static_cast<int>(k));
+        regiones[r].sumarTramo(relleno[k]);
+        cv::Rect t(relleno[k].x0, relleno[k].y, relleno[k].x1 - relleno[k].x0, 1);
+        cajas[r] = cajas[r].area() ? (cajas[r] | t) : t;
+    }
+
+    int mejor = -1;
+    for (size_t r = 0; r < regiones.size(); r++) {
+        if (regiones[r].m00 == 0 || cajas[r].width < 2 || cajas[r].height < 2) continue;
+        if (mejor < 0 || regiones[r].m00 > regiones[mejor].m00) mejor = static_cast<int>(r);
+    }
+    return mejor >= 0 ? regiones[mejor] : MomentosCrudos();
+}
+
+// Función para obtener los momentos de la figura principal de una imagen (ver cabecera)
+inline MomentosCrudos momentosFiguraPrincipal(const cv::Mat &img, FormatoPixel formato, int umbral = 235) {
+    CV_Assert(img.depth() == CV_8U && img.channels() == bytesPorPixel(formato));
+    std::vector<Tramo> tramos;
+    std::vector<int> inicioFila;
+    tramosUmbralCierre(img.ptr<uchar>(), img.step[0], img.cols, img.rows, formato, umbral, tramos, inicioFila);
+    return momentosRegionMayor(tramos, inicioFila, img.cols);
+}
+
+// Función para calcular los momentos de una máscara binaria ya hecha (píxel != 0 es primer
+// plano), equivalente a cv::moments(mask, true) recorriendo la imagen por tramos
+inline MomentosCrudos momentosBinarios(const cv::Mat &mask) {
+    CV_Assert(mask.type() == CV_8UC1);
+    MomentosCrudos m;
+    for (int y = 0; y < mask.rows; y++) {
+        const uchar *p = mask.ptr<uchar>(y);
+        int x = 0;
+        while (x < mask.cols) {
+            while (x < mask.cols && !p[x]) x++;
+            const int x0 = x;
+            while (x < mask.cols && p[x]) x++;
+            if (x > x0) m.sumarTramo({y, x0, x});
+        }
+    }
+    return m;
+}
+
+} // namespace mascara
@@ -0,0 +1,190 @@
+#pragma once
+
+// Trazas por etapa con temporizadores de ámbito.
+//
+//   void procesar() {
+//       TRAZA_AMBITO("hog");
+//       ...
+//   }
+//   ...
+//   TRAZA_VOLCAR("traza.json");   // al final de main
+//
+// Solo se compila si se define MOMENTOS_TRAZA (make TRAZA=1, o -DMOMENTOS_TRAZA=ON en CMake).
+// Sin esa macro TRAZA_AMBITO y TRAZA_VOLCAR se expanden a nada y el programa no incluye ni una
+// instrucción adicional.
+//
+// Cada hilo guarda sus eventos en un búfer propio (thread_local), así que registrar un evento
+// no toma ningún cerrojo: solo la primera traza de cada hilo registra su búfer en la lista
+// global. TRAZA_VOLCAR escribe un JSON de eventos de Chrome (chrome://tracing o
+// ui.perfetto.dev) y muestra por stderr un resumen por etapa con un histograma de duraciones.
+// Se debe llamar cuando ya no queden hilos trabajando.
+//
+// Los nombres de etapa deben ser literales de cadena (se guarda solo el puntero).
+
+#ifdef MOMENTOS_TRAZA
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace traza {
+
+// Un evento completo ("ph":"X" en el formato de Chrome)
+struct Evento {
+    const char *nombre;
+    int64_t inicioNs;
+    int64_t duracionNs;
+};
+
+// Búfer de eventos de un hilo
+struct BuferHilo {
+    uint32_t tid;
+    std::vector<Evento> eventos;
+};
+
+// Lista global de búferes. Solo se toca al crear el búfer de un hilo y al volcar.
+class Registro {
+public:
+    static Registro &instancia() {
+        static Registro registro;
+        return registro;
+    }
+
+    BuferHilo *nuevoBufer() {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto bufer = std::make_shared<BuferHilo>();
+        bufer->tid = static_cast<uint32_t>(buferes.size());
+        bufer->eventos.reserve(4096);
+        buferes.push_back(bufer);
+        return bufer.get();
+    }
+
+    // Los búferes se conservan aunque su hilo termine, para poder volcarlos al final
+    std::vector<std::shared_ptr<BuferHilo>> copiaBuferes() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return buferes;
+    }
+
+    const std::chrono::steady_clock::time_point origen = std::chrono::steady_clock::now();
+
+private:
+    std::mutex mtx;
+    std::vector<std::shared_ptr<BuferHilo>> buferes;
+};
+
+inline int64_t ahoraNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - Registro::instancia().origen).count();
+}
+
+inline BuferHilo &buferHilo() {
+    thread_local BuferHilo *bufer = Registro::instancia().nuevoBufer();
+    return *bufer;
+}
+
+// Temporizador de ámbito: registra un evento con la duración de su vida
+class Ambito {
+public:
+    explicit Ambito(const char *nombre) : nombre(nombre), inicio(ahoraNs()) {}
+    ~Ambito() { buferHilo().eventos.push_back({nombre, inicio, ahoraNs() - inicio}); }
+
+    Ambito(const Ambito &) = delete;
+    Ambito &operator=(const Ambito &) = delete;
+
+private:
+    const char *nombre;
+    int64_t inicio;
+};
+
+// Función para escribir las trazas en formato JSON de eventos de Chrome
+inline void exportarChrome(const std::string &ruta, const std::vector<std::shared_ptr<BuferHilo>> &buferes) {
+    std::ofstream out(ruta);
+    if (!out.is_open()) {
+        std::cerr << "No se pudo crear el archivo de trazas " << ruta << std::endl;
+        return;
+    }
+    out << "{\"traceEvents\":[";
+    bool primero = true;
+    out << std::fixed << std::setprecision(3);
+    for (const auto &bufer : buferes) {
+        for (const auto &e : bufer->eventos) {
+            out << (primero ? "\n" : ",\n") << "{\"name\":\"" << e.nombre << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+                << bufer->tid << ",\"ts\":" << e.inicioNs / 1000.0 << ",\"dur\":" << e.duracionNs / 1000.0 << "}";
+            primero = false;
+        }
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+// Función para mostrar el resumen por etapa: llamadas, total, percentiles e histograma en
+// cubos de potencias de 2 microsegundos
+inline void resumen(std::ostream &out, const std::vector<std::shared_ptr<BuferHilo>> &buferes) {
+    std::map<std::string, std::vector<int64_t>> etapas;
+    for (const auto &bufer : buferes) {
+        for (const auto &e : bufer->eventos) {
+            etapas[e.nombre].push_back(e.duracionNs);
+        }
+    }
+
+    out << std::left << std::setw(24) << "etapa" << std::right << std::setw(9) << "llamadas" << std::setw(12)
+        << "total ms" << std::setw(10) << "p50 ms" << std::setw(10) << "p99 ms" << std::setw(10) << "máx ms" << std::endl;
+    for (auto &etapa : etapas) {
+        std::vector<int64_t> &d = etapa.second;
+        std::sort(d.begin(), d.end());
+        int64_t total = 0;
+        for (int64_t v : d) total += v;
+        auto percentil = [&](double q) {
+            size_t idx = static_cast<size_t>(q * (d.size() - 1) + 0.5);
+            return d[idx] / 1e6;
+        };
+        out << std::left << std::setw(24) << etapa.first << std::right << std::fixed << std::setprecision(3)
+            << std::setw(9) << d.size() << std::setw(12) << total / 1e6 << std::setw(10) << percentil(0.50)
+            << std::setw(10) << percentil(0.99) << std::setw(10) << d.back() / 1e6 << std::endl;
+
+        // Histograma: cubo k = duraciones en [2^k, 2^(k+1)) microsegundos
+        std::map<int, size_t> cubos;
+        for (int64_t v : d) {
+            int k = 0;
+            for (int64_t us = v / 1000; us > 1; us >>= 1) k++;
+            cubos[k]++;
+        }
+        size_t maxCubo = 0;
+        for (const auto &c : cubos) maxCubo = std::max(maxCubo, c.second);
+        for (const auto &c : cubos) {
+            size_t barra = (c.second * 40 + maxCubo - 1) / maxCubo;
+            out << "    " << std::setw(8) << (1LL << c.first) << " us | " << std::string(barra, '#') << " "
+                << c.second << std::endl;
+        }
+    }
+    out.unsetf(std::ios::fixed);
+}
+
+// Función para volcar las trazas de todos los hilos
+inline void volcar(const std::string &ruta) {
+    auto buferes = Registro::instancia().copiaBuferes();
+    exportarChrome(ruta, buferes);
+    resumen(std::cerr, buferes);
+    std::cerr << "Trazas guardadas en " << ruta << std::endl;
+}
+
+} // namespace traza
+
+#define TRAZA_CONCAT_(a, b) a##b
+#define TRAZA_CONCAT(a, b) TRAZA_CONCAT_(a, b)
+#define TRAZA_AMBITO(nombre) ::traza::Ambito TRAZA_CONCAT(trazaAmbito_, __LINE__)(nombre)
+#define TRAZA_VOLCAR(ruta) ::traza::volcar(ruta)
+
+#else
+
+#define TRAZA_AMBITO(nombre) ((void)0)
+#define TRAZA_VOLCAR(ruta) ((void)0)
+
+#endif
@@ -0,0 +1,328 @@
+#pragma once
+
+// Momentos de Zernike sin dependencias externas (reemplaza a mb_zernike2D de pychrm).
+//
+// Se sigue la misma definición que mb_zernike2D: las coordenadas de los píxeles distintos de
+// cero (contadas desde 1) se centran en el centroide de intensidad y se dividen por el radio R;
+// los píxeles fuera del disco unidad se ignoran, la intensidad se divide por la suma de
+// intensidades y cada momento es |Z_nm| = (n + 1) / pi * |sum p R_nm(rho) e^{-i m theta}|, para
+// n = 0..orden y m = 0..n con n - m par, en ese orden.
+//
+// Los polinomios radiales se calculan con la recurrencia de Kintner sobre n (sin factoriales ni
+// potencias) y el término angular como (x + iy)^m: R_nm(rho) e^{i m theta} = Q_nm(rho^2) (x + iy)^m,
+// con Q_nm = R_nm / rho^m, así que tampoco hay atan2, cos ni sin por píxel. Cada m es
+// independiente, de modo que en imágenes grandes los m se reparten entre hilos y el resultado es
+// idéntico al secuencial.
+//
+// Para lotes de imágenes del mismo tamaño hay una segunda variante, centrada en el centro de la
+// imagen en lugar del centroide: así la base V*_nm es la misma para todas las imágenes y los
+// momentos de N imágenes son un único producto de matrices (momentosLote). Las bases se guardan
+// en una caché por (lado, orden) y opcionalmente en disco. Los valores de las dos variantes no
+// son intercambiables: un dataset y sus consultas deben usar la misma.
+
+#include <opencv2/core.hpp>
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace zernike {
+
+// A partir de cuántos píxeles x órdenes conviene repartir los m entre hilos
+constexpr size_t minimoParalelo = 1 << 16;
+
+// Imágenes por bloque del producto de matrices de momentosLote
+constexpr int imagenesBloque = 64;
+
+// Centro de las coordenadas: el centroide de intensidad (mb_zernike2D) o el centro de la imagen
+enum class Centro { Centroide, Imagen };
+
+// Función para contar los momentos hasta 'orden': para cada n, los m = 0..n con n - m par
+inline int numMomentos(int orden) {
+    int total = 0;
+    for (int n = 0; n <= orden; n++) total += n / 2 + 1;
+    return total;
+}
+
+// Posición de (n, m) en el vector de momentos
+inline int indice(int n, int m) { return numMomentos(n - 1) + m / 2; }
+
+// Píxeles distintos de cero dentro del disco unidad: coordenadas relativas al centro divididas
+// por el radio y peso = intensidad / suma de intensidades
+struct PixelesDisco {
+    std::vector<double> x, y, rho2, peso;
+};
+
+// Función para extraer los píxeles de una imagen de un canal (cualquier profundidad). Con
+// radio <= 0 se usa la mitad del lado menor.
+inline PixelesDisco pixelesDisco(const cv::Mat &img, double radio, Centro centro = Centro::Centroide) {
+    CV_Assert(img.channels() == 1);
+    cv::Mat valores;
+    img.convertTo(valores, CV_64F);
+    if (radio <= 0) radio = std::min(img.cols, img.rows) / 2.0;
+
+    double suma = 0.0, m10 = 0.0, m01 = 0.0;
+    for (int y = 0; y < valores.rows; y++) {
+        const double *fila = valores.ptr<double>(y);
+        for (int x = 0; x < valores.cols; x++) {
+            suma += fila[x];
+            m10 += (x + 1) * fila[x];
+            m01 += (y + 1) * fila[x];
+        }
+    }
+
+    PixelesDisco p;
+    if (suma == 0.0) return p;
+    double cx = m10 / suma, cy = m01 / suma;
+    if (centro == Centro::Imagen) {
+        cx = (img.cols + 1) / 2.0;
+        cy = (img.rows + 1) / 2.0;
+    }
+    for (int y = 0; y < valores.rows; y++) {
+        const double *fila = valores.ptr<double>(y);
+        for (int x = 0; x < valores.cols; x++) {
+            if (fila[x] == 0.0) continue;
+            const double px = (x + 1 - cx) / radio, py = (y + 1 - cy) / radio;
+            const double r2 = px * px + py * py;
+            if (std::sqrt(r2) > 1.0) continue;
+            p.x.push_back(px);
+            p.y.push_back(py);
+            p.rho2.push_back(r2);
+            p.peso.push_back(fila[x] / suma);
+        }
+    }
+    return p;
+}
+
+// Coeficientes de Kintner para un m fijo: Q_n = (a[n] rho^2 + b[n]) Q_{n-2} + c[n] Q_{n-4}, con
+// Q_m = 1 y Q_{m+2} = (m + 2) rho^2 - (m + 1)
+struct Kintner {
+    std::vector<double> a, b, c;
+
+    Kintner(int orden, int m) : a(orden + 1, 0.0), b(orden + 1, 0.0), c(orden + 1, 0.0) {
+        if (m + 2 <= orden) {
+            a[m + 2] = m + 2.0;
+            b[m + 2] = -(m + 1.0);
+        }
+        for (int n = m + 4; n <= orden; n += 2) {
+            const double k1 = (n + m) * (n - m) * (n - 2) / 2.0;
+            const double k2 = 2.0 * n * (n - 1) * (n - 2);
+            const double k3 = -1.0 * m * m * (n - 1) - 1.0 * n * (n - 1) * (n - 2);
+            const double k4 = -n * (n + m - 2) * (n - m - 2) / 2.0;
+            a[n] = k2 / k1;
+            b[n] = k3 / k1;
+            c[n] = k4 / k1;
+        }
+    }
+};
+
+// Función para acumular sum p Q_nm(rho^2) (x + iy)^m para n = m..orden (en suma[n])
+inline void acumular(const PixelesDisco &p, int orden, int m, std::complex<double> *suma) {
+    const Kintner k(orden, m);
+    std::fill(suma, suma + orden + 1, std::complex<double>(0.0, 0.0));
+    for (size_t i = 0; i < p.peso.size(); i++) {
+        // (x + iy)^m por cuadrados sucesivos
+        std::complex<double> z(p.x[i], p.y[i]), zm(1.0, 0.0);
+        for (int e = m; e > 0; e >>= 1) {
+            if (e & 1) zm *= z;
+            z *= z;
+        }
+        zm *= p.peso[i];
+
+        const double r2 = p.rho2[i];
+        double q2 = 0.0, q1 = 1.0;  // Q_{n-4}, Q_{n-2}
+        suma[m] += zm;
+        for (int n = m + 2; n <= orden; n += 2) {
+            const double q = (k.a[n] * r2 + k.b[n]) * q1 + k.c[n] * q2;
+            suma[n] += q * zm;
+            q2 = q1;
+            q1 = q;
+        }
+    }
+}
+
+// Función para calcular las magnitudes de los momentos de Zernike hasta 'orden' (numMomentos
+// valores, en el orden de mb_zernike2D) de una imagen de un canal
+inline std::vector<double> momentos(const cv::Mat &img, int orden, double radio = 0.0, bool paralelo = true,
+                                    Centro centro = Centro::Centroide) {
+    CV_Assert(orden >= 0);
+    std::vector<double> magnitudes(numMomentos(orden), 0.0);
+    const PixelesDisco p = pixelesDisco(img, radio, centro);
+    if (p.peso.empty()) return magnitudes;
+
+    auto calcular = [&](const cv::Range &rango) {
+        std::vector<std::complex<double>> suma(orden + 1);
+        for (int m = rango.start; m < rango.end; m++) {
+            acumular(p, orden, m, suma.data());
+            for (int n = m; n <= orden; n += 2) {
+                magnitudes[indice(n, m)] = (n + 1) / CV_PI * std::abs(suma[n]);
+            }
+        }
+    };
+    if (paralelo && orden > 0 && p.peso.size() * (orden + 1) >= minimoParalelo) {
+        cv::parallel_for_(cv::Range(0, orden + 1), calcular, orden + 1);
+    } else {
+        calcular(cv::Range(0, orden + 1));
+    }
+    return magnitudes;
+}
+
+// Base de Zernike para imágenes de lado x lado centradas en el centro de la imagen con radio
+// lado / 2: fila 2k = Re V*_nm y fila 2k + 1 = Im V*_nm del k-ésimo momento, evaluadas en cada
+// píxel (columna y * lado + x), en float32. Los píxeles fuera del disco valen 0.
+struct Base {
+    int lado = 0;
+    int orden = 0;
+    cv::Mat matriz;     // 2 * numMomentos(orden) x lado * lado, CV_32F
+
+    Base() = default;
+
+    Base(int lado, int orden) : lado(lado), orden(orden) {
+        CV_Assert(lado > 0 && orden >= 0);
+        matriz = cv::Mat::zeros(2 * numMomentos(orden), lado * lado, CV_32F);
+        std::vector<Kintner> k;
+        for (int m = 0; m <= orden; m++) k.emplace_back(orden, m);
+        const double centro = (lado + 1) / 2.0, radio = lado / 2.0;
+
+        cv::parallel_for_(cv::Range(0, lado), [&](const cv::Range &filas) {
+            std::vector<double> q(orden + 1);
+            for (int y = filas.start; y < filas.end; y++) {
+                for (int x = 0; x < lado; x++) {
+                    const double px = (x + 1 - centro) / radio, py = (y + 1 - centro) / radio;
+                    const double r2 = px * px + py * py;
+                    if (std::sqrt(r2) > 1.0) continue;
+                    const int columna = y * lado + x;
+                    std::complex<double> zm(1.0, 0.0);
+                    for (int m = 0; m <= orden; m++) {
+                        // Q_nm por Kintner y V*_nm = (n + 1) / pi Q_nm conj((x + iy)^m)
+                        q[m] = 1.0;
+                        if (m + 2 <= orden) q[m + 2] = k[m].a[m + 2] * r2 + k[m].b[m + 2];
+                        for (int n = m + 4; n <= orden; n += 2) {
+                            q[n] = (k[m].a[n] * r2 + k[m].b[n]) * q[n - 2] + k[m].c[n] * q[n - 4];
+                        }
+                        for (int n = m; n <= orden; n += 2) {
+                            const double c = (n + 1) / CV_PI * q[n];
+                            matriz.at<float>(2 * indice(n, m), columna) = static_cast<float>(c * zm.real());
+                            matriz.at<float>(2 * indice(n, m) + 1, columna) = static_cast<float>(-c * zm.imag());
+                        }
+                        zm *= std::complex<double>(px, py);
+                    }
+                }
+            }
+        });
+    }
+
+    // Función para guardar la base en un archivo binario propio (cabecera y la matriz en float32)
+    bool guardar(const std::string &ruta) const {
+        const std::string temporal = ruta + ".tmp";
+        {
+            std::ofstream out(temporal, std::ios::binary);
+            if (!out.is_open()) return false;
+            const int32_t cabecera[4] = {lado, orden, matriz.rows, matriz.cols};
+            out.write(magia, sizeof(magia));
+            out.write(reinterpret_cast<const char *>(cabecera), sizeof(cabecera));
+            for (int i = 0; i < matriz.rows; i++) {
+                out.write(matriz.ptr<char>(i), static_cast<std::streamsize>(matriz.cols * sizeof(float)));
+            }
+            if (!out) return false;
+        }
+        // Se reemplaza de una vez para que otro proceso nunca lea una base a medio escribir
+        return std::rename(temporal.c_str(), ruta.c_str()) == 0;
+    }
+
+    // Función para leer una base guardada. Retorna false si no existe o no corresponde a
+    // (lado, orden).
+    bool cargar(const std::string &ruta, int ladoEsperado, int ordenEsperado) {
+        std::ifstream in(ruta, std::ios::binary);
+        char m[sizeof(magia)];
+        int32_t cabecera[4];
+        if (!in.read(m, sizeof(m)) || std::memcmp(m, magia, sizeof(magia)) != 0) return false;
+        if (!in.read(reinterpret_cast<char *>(cabecera), sizeof(cabecera))) return false;
+        if (cabecera[0] != ladoEsperado || cabecera[1] != ordenEsperado || cabecera[2] != 2 * numMomentos(ordenEsperado) ||
+            cabecera[3] != ladoEsperado * ladoEsperado) {
+            return false;
+        }
+        cv::Mat leida(cabecera[2], cabecera[3], CV_32F);
+        if (!in.read(leida.ptr<char>(), static_cast<std::streamsize>(leida.total() * sizeof(float)))) return false;
+        lado = ladoEsperado;
+        orden = ordenEsperado;
+        matriz = leida;
+        return true;
+    }
+
+    static constexpr char magia[8] = {'Z', 'E', 'R', 'B', 'A', 'S', 'E', '1'};
+};
+
+// Función para obtener la base de (lado, orden) de la caché del proceso; se construye la primera
+// vez que se pide. Si 'carpeta' no está vacía, antes de construirla se busca en
+// carpeta/zernike_<lado>_<orden>.base y, si no está, se guarda ahí.
+inline std::shared_ptr<const Base> obtenerBase(int lado, int orden, const std::string &carpeta = "") {
+    static std::mutex mtx;
+    static std::map<std::pair<int, int>, std::shared_ptr<const Base>> cache;
+    std::lock_guard<std::mutex> lock(mtx);
+    auto &base = cache[{lado, orden}];
+    if (base) return base;
+
+    const std::string ruta =
+        carpeta.empty() ? "" : carpeta + "/zernike_" + std::to_string(lado) + "_" + std::to_string(orden) + ".base";
+    auto nueva = std::make_shared<Base>();
+    if (ruta.empty() || !nueva->cargar(ruta, lado, orden)) {
+        *nueva = Base(lado, orden);
+        if (!ruta.empty()) nueva->guardar(ruta);
+    }
+    base = nueva;
+    return base;
+}
+
+// Función para calcular los momentos de N imágenes de un canal de base.lado x base.lado con un
+// único producto de matrices: los píxeles de cada imagen en una fila (float32) por la base
+// traspuesta, en bloques de 'imagenesBloque' imágenes repartidos entre hilos. Retorna N x
+// numMomentos(base.orden) magnitudes (CV_64F), normalizadas por la suma de intensidades como en
+// momentos(); equivale a momentos(img, orden, lado / 2, ..., Centro::Imagen) salvo el redondeo a
+// float32.
+inline cv::Mat momentosLote(const std::vector<cv::Mat> &imagenes, const Base &base) {
+    const int n = static_cast<int>(imagenes.size());
+    const int k = numMomentos(base.orden);
+    cv::Mat resultado = cv::Mat::zeros(n, k, CV_64F);
+    const int bloques = (n + imagenesBloque - 1) / imagenesBloque;
+
+    cv::parallel_for_(cv::Range(0, bloques), [&](const cv::Range &rango) {
+        cv::Mat pixeles, complejos;
+        for (int b = rango.start; b < rango.end; b++) {
+            const int inicio = b * imagenesBloque, fin = std::min(n, inicio + imagenesBloque);
+            pixeles.create(fin - inicio, base.lado * base.lado, CV_32F);
+            for (int i = inicio; i < fin; i++) {
+                const cv::Mat &img = imagenes[i];
+                CV_Assert(img.channels() == 1 && img.rows == base.lado && img.cols == base.lado);
+                cv::Mat fila = pixeles.row(i - inicio);  // Vista: convertTo escribe en 'pixeles'
+                cv::Mat(img.isContinuous() ? img : img.clone()).reshape(1, 1).convertTo(fila, CV_32F);
+            }
+            cv::gemm(pixeles, base.matriz, 1.0, cv::noArray(), 0.0, complejos, cv::GEMM_2_T);
+            for (int i = inicio; i < fin; i++) {
+                const double suma = cv::sum(pixeles.row(i - inicio))[0];
+                if (suma == 0.0) continue;
+                const float *c = complejos.ptr<float>(i - inicio);
+                double *z = resultado.ptr<double>(i);
+                for (int j = 0; j < k; j++) z[j] = std::hypot(c[2 * j], c[2 * j + 1]) / suma;
+            }
+        }
+    });
+    return resultado;
+}
+
+// Función para calcular los momentos de una imagen con una base (lote de una imagen)
+inline std::vector<double> momentos(const cv::Mat &img, const Base &base) {
+    cv::Mat z = momentosLote({img}, base);
+    return std::vector<double>(z.ptr<double>(0), z.ptr<double>(0) + z.cols);
+}
+
+} // namespace zernike
@@ -0,0 +1,241 @@
+#include "momentos_core.hpp"
+
+#include <cmath>
+#include <sstream>
+#include "traza.hpp"
+
+using namespace cv;
+using namespace std;
+
+namespace momentos {
+
+// --------------------------------------------------------------------------
+// Función: calcularDistancia
+// Calcula la distancia Manhattan entre dos vectores.
+double calcularDistancia(const vector<double>& a, const vector<double>& b) {
+    double distancia = 0.0;
+    for (size_t i = 0; i < a.size(); i++) {
+        distancia += fabs(a[i] - b[i]);
+    }
+    return distancia;
+}
+
+// --------------------------------------------------------------------------
+// Función: normalizar
+// Normaliza un vector usando Z-score.
+vector<double> normalizar(const vector<double>& vec) {
+    double suma = 0.0;
+    for (double v : vec) {
+        suma += v;
+    }
+    double media = suma / vec.size();
+    double varianza = 0.0;
+    for (double v : vec) {
+        varianza += pow(v - media, 2);
+    }
+    double desviacion = sqrt(varianza / vec.size());
+    vector<double> normalizado;
+    for (double v : vec) {
+        // Evitar división por cero
+        if (desviacion != 0)
+            normalizado.push_back((v - media) / desviacion);
+        else
+            normalizado.push_back(0.0);
+    }
+    return normalizado;
+}
+
+// --------------------------------------------------------------------------
+// Función: calcularMomentosHu
+// Calcula los 7 momentos de Hu a partir de una imagen (se espera imagen ya preprocesada).
+vector<double> calcularMomentosHu(const Mat& imagen) {
+    TRAZA_AMBITO("momentos_hu");
+    Moments m = mascara::momentosBinarios(imagen).aMoments();
+    double hu[7];
+    HuMoments(m, hu);
+    vector<double> momentos(hu, hu + 7);
+    return momentos;
+}
+
+// --------------------------------------------------------------------------
+// Función: transformarHu
+// Aplica la transformación logarítmica a los momentos de Hu para mejorar su discriminación.
+vector<double> transformarHu(const vector<double>& hu) {
+    vector<double> huLog;
+    for (double val : hu) {
+        // Evitar log(0) y preservar el signo
+        double trans = (fabs(val) > 1e-10) ? -copysign(log10(fabs(val)), val) : 0;
+        huLog.push_back(trans);
+    }
+    return huLog;
+}
+
+// --------------------------------------------------------------------------
+// Función: contornoPrincipal
+// Se convierte la imagen a escala de grises, se aplica un umbral inverso y se utiliza un
+// "closing" morfológico para rellenar huecos. Retorna el contorno externo de mayor área (vacío si
+// no hay ninguno con área).
+vector<Point> contornoPrincipal(const Mat& img) {
+    Mat gris, binary;
+
+    // Convertir a escala de grises
+    {
+        TRAZA_AMBITO("gris");
+        cvtColor(img, gris, COLOR_BGR2GRAY);
+    }
+
+    // Aplicar umbral (similar a THRESH_BINARY_INV con valor 235)
+    {
+        TRAZA_AMBITO("umbral");
+        threshold(gris, binary, 235, 255, THRESH_BINARY_INV);
+    }
+
+    // Operación morfológica: closing para rellenar huecos
+    {
+        TRAZA_AMBITO("cierre");
+        Mat kernel = getStructuringElement(MORPH_RECT, Size(3,3));
+        morphologyEx(binary, binary, MORPH_CLOSE, kernel);
+    }
+
+    // Encontrar contornos en la imagen umbralizada
+    vector<vector<Point>> contornos;
+    vector<Vec4i> hierarchy;
+    {
+        TRAZA_AMBITO("contornos");
+        findContours(binary, contornos, hierarchy, RETR_EXTERNAL, CHAIN_APPROX_SIMPLE);
+    }
+
+    // Seleccionar el contorno con mayor área
+    double maxArea = 0;
+    int idxMax = -1;
+    for (size_t i = 0; i < contornos.size(); i++) {
+        double area = contourArea(contornos[i]);
+        if (area > maxArea) {
+            maxArea = area;
+            idxMax = static_cast<int>(i);
+        }
+    }
+    return idxMax >= 0 ? contornos[idxMax] : vector<Point>();
+}
+
+// --------------------------------------------------------------------------
+// Función: preprocesarImagen
+// Modificada para utilizar operaciones morfológicas. Se extrae y rellena el contorno de mayor
+// área (ver contornoPrincipal) para generar una máscara sólida.
+Mat preprocesarImagen(const Mat& img) {
+    vector<Point> contorno = contornoPrincipal(img);
+
+    // Crear una máscara negra y rellenar el contorno en ella
+    Mat mask = Mat::zeros(img.size(), CV_8UC1);
+    if (!contorno.empty()) {
+        TRAZA_AMBITO("rellenar");
+        drawContours(mask, vector<vector<Point>>{contorno}, 0, Scalar(255), FILLED);
+    }
+    return mask;
+}
+
+// --------------------------------------------------------------------------
+// Función: momentosHuContorno
+// Momentos de Hu del polígono del contorno principal, calculados a partir de sus vértices con el
+// teorema de Green (cv::moments sobre el contorno). No se rellena ni se recorre ninguna máscara:
+// el coste de esta etapa depende del número de vértices, no del tamaño de la imagen.
+vector<double> momentosHuContorno(const Mat& img) {
+    vector<Point> contorno = contornoPrincipal(img);
+    Moments m;
+    if (!contorno.empty()) {
+        TRAZA_AMBITO("momentos_contorno");
+        m = moments(contorno);
+    }
+    double hu[7];
+    HuMoments(m, hu);
+    return vector<double>(hu, hu + 7);
+}
+
+// --------------------------------------------------------------------------
+// Función: momentosHuFigura
+// Une preprocesarImagen y calcularMomentosHu: gris, umbral y cierre se hacen fila a fila sobre
+// tramos y los momentos se acumulan por región, sin crear las imágenes intermedias.
+vector<double> momentosHuFigura(const Mat& img, mascara::FormatoPixel formato) {
+    CV_Assert(img.depth() == CV_8U && img.channels() == mascara::bytesPorPixel(formato));
+    mascara::MascaraBits umbralizada;
+    {
+        TRAZA_AMBITO("umbral");
+        mascara::umbralizarImagen(img.ptr<uchar>(), img.step[0], img.cols, img.rows, formato, 235, umbralizada);
+    }
+    return momentosHuUmbralizada(umbralizada);
+}
+
+// --------------------------------------------------------------------------
+// Función: momentosHuUmbralizada
+// Cierre morfológico, relleno de la figura principal y momentos de Hu desde la máscara en bits.
+vector<double> momentosHuUmbralizada(const mascara::MascaraBits& umbralizada) {
+    Moments m;
+    {
+        TRAZA_AMBITO("momentos_figura");
+        vector<mascara::Tramo> tramos;
+        vector<int> inicioFila;
+        mascara::tramosCierre(umbralizada, tramos, inicioFila);
+        m = mascara::momentosRegionMayor(tramos, inicioFila, umbralizada.ancho).aMoments();
+    }
+    double hu[7];
+    HuMoments(m, hu);
+    return vector<double>(hu, hu + 7);
+}
+
+// --------------------------------------------------------------------------
+// Función: parsearMomentosCSV
+// Interpreta el contenido del CSV de momentos y retorna un vector de pares: (nombre_clase, vector_de_momentos).
+vector<pair<string, vector<double>>> parsearMomentosCSV(const string& contenido) {
+    vector<pair<string, vector<double>>> momentos;
+    stringstream ss(contenido);
+    string linea;
+    while(getline(ss, linea)) {
+        stringstream ls(linea);
+        string clase;
+        getline(ls, clase, ',');
+        vector<double> vec;
+        string token;
+        while(getline(ls, token, ',')) {
+            try {
+                vec.push_back(stod(token));
+            } catch (...) {
+                // Ignorar errores de conversión
+            }
+        }
+        if (vec.size() == 7)
+            momentos.push_back({clase, vec});
+    }
+    return momentos;
+}
+
+// --------------------------------------------------------------------------
+// Clase: ModeloReferencias
+ModeloReferencias::ModeloReferencias(const vector<pair<string, vector<double>>>& momentos) {
+    TRAZA_AMBITO("modelo_cargar");
+    vector<pair<string, vector<double>>> normalizados;
+    normalizados.reserve(momentos.size());
+    for (const auto& [clase, vec] : momentos) {
+        if (vec.size() == static_cast<size_t>(dimension)) {
+            normalizados.push_back({clase, normalizar(vec)});
+        }
+    }
+    indice = knn::IndiceKNN(normalizados, knn::Metrica::Manhattan);
+}
+
+ModeloReferencias ModeloReferencias::desdeCSV(const string& contenido) {
+    return ModeloReferencias(parsearMomentosCSV(contenido));
+}
+
+Clasificacion ModeloReferencias::clasificar(const vector<double>& consulta, int k, knn::Voto voto) const {
+    TRAZA_AMBITO("clasificar");
+    CV_Assert(consulta.size() == static_cast<size_t>(dimension));
+    Clasificacion resultado;
+    if (indice.size() == 0) return resultado;
+    // Una sola búsqueda: el más cercano da la distancia y los k vecinos votan la clase
+    const vector<knn::Vecino> vecinos = indice.buscar(consulta, max(k, 1));
+    resultado.distancia = vecinos[0].distancia;
+    resultado.clase = indice.votar(vecinos, voto);
+    return resultado;
+}
+
+} // namespace momentos
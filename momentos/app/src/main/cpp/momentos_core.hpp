@@ -0,0 +1,79 @@
+#pragma once
+
+// Núcleo de procesamiento de la librería nativa, sin dependencias de JNI ni de Android, para
+// poder compilarlo y medirlo también en el computador (ver benchmarks/).
+
+#include <cfloat>
+#include <string>
+#include <utility>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "knn.hpp"
+#include "momentos_mascara.hpp"
+
+namespace momentos {
+
+// Calcula la distancia Manhattan entre dos vectores.
+double calcularDistancia(const std::vector<double>& a, const std::vector<double>& b);
+
+// Normaliza un vector usando Z-score.
+std::vector<double> normalizar(const std::vector<double>& vec);
+
+// Calcula los 7 momentos de Hu a partir de una imagen (se espera imagen ya preprocesada).
+std::vector<double> calcularMomentosHu(const cv::Mat& imagen);
+
+// Aplica la transformación logarítmica a los momentos de Hu para mejorar su discriminación.
+std::vector<double> transformarHu(const std::vector<double>& hu);
+
+// Contorno externo de mayor área tras umbral y cierre (vacío si no hay figura).
+std::vector<cv::Point> contornoPrincipal(const cv::Mat& img);
+
+// Genera la máscara sólida del contorno de mayor área (ver momentos_core.cpp).
+cv::Mat preprocesarImagen(const cv::Mat& img);
+
+// Momentos de Hu del polígono del contorno principal, desde sus vértices (teorema de Green), sin
+// rellenar la máscara. El área del polígono pasa por los centros de los píxeles del borde, así
+// que los valores difieren ligeramente de los de la máscara rellena (ver benchmarks/).
+std::vector<double> momentosHuContorno(const cv::Mat& img);
+
+// Momentos de Hu de la figura principal directamente desde la imagen en color, sin generar la
+// máscara: equivale a calcularMomentosHu(preprocesarImagen(img)) (ver momentos_mascara.hpp).
+std::vector<double> momentosHuFigura(const cv::Mat& img, mascara::FormatoPixel formato = mascara::FormatoPixel::BGR);
+
+// Igual que momentosHuFigura, pero a partir de la imagen ya umbralizada con
+// mascara::umbralizarImagen (umbral 235). Permite liberar el búfer de píxeles antes del cierre.
+std::vector<double> momentosHuUmbralizada(const mascara::MascaraBits& umbralizada);
+
+// Interpreta el contenido del CSV de momentos: (nombre_clase, vector_de_momentos) por línea.
+std::vector<std::pair<std::string, std::vector<double>>> parsearMomentosCSV(const std::string& contenido);
+
+// Resultado de clasificar una figura: clase de la referencia más cercana y su distancia.
+struct Clasificacion {
+    std::string clase = "Desconocido";
+    double distancia = DBL_MAX;
+};
+
+// Tabla de momentos de referencia lista para clasificar. Se interpreta y normaliza una sola vez
+// (al cargar la librería o en la primera clasificación) y se reutiliza en cada llamada: los
+// vectores normalizados se guardan en un índice k-NN (comun/knn.hpp) sobre un arreglo de float.
+class ModeloReferencias {
+public:
+    static constexpr int dimension = 7;
+
+    explicit ModeloReferencias(const std::vector<std::pair<std::string, std::vector<double>>>& momentos);
+
+    // Construye el modelo a partir del contenido del CSV de momentos.
+    static ModeloReferencias desdeCSV(const std::string& contenido);
+
+    // Clasificación por distancia Manhattan a las referencias normalizadas, por votación entre
+    // los k más cercanas; 'distancia' es la de la más cercana. 'consulta' ya debe estar
+    // normalizada. Con k = 1 y en caso de empate gana la primera referencia, como antes.
+    Clasificacion clasificar(const std::vector<double>& consulta, int k = 1, knn::Voto voto = knn::Voto::Mayoria) const;
+
+    size_t numReferencias() const { return indice.size(); }
+
+private:
+    knn::IndiceKNN indice;
+};
+
+} // namespace momentos
@@ -7,129 +7,29 @@
 #include <android/asset_manager.h>
 #include <android/asset_manager_jni.h>
 #include <cfloat>
+#include <memory>
+#include <mutex>
 #include <android/bitmap.h>
 #include <android/log.h>
 #include <opencv2/opencv.hpp>
+#include "momentos_core.hpp"
+#include "traza.hpp"
 
 using namespace cv;
 using namespace std;
+using namespace momentos;
 
 #define LOG_TAG "native-lib"
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
 
-// --------------------------------------------------------------------------
-// Función: calcularDistancia
-// Calcula la distancia Manhattan entre dos vectores.
-double calcularDistancia(const vector<double>& a, const vector<double>& b) {
-    double distancia = 0.0;
-    for (size_t i = 0; i < a.size(); i++) {
-        distancia += fabs(a[i] - b[i]);
-    }
-    return distancia;
-}
-
-// --------------------------------------------------------------------------
-// Función: normalizar
-// Normaliza un vector usando Z-score.
-vector<double> normalizar(const vector<double>& vec) {
-    double suma = 0.0;
-    for (double v : vec) {
-        suma += v;
-    }
-    double media = suma / vec.size();
-    double varianza = 0.0;
-    for (double v : vec) {
-        varianza += pow(v - media, 2);
-    }
-    double desviacion = sqrt(varianza / vec.size());
-    vector<double> normalizado;
-    for (double v : vec) {
-        // Evitar división por cero
-        if (desviacion != 0)
-            normalizado.push_back((v - media) / desviacion);
-        else
-            normalizado.push_back(0.0);
-    }
-    return normalizado;
-}
-
-// --------------------------------------------------------------------------
-// Función: calcularMomentosHu
-// Calcula los 7 momentos de Hu a partir de una imagen (se espera imagen ya preprocesada).
-vector<double> calcularMomentosHu(const Mat& imagen) {
-    Moments m = moments(imagen, true);
-    double hu[7];
-    HuMoments(m, hu);
-    vector<double> momentos(hu, hu + 7);
-    return momentos;
-}
-
-// --------------------------------------------------------------------------
-// Función: transformarHu
-// Aplica la transformación logarítmica a los momentos de Hu para mejorar su discriminación.
-vector<double> transformarHu(const vector<double>& hu) {
-    vector<double> huLog;
-    for (double val : hu) {
-        // Evitar log(0) y preservar el signo
-        double trans = (fabs(val) > 1e-10) ? -copysign(log10(fabs(val)), val) : 0;
-        huLog.push_back(trans);
-    }
-    return huLog;
-}
-
-// --------------------------------------------------------------------------
-// Función: preprocesarImagen
-// Modificada para utilizar operaciones morfológicas. Se convierte la imagen a escala de grises,
-// se aplica un umbral inverso y se utiliza un "closing" morfológico para rellenar huecos.
-// Finalmente se extrae y rellena el contorno de mayor área para generar una máscara sólida.
-Mat preprocesarImagen(const Mat& img) {
-    Mat gris, binary;
-
-    // Convertir a escala de grises
-    cvtColor(img, gris, COLOR_BGR2GRAY);
-
-    // Aplicar umbral (similar a THRESH_BINARY_INV con valor 235)
-    threshold(gris, binary, 235, 255, THRESH_BINARY_INV);
-
-    // Operación morfológica: closing para rellenar huecos
-    Mat kernel = getStructuringElement(MORPH_RECT, Size(3,3));
-    morphologyEx(binary, binary, MORPH_CLOSE, kernel);
-
-    // Encontrar contornos en la imagen umbralizada
-    vector<vector<Point>> contornos;
-    vector<Vec4i> hierarchy;
-    findContours(binary, contornos, hierarchy, RETR_EXTERNAL, CHAIN_APPROX_SIMPLE);
-
-    // Crear una máscara negra
-    Mat mask = Mat::zeros(binary.size(), CV_8UC1);
-
-    // Seleccionar el contorno con mayor área y rellenarlo en la máscara
-    if (!contornos.empty()) {
-        double maxArea = 0;
-        int idxMax = -1;
-        for (size_t i = 0; i < contornos.size(); i++) {
-            double area = contourArea(contornos[i]);
-            if (area > maxArea) {
-                maxArea = area;
-                idxMax = static_cast<int>(i);
-            }
-        }
-        if (idxMax >= 0) {
-            drawContours(mask, contornos, idxMax, Scalar(255), FILLED);
-        }
-    }
-    return mask;
-}
-
 // --------------------------------------------------------------------------
 // Función: leerMomentosDesdeCSV
 // Lee el CSV de momentos (almacenado en assets) y retorna un vector de pares: (nombre_clase, vector_de_momentos).
 vector<pair<string, vector<double>>> leerMomentosDesdeCSV(AAssetManager* mgr, const string& filename) {
-    vector<pair<string, vector<double>>> momentos;
     AAsset* asset = AAssetManager_open(mgr, filename.c_str(), AASSET_MODE_STREAMING);
     if (!asset) {
         LOGE("No se pudo abrir el asset %s", filename.c_str());
-        return momentos;
+        return {};
     }
     size_t fileLength = AAsset_getLength(asset);
     string fileContent;
@@ -137,83 +37,105 @@ vector<pair<string, vector<double>>> leerMomentosDesdeCSV(AAssetManager* mgr, co
     AAsset_read(asset, &fileContent[0], fileLength);
     AAsset_close(asset);
 
-    stringstream ss(fileContent);
-    string linea;
-    while(getline(ss, linea)) {
-        stringstream ls(linea);
-        string clase;
-        getline(ls, clase, ',');
-        vector<double> vec;
-        string token;
-        while(getline(ls, token, ',')) {
-            try {
-                vec.push_back(stod(token));
-            } catch (...) {
-                // Ignorar errores de conversión
-            }
+    return parsearMomentosCSV(fileContent);
+}
+
+// --------------------------------------------------------------------------
+// Modelo de referencias compartido entre llamadas. Se crea en cargarModelo (al iniciar la
+// actividad) o, si no se llamó, en el primer procesarDibujo.
+static mutex mtxModelo;
+static shared_ptr<const ModeloReferencias> modelo;
+
+// Función auxiliar: obtenerModelo
+// Retorna el modelo cargado, creándolo desde assets si todavía no existe. Si el CSV no se pudo
+// leer no se guarda nada, para volver a intentarlo en la siguiente llamada.
+shared_ptr<const ModeloReferencias> obtenerModelo(AAssetManager* mgr, bool recargar) {
+    lock_guard<mutex> lock(mtxModelo);
+    if ((!modelo || recargar) && mgr) {
+        auto nuevo = make_shared<const ModeloReferencias>(leerMomentosDesdeCSV(mgr, "momentos.csv"));
+        if (nuevo->numReferencias() > 0) {
+            modelo = nuevo;
         }
-        if (vec.size() == 7)
-            momentos.push_back({clase, vec});
     }
-    return momentos;
+    return modelo;
 }
 
 // --------------------------------------------------------------------------
-// Función auxiliar: bitmapToMat
-// Convierte un objeto Bitmap de Android a un cv::Mat (se asume formato ARGB_8888).
-// Función auxiliar: bitmapToMat
-// Convierte un objeto Bitmap de Android a un cv::Mat.
+// Función auxiliar: formatoBitmap
+// Formato de píxel de la máscara para el Bitmap: RGBA_8888 o RGB_565.
+bool formatoBitmap(const AndroidBitmapInfo& info, mascara::FormatoPixel& formato) {
+    if (info.format == ANDROID_BITMAP_FORMAT_RGBA_8888) {
+        formato = mascara::FormatoPixel::RGBA;
+    } else if (info.format == ANDROID_BITMAP_FORMAT_RGB_565) {
+        formato = mascara::FormatoPixel::RGB565;
+    } else {
+        LOGE("Formato de Bitmap no soportado: %d", info.format);
+        return false;
+    }
+    return true;
+}
+
+// --------------------------------------------------------------------------
+// Función auxiliar: umbralizarBitmap
+// Umbraliza el Bitmap directamente desde sus píxeles bloqueados, en una pasada y sin copiarlo a
+// un cv::Mat BGR: el gris se calcula con los mismos coeficientes de cvtColor y el resultado es
+// la máscara en bits (ver comun/momentos_mascara.hpp). El Bitmap se desbloquea en cuanto termina
+// esa pasada, antes del cierre y de los momentos.
 // Soporta tanto ANDROID_BITMAP_FORMAT_RGBA_8888 como ANDROID_BITMAP_FORMAT_RGB_565.
-bool bitmapToMat(JNIEnv* env, jobject bitmap, Mat& mat) {
+bool umbralizarBitmap(JNIEnv* env, jobject bitmap, mascara::MascaraBits& umbralizada) {
     AndroidBitmapInfo info;
     if (AndroidBitmap_getInfo(env, bitmap, &info) < 0) {
         LOGE("Error al obtener la información del Bitmap");
         return false;
     }
 
+    mascara::FormatoPixel formato;
+    if (!formatoBitmap(info, formato)) {
+        return false;
+    }
+
     void* pixels = nullptr;
     if (AndroidBitmap_lockPixels(env, bitmap, &pixels) < 0) {
         LOGE("Error al bloquear los píxeles del Bitmap");
         return false;
     }
+    // Umbral 235, el mismo de preprocesarImagen
+    mascara::umbralizarImagen(static_cast<const uchar*>(pixels), info.stride, info.width, info.height, formato, 235,
+                              umbralizada);
+    AndroidBitmap_unlockPixels(env, bitmap);
+    return true;
+}
 
-    if (info.format == ANDROID_BITMAP_FORMAT_RGBA_8888) {
-        // Procesamiento para formato RGBA_8888
-        mat = Mat(info.height, info.width, CV_8UC4, pixels).clone();
-        AndroidBitmap_unlockPixels(env, bitmap);
-        cvtColor(mat, mat, COLOR_RGBA2BGR);
-        return true;
-    } else if (info.format == ANDROID_BITMAP_FORMAT_RGB_565) {
-        // Procesamiento para formato RGB_565
-        // Se creará una imagen de 3 canales (BGR)
-        mat = Mat(info.height, info.width, CV_8UC3);
-        uint16_t* src = (uint16_t*) pixels;
-        for (int y = 0; y < info.height; y++) {
-            for (int x = 0; x < info.width; x++) {
-                uint16_t pixel = src[y * info.width + x];
-                // Extraer cada canal:
-                // - Rojo: bits 11-15 (5 bits)
-                // - Verde: bits 5-10 (6 bits)
-                // - Azul: bits 0-4 (5 bits)
-                uint8_t r = (pixel >> 11) & 0x1F;
-                uint8_t g = (pixel >> 5) & 0x3F;
-                uint8_t b = pixel & 0x1F;
-                // Escalar a 8 bits por canal
-                r = (r * 255) / 31;
-                g = (g * 255) / 63;
-                b = (b * 255) / 31;
-                mat.at<Vec3b>(y, x) = Vec3b(b, g, r);
-            }
-        }
-        AndroidBitmap_unlockPixels(env, bitmap);
-        return true;
-    } else {
-        LOGE("Formato de Bitmap no soportado: %d", info.format);
-        AndroidBitmap_unlockPixels(env, bitmap);
-        return false;
+
+// --------------------------------------------------------------------------
+// Función auxiliar: clasificarUmbralizada
+// Calcula los momentos de Hu de la figura principal de una máscara umbralizada, los clasifica
+// contra el modelo de referencias y formatea el resultado para mostrarlo en pantalla.
+string clasificarUmbralizada(const mascara::MascaraBits& umbralizada, AAssetManager* mgr) {
+    // Momentos de Hu con la transformación logarítmica
+    vector<double> momentosFigura = momentosHuUmbralizada(umbralizada);
+    vector<double> momentosFiguraTrans = transformarHu(momentosFigura);
+    vector<double> momentosFiguraNorm = normalizar(momentosFiguraTrans);
+
+    // Clasificación por distancia mínima contra las referencias ya normalizadas
+    shared_ptr<const ModeloReferencias> referencias;
+    {
+        TRAZA_AMBITO("modelo");
+        referencias = obtenerModelo(mgr, false);
+    }
+    Clasificacion clasificacion;
+    if (referencias) {
+        clasificacion = referencias->clasificar(momentosFiguraNorm);
     }
-}
 
+    // Formatear los momentos para mostrarlos en pantalla
+    string resultado = "Momentos de Hu:\n";
+    for (size_t i = 0; i < momentosFiguraNorm.size(); i++) {
+        resultado += "H" + to_string(i+1) + ": " + to_string(momentosFiguraNorm[i]) + "\n";
+    }
+    resultado += "\nClasificación: " + clasificacion.clase;
+    return resultado;
+}
 
 // --------------------------------------------------------------------------
 // Función nativa: procesarDibujo
@@ -221,43 +143,97 @@ bool bitmapToMat(JNIEnv* env, jobject bitmap, Mat& mat) {
 extern "C"
 JNIEXPORT jstring JNICALL
 Java_ec_edu_ups_momentos_MainActivity_procesarDibujo(JNIEnv *env, jobject /* this */, jobject bitmap, jobject assetManager) {
-    // 1. Convertir el Bitmap a cv::Mat
-    Mat imgOriginal;
-    if (!bitmapToMat(env, bitmap, imgOriginal)) {
-        return env->NewStringUTF("Error al convertir el Bitmap");
+    // 1. Umbralizar el Bitmap directamente desde sus píxeles
+    TRAZA_AMBITO("procesarDibujo");
+    mascara::MascaraBits umbralizada;
+    {
+        TRAZA_AMBITO("bitmap");
+        if (!umbralizarBitmap(env, bitmap, umbralizada)) {
+            return env->NewStringUTF("Error al convertir el Bitmap");
+        }
     }
 
-    // 2. Preprocesar la imagen utilizando operaciones morfológicas
-    //    Se obtiene una máscara sólida a partir del contorno de mayor área.
-    Mat imgPreprocesada = preprocesarImagen(imgOriginal);
+    // 2. Calcular los momentos de Hu de la figura principal (máscara sólida del contorno de
+    //    mayor área tras el cierre) y clasificarlos
+    string resultado = clasificarUmbralizada(umbralizada, AAssetManager_fromJava(env, assetManager));
+    return env->NewStringUTF(resultado.c_str());
+}
 
-    // 3. Calcular los momentos de Hu y aplicar la transformación logarítmica
-    vector<double> momentosFigura = calcularMomentosHu(imgPreprocesada);
-    vector<double> momentosFiguraTrans = transformarHu(momentosFigura);
-    vector<double> momentosFiguraNorm = normalizar(momentosFiguraTrans);
+// --------------------------------------------------------------------------
+// Función nativa: cargarModelo
+// Se invoca desde MainActivity al crearse para leer y normalizar las referencias una sola vez.
+// Retorna el número de referencias cargadas.
+extern "C"
+JNIEXPORT jint JNICALL
+Java_ec_edu_ups_momentos_MainActivity_cargarModelo(JNIEnv *env, jobject /* this */, jobject assetManager) {
+    auto referencias = obtenerModelo(AAssetManager_fromJava(env, assetManager), true);
+    return referencias ? static_cast<jint>(referencias->numReferencias()) : 0;
+}
 
-    // 4. Leer momentos almacenados en CSV para comparación
-    AAssetManager* mgr = AAssetManager_fromJava(env, assetManager);
-    vector<pair<string, vector<double>>> momentosBase = leerMomentosDesdeCSV(mgr, "momentos.csv");
+// --------------------------------------------------------------------------
+// Dibujo en curso para la clasificación en vivo: máscara umbralizada del DrawView que se
+// actualiza solo en las zonas que cambian (ver comun/momentos_mascara.hpp).
+static mutex mtxDibujo;
+static mascara::MascaraBits dibujo;
 
-    // 5. Clasificación por distancia mínima
-    string mejorClase = "Desconocido";
-    double menorDistancia = DBL_MAX;
+// Función nativa: reiniciarDibujo
+// Vacía la máscara del dibujo (lienzo en blanco) con el tamaño del Bitmap.
+extern "C"
+JNIEXPORT void JNICALL
+Java_ec_edu_ups_momentos_MainActivity_reiniciarDibujo(JNIEnv *env, jobject /* this */, jint ancho, jint alto) {
+    lock_guard<mutex> lock(mtxDibujo);
+    dibujo.crear(ancho, alto);
+}
 
-    for (const auto& [clase, momentos] : momentosBase) {
-        double distancia = calcularDistancia(momentosFiguraNorm, normalizar(momentos));
-        if (distancia < menorDistancia) {
-            menorDistancia = distancia;
-            mejorClase = clase;
-        }
+// Función nativa: actualizarDibujo
+// Vuelve a umbralizar solo el rectángulo [x0, x1) x [y0, y1) del Bitmap, el que cambió desde la
+// última actualización. Retorna false si el Bitmap no coincide con la máscara o no se pudo leer.
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_ec_edu_ups_momentos_MainActivity_actualizarDibujo(JNIEnv *env, jobject /* this */, jobject bitmap,
+                                                       jint x0, jint y0, jint x1, jint y1) {
+    TRAZA_AMBITO("actualizarDibujo");
+    AndroidBitmapInfo info;
+    if (AndroidBitmap_getInfo(env, bitmap, &info) < 0) {
+        LOGE("Error al obtener la información del Bitmap");
+        return JNI_FALSE;
+    }
+    mascara::FormatoPixel formato;
+    if (!formatoBitmap(info, formato)) {
+        return JNI_FALSE;
     }
 
-    // 6. Formatear los momentos para mostrarlos en pantalla
-    string resultado = "Momentos de Hu:\n";
-    for (size_t i = 0; i < momentosFiguraNorm.size(); i++) {
-        resultado += "H" + to_string(i+1) + ": " + to_string(momentosFiguraNorm[i]) + "\n";
+    lock_guard<mutex> lock(mtxDibujo);
+    if (dibujo.ancho != static_cast<int>(info.width) || dibujo.alto != static_cast<int>(info.height)) {
+        return JNI_FALSE;
+    }
+    void* pixels = nullptr;
+    if (AndroidBitmap_lockPixels(env, bitmap, &pixels) < 0) {
+        LOGE("Error al bloquear los píxeles del Bitmap");
+        return JNI_FALSE;
     }
-    resultado += "\nClasificación: " + mejorClase;
+    mascara::umbralizarZona(static_cast<const uchar*>(pixels), info.stride, formato, 235,
+                            Rect(x0, y0, x1 - x0, y1 - y0), dibujo);
+    AndroidBitmap_unlockPixels(env, bitmap);
+    return JNI_TRUE;
+}
 
+// Función nativa: consultarDibujo
+// Momentos de Hu y clasificación del dibujo en curso, sin volver a leer el Bitmap. Se llama desde
+// un hilo de fondo: bajo el candado solo se copia la máscara (unos 240 KB en un lienzo de
+// 1080x1794), de modo que actualizarDibujo no espera al cierre ni a los momentos.
+extern "C"
+JNIEXPORT jstring JNICALL
+Java_ec_edu_ups_momentos_MainActivity_consultarDibujo(JNIEnv *env, jobject /* this */, jobject assetManager) {
+    TRAZA_AMBITO("consultarDibujo");
+    mascara::MascaraBits copia;
+    {
+        lock_guard<mutex> lock(mtxDibujo);
+        copia = dibujo;
+    }
+    if (copia.ancho == 0 || copia.alto == 0) {
+        return env->NewStringUTF("Dibuja una figura");
+    }
+    string resultado = clasificarUmbralizada(copia, AAssetManager_fromJava(env, assetManager));
     return env->NewStringUTF(resultado.c_str());
 }
@@ -5,15 +5,31 @@ import android.graphics.Bitmap;
 import android.graphics.Canvas;
 import android.graphics.Paint;
 import android.graphics.Path;
+import android.graphics.Rect;
 import android.util.AttributeSet;
 import android.view.MotionEvent;
 import android.view.View;
 
 public class DrawView extends View {
+    /**
+     * Recibe los cambios del Bitmap para actualizar la clasificación mientras se dibuja.
+     */
+    public interface OnTrazoListener {
+        // El Bitmap se creó o se limpió: lienzo en blanco
+        void onLienzoNuevo(Bitmap bitmap);
+
+        // Se dibujó en el Bitmap dentro de 'zona' desde la última llamada
+        void onTrazo(Bitmap bitmap, Rect zona);
+    }
+
     private Paint paint;
     private Path path;
     private Bitmap bitmap;
     private Canvas bitmapCanvas;
+    private OnTrazoListener trazoListener;
+    // Zona del Bitmap que cambió desde el último onTrazo y último punto del trazo
+    private final Rect zonaPendiente = new Rect();
+    private float ultimoX, ultimoY;
 
     public DrawView(Context context, AttributeSet attrs) {
         super(context, attrs);
@@ -37,9 +53,32 @@ public class DrawView extends View {
             bitmap = Bitmap.createBitmap(getWidth(), getHeight(), Bitmap.Config.RGB_565);
             bitmapCanvas = new Canvas(bitmap);
             bitmap.eraseColor(0xFFFFFFFF); // Fondo blanco inicial
+            if (trazoListener != null) {
+                trazoListener.onLienzoNuevo(bitmap);
+            }
         }
         bitmapCanvas.drawPath(path, paint); // Dibuja en el Bitmap
         canvas.drawBitmap(bitmap, 0, 0, null); // Renderiza el Bitmap en la vista
+
+        if (trazoListener != null && !zonaPendiente.isEmpty()) {
+            trazoListener.onTrazo(bitmap, zonaPendiente);
+        }
+        zonaPendiente.setEmpty();
+    }
+
+    // Agrega a la zona pendiente el segmento (x0, y0) - (x1, y1) con el grosor del pincel. Se deja
+    // un margen de dos anchos para cubrir las uniones entre segmentos.
+    private void marcarSegmento(float x0, float y0, float x1, float y1) {
+        int margen = (int) Math.ceil(paint.getStrokeWidth() * 2);
+        zonaPendiente.union((int) Math.floor(Math.min(x0, x1)) - margen, (int) Math.floor(Math.min(y0, y1)) - margen,
+                (int) Math.ceil(Math.max(x0, x1)) + margen + 1, (int) Math.ceil(Math.max(y0, y1)) + margen + 1);
+    }
+
+    /**
+     * Registra quién recibe los cambios del Bitmap.
+     */
+    public void setOnTrazoListener(OnTrazoListener listener) {
+        trazoListener = listener;
     }
 
     @Override
@@ -50,11 +89,15 @@ public class DrawView extends View {
         switch (event.getAction()) {
             case MotionEvent.ACTION_DOWN:
                 path.moveTo(x, y); // Inicia el dibujo
+                marcarSegmento(x, y, x, y);
                 break;
             case MotionEvent.ACTION_MOVE:
                 path.lineTo(x, y); // Dibuja líneas a medida que se mueve el dedo
+                marcarSegmento(ultimoX, ultimoY, x, y);
                 break;
         }
+        ultimoX = x;
+        ultimoY = y;
         invalidate(); // Redibuja la vista
         return true;
     }
@@ -72,8 +115,12 @@ public class DrawView extends View {
      */
     public void clearCanvas() {
         path.reset();
+        zonaPendiente.setEmpty();
         if (bitmap != null) {
             bitmap.eraseColor(0xFFFFFFFF); // Limpia el Bitmap con color blanco
+            if (trazoListener != null) {
+                trazoListener.onLienzoNuevo(bitmap);
+            }
         }
         invalidate();
     }
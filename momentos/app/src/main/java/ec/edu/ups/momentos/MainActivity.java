@@ -2,12 +2,18 @@ package ec.edu.ups.momentos;
 
 import android.content.res.AssetManager;
 import android.graphics.Bitmap;
+import android.graphics.Rect;
 import android.os.Bundle;
 import android.view.View;
 import android.widget.Button;
 import android.widget.TextView;
 import androidx.appcompat.app.AppCompatActivity;
 
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.atomic.AtomicBoolean;
+import java.util.concurrent.atomic.AtomicInteger;
+
 public class MainActivity extends AppCompatActivity {
     // Carga la librería nativa
     static {
@@ -17,19 +23,58 @@ public class MainActivity extends AppCompatActivity {
     private DrawView drawView;
     private TextView textView;
 
+    // La clasificación en vivo corre en un hilo de fondo para no bloquear onDraw. Como mucho hay
+    // una consulta en curso y otra en espera: los trazos que llegan mientras tanto se agrupan en
+    // la que espera, que lee la máscara más reciente. Un resultado de un lienzo ya limpiado
+    // (otra generación) se descarta.
+    private final ExecutorService clasificador = Executors.newSingleThreadExecutor();
+    private final AtomicBoolean consultaEnEspera = new AtomicBoolean(false);
+    private final AtomicInteger generacion = new AtomicInteger();
+
     // Firma del método nativo: recibe el Bitmap del dibujo y el AssetManager para acceder a los assets
     private native String procesarDibujo(Bitmap bitmap, AssetManager assetManager);
 
+    // Lee y normaliza una sola vez las referencias de momentos.csv; retorna cuántas se cargaron
+    private native int cargarModelo(AssetManager assetManager);
+
+    // Clasificación en vivo: la máscara del dibujo se conserva en la librería nativa y solo se
+    // vuelve a umbralizar la zona que cambió en cada trazo
+    private native void reiniciarDibujo(int ancho, int alto);
+    private native boolean actualizarDibujo(Bitmap bitmap, int x0, int y0, int x1, int y1);
+    private native String consultarDibujo(AssetManager assetManager);
+
     @Override
     protected void onCreate(Bundle savedInstanceState) {
         super.onCreate(savedInstanceState);
         setContentView(R.layout.activity_main);
 
+        // Si falla, procesarDibujo vuelve a intentar cargar el modelo en la primera clasificación
+        cargarModelo(getAssets());
+
         drawView = findViewById(R.id.drawView);
         textView = findViewById(R.id.textView);
         Button btnClasificar = findViewById(R.id.btnClasificar);
         Button btnLimpiar = findViewById(R.id.btnLimpiar);
 
+        drawView.setOnTrazoListener(new DrawView.OnTrazoListener() {
+            @Override
+            public void onLienzoNuevo(Bitmap bitmap) {
+                // Primero se vacía la máscara: una consulta que ya vea la generación nueva no puede
+                // copiar la máscara anterior
+                reiniciarDibujo(bitmap.getWidth(), bitmap.getHeight());
+                generacion.incrementAndGet();
+            }
+
+            @Override
+            public void onTrazo(Bitmap bitmap, Rect zona) {
+                // Solo se umbraliza la zona nueva (O(píxeles del trazo)); el cierre, el relleno y
+                // los momentos de todo el lienzo se calculan en el hilo de fondo
+                if (actualizarDibujo(bitmap, zona.left, zona.top, zona.right, zona.bottom)) {
+                    solicitarClasificacion();
+                }
+            }
+        });
+
         btnClasificar.setOnClickListener(new View.OnClickListener() {
             @Override
             public void onClick(View v) {
@@ -52,4 +97,35 @@ public class MainActivity extends AppCompatActivity {
             }
         });
     }
+
+    @Override
+    protected void onDestroy() {
+        clasificador.shutdownNow();
+        super.onDestroy();
+    }
+
+    // Encola una clasificación del dibujo en curso si no hay ya una en espera
+    private void solicitarClasificacion() {
+        if (!consultaEnEspera.compareAndSet(false, true)) {
+            return;
+        }
+        final AssetManager assets = getAssets();
+        clasificador.execute(new Runnable() {
+            @Override
+            public void run() {
+                // Desde aquí, un trazo nuevo encola otra consulta
+                consultaEnEspera.set(false);
+                final int consultada = generacion.get();
+                final String clasificacion = consultarDibujo(assets);
+                runOnUiThread(new Runnable() {
+                    @Override
+                    public void run() {
+                        if (consultada == generacion.get() && !isDestroyed()) {
+                            textView.setText("Clasificación: " + clasificacion);
+                        }
+                    }
+                });
+            }
+        });
+    }
 }
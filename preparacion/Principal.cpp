@@ -4,155 +4,113 @@
 #include <filesystem>
 #include <cmath>
 #include <fstream>
+#include "momentos.hpp"
+#include "../comun/knn.hpp"
+#include "../comun/centroides.hpp"
 
 using namespace cv;
 using namespace std;
 namespace fs = std::filesystem;
 
-// Función para calcular la distancia euclidiana entre dos vectores
-double calcularDistancia(const vector<double>& a, const vector<double>& b) {
-    double distancia = 0.0;
-    for (size_t i = 0; i < a.size(); i++) {
-        distancia += abs(a[i] - b[i]);
-    }
-    return distancia;
-}
-
-// Función para normalizar un vector (normalización Z-score)
-vector<double> normalizar(const vector<double>& vec) {
-    double suma = 0.0;
-    for (double v : vec) {
-        suma += v;
-    }
-    double media = suma / vec.size();
-
-    double varianza = 0.0;
-    for (double v : vec) {
-        varianza += pow(v - media, 2);
-    }
-    double desviacion = sqrt(varianza / vec.size());
-
-    vector<double> normalizado;
-    for (double v : vec) {
-        normalizado.push_back((v - media) / desviacion);  // Normalización Z-score
-    }
-    return normalizado;
-}
-
-// Función para calcular los momentos de Hu de una imagen binaria
-vector<double> calcularMomentosHu(const Mat& imagen) {
-    Moments moments = cv::moments(imagen, true);
-    double huMoments[7];
-    HuMoments(moments, huMoments);
-
-    // Convertir los momentos a un vector
-    return vector<double>(huMoments, huMoments + 7);
-}
-
-// Función para aplicar preprocesamiento adicional (filtros, bordes, contraste)
-Mat preprocesarImagen(const Mat& img) {
-    Mat gray, blurred, edges;
-
-    // Convertir a escala de grises
-    cvtColor(img, gray, COLOR_BGR2GRAY);
+// Momentos de Hu usados por las funciones de abajo: de la imagen de bordes completa o, con
+// --contorno, del polígono de su contorno externo de mayor área
+bool usarContorno = false;
 
-    // Suavizado para reducir el ruido
-    GaussianBlur(gray, blurred, Size(5, 5), 0);
-
-    // Detección de bordes usando Canny
-    Canny(blurred, edges, 100, 200);
-
-    return edges;
+vector<double> momentosImagen(const Mat& imgPreprocesada) {
+    return usarContorno ? calcularMomentosHuContorno(imgPreprocesada) : calcularMomentosHu(imgPreprocesada);
 }
 
-// Función para procesar una carpeta y calcular los momentos promedio
-vector<double> calcularPromedioMomentos(const string& carpeta, const string& clase) {
-    vector<vector<double>> momentosClase;
+// Función para agregar al almacén de centroides las imágenes de una carpeta que el registro aún
+// no tiene (clave clase/archivo). Retorna cuántas imágenes nuevas se agregaron.
+size_t actualizarCentroides(centroides::Almacen& almacen, centroides::RegistroImagenes& registro, const string& carpeta,
+                            const string& clase) {
+    size_t nuevas = 0;
     for (const auto& entrada : fs::directory_iterator(carpeta)) {
-        Mat img = imread(entrada.path().string(), IMREAD_COLOR);
+        const string clave = clase + "/" + entrada.path().filename().string();
+        if (registro.incorporada(clave)) continue;
+        Mat img;
+        {
+            TRAZA_AMBITO("decodificar");
+            img = imread(entrada.path().string(), IMREAD_COLOR);
+        }
         if (img.empty()) continue;
 
         // Aplicar preprocesamiento adicional
         Mat imgPreprocesada = preprocesarImagen(img);
 
-        // Calcular los momentos de Hu de la imagen preprocesada
-        momentosClase.push_back(calcularMomentosHu(imgPreprocesada));
-    }
-
-    // Calcular el promedio de los momentos
-    vector<double> promedio(7, 0.0);
-    for (const auto& momentos : momentosClase) {
-        for (size_t i = 0; i < 7; i++) {
-            promedio[i] += momentos[i];
+        // Calcular los momentos de Hu de la imagen preprocesada y actualizar la media y la varianza
+        if (almacen.agregar(clase, momentosImagen(imgPreprocesada))) {
+            registro.anotar(clave);
+            nuevas++;
         }
     }
-
-    for (size_t i = 0; i < 7; i++) {
-        promedio[i] /= momentosClase.size();
-    }
-
-    //promedio = normalizar(promedio);
-    
-    // Guardar los momentos calculados en un archivo CSV
-    ofstream archivo("momentos_hu.csv", ios::app); // Abre el archivo en modo append
-    if (archivo.is_open()) {
-        archivo << clase; // Escribir el nombre de la clase
-        for (size_t i = 0; i < 7; i++) {
-            archivo << "," << promedio[i]; // Escribir los momentos
-        }
-        archivo << endl; // Nueva línea después de cada entrada
-        archivo.close();
-    } else {
-        cerr << "No se pudo abrir el archivo momentos_hu.csv." << endl;
-    }
-
-    return promedio;
+    return nuevas;
 }
 
-// Función para leer los momentos promedio desde un archivo CSV
-vector<pair<string, vector<double>>> leerMomentosDesdeCSV(const string& archivoCSV) {
-    vector<pair<string, vector<double>>> momentos;
-    ifstream archivo(archivoCSV);
-    if (!archivo.is_open()) {
-        cerr << "No se pudo abrir el archivo " << archivoCSV << endl;
-        return momentos;
+int main(int argc, char** argv) {
+    const String keys =
+        "{help h      |                   | Muestra esta ayuda }"
+        "{contorno    |                   | Calcula los momentos desde el polígono del contorno principal, sin recorrer la imagen }"
+        "{k           | 1                 | Vecinos más cercanos que votan la clase }"
+        "{referencias |                   | Momentos de referencia: CSV o binario (.bin, ver convertir_dataset); por defecto momentos_<descriptor>.csv }"
+        "{centroides  |                   | Media y varianza por clase; solo se agregan las imágenes nuevas (por defecto centroides_<descriptor>.csv) }"
+        "{mahalanobis |                   | Clasifica por la distancia de Mahalanobis diagonal a los centroides }";
+    CommandLineParser parser(argc, argv, keys);
+    if (parser.has("help")) {
+        parser.printMessage();
+        return 0;
     }
+    usarContorno = parser.has("contorno");
 
-    string linea;
-    while (getline(archivo, linea)) {
-        stringstream ss(linea);
-        string clase;
-        getline(ss, clase, ',');
-
-        vector<double> momentosClase;
-        string valor;
-        while (getline(ss, valor, ',')) {
-            momentosClase.push_back(stod(valor));
-        }
-        momentos.push_back({clase, momentosClase});
-    }
-    archivo.close();
-    return momentos;
-}
-
-int main() {
     // Directorios del dataset
     string carpetaCirculos = "/home/mateo/Escritorio/U/Vision_Computador/Unidad_3/Practicas/Practica_3.1/all-images/circle";
     string carpetaTriangulos = "/home/mateo/Escritorio/U/Vision_Computador/Unidad_3/Practicas/Practica_3.1/all-images/triangle";
     string carpetaCuadrados = "/home/mateo/Escritorio/U/Vision_Computador/Unidad_3/Practicas/Practica_3.1/all-images/square";
 
-    // Calcular los momentos promedio para cada clase
-    vector<double> momentosCirculo = calcularPromedioMomentos(carpetaCirculos, "Circulo");
-    vector<double> momentosTriangulo = calcularPromedioMomentos(carpetaTriangulos, "Triangulo");
-    vector<double> momentosCuadrado = calcularPromedioMomentos(carpetaCuadrados, "Cuadrado");
-
-    // Normalizar los momentos de Hu
-    momentosCirculo = normalizar(momentosCirculo);
-    momentosTriangulo = normalizar(momentosTriangulo);
-    momentosCuadrado = normalizar(momentosCuadrado);
+    // Actualizar la media y la varianza de cada clase con las imágenes nuevas. Cada descriptor
+    // ("hu" o "contorno") tiene sus propios archivos por defecto, y el almacén rechaza uno escrito
+    // con el otro descriptor.
+    const string descriptor = usarContorno ? "contorno" : "hu";
+    const string rutaCentroides = parser.get<string>("centroides").empty() ? "centroides_" + descriptor + ".csv"
+                                                                           : parser.get<string>("centroides");
+    const string rutaMedias = "momentos_" + descriptor + ".csv";
+
+    const string rutaRegistro = centroides::RegistroImagenes::rutaPara(rutaCentroides);
+
+    centroides::Almacen almacen(descriptor);
+    centroides::RegistroImagenes registro;
+    if (!almacen.cargar(rutaCentroides)) {
+        cerr << rutaCentroides << " está dañado o no es de momentos '" << descriptor
+             << "'; se vuelve a calcular desde cero." << endl;
+        almacen = centroides::Almacen(descriptor);
+        registro.reiniciar();
+    } else if (!registro.cargar(rutaRegistro, almacen.numMuestras())) {
+        cerr << rutaRegistro << " no cubre las muestras de " << rutaCentroides
+             << "; se vuelve a calcular desde cero." << endl;
+        almacen = centroides::Almacen(descriptor);
+        registro.reiniciar();
+    }
+    size_t nuevas = actualizarCentroides(almacen, registro, carpetaCirculos, "Circulo");
+    nuevas += actualizarCentroides(almacen, registro, carpetaTriangulos, "Triangulo");
+    nuevas += actualizarCentroides(almacen, registro, carpetaCuadrados, "Cuadrado");
+    cout << nuevas << " imágenes nuevas, " << almacen.numMuestras() << " en total" << endl;
+
+    // Guardar las estadísticas solo si hay imágenes nuevas. El registro va primero: si falla, el
+    // almacén anterior sigue coincidiendo con él.
+    if (nuevas > 0 && (!registro.guardar(rutaRegistro) || !almacen.guardar(rutaCentroides))) {
+        cerr << "No se pudo guardar " << rutaCentroides << endl;
+    }
+    // El CSV de centroides (una fila por clase, sin duplicados) se reescribe siempre que haya
+    // clases: un almacén al día puede no tener aún su archivo de medias, o tenerlo desactualizado,
+    // y ese archivo son las referencias por defecto
+    if (almacen.numClases() > 0 && dataset::escribirCSV(rutaMedias + ".tmp", almacen.medias())) {
+        fs::rename(rutaMedias + ".tmp", rutaMedias);
+    }
 
-    // Leer los momentos promedio desde el archivo CSV
-    vector<pair<string, vector<double>>> momentosReferencia = leerMomentosDesdeCSV("momentos_hu.csv");
+    // Leer los momentos de referencia (CSV o binario)
+    const string rutaReferencias =
+        parser.get<string>("referencias").empty() ? rutaMedias : parser.get<string>("referencias");
+    vector<pair<string, vector<double>>> momentosReferencia = leerMomentos(rutaReferencias);
 
     // Cargar la imagen que se desea clasificar
     Mat img = imread("/home/mateo/Escritorio/U/Vision_Computador/Unidad_3/Practicas/Practica_3.1/preparacion/testing/c15i-1.PNG", IMREAD_COLOR);
@@ -165,21 +123,34 @@ int main() {
     Mat imgPreprocesada = preprocesarImagen(img);
 
     // Calcular los momentos de Hu de la imagen preprocesada
-    vector<double> momentosFigura = calcularMomentosHu(imgPreprocesada);
-
-    // Clasificación por distancia
-    double menorDistancia = DBL_MAX;
-    string figuraClasificadaPorDistancia = "Desconocido";
-
-    for (const auto& referencia : momentosReferencia) {
-        double distancia = calcularDistancia(momentosFigura, referencia.second);
-        cout << "Distancia a " << referencia.first << ": " << distancia << endl;
-        if (distancia < menorDistancia) {
-            menorDistancia = distancia;
-            figuraClasificadaPorDistancia = referencia.first;
+    vector<double> momentosFigura = momentosImagen(imgPreprocesada);
+
+    // Verificación cruzada: momentos del polígono frente a los del mismo contorno rellenado
+    if (usarContorno) {
+        vector<double> momentosRelleno = calcularMomentosHuContornoRelleno(imgPreprocesada);
+        for (size_t i = 0; i < 7; i++) {
+            cout << "H" << i + 1 << " contorno: " << momentosFigura[i] << "  relleno: " << momentosRelleno[i] << endl;
         }
     }
 
+    // Clasificación por la distancia de Mahalanobis diagonal: cada componente se escala por la
+    // varianza de la clase
+    if (parser.has("mahalanobis")) {
+        for (const auto& [clase, media] : almacen.medias()) {
+            cout << "Mahalanobis a " << clase << ": "
+                 << centroides::Almacen::mahalanobis(*almacen.clase(clase), momentosFigura) << endl;
+        }
+        cout << "Clasificación por Mahalanobis: " << almacen.clasificar(momentosFigura) << endl;
+    }
+
+    // Clasificación por distancia (Manhattan) con el índice de vecinos más cercanos
+    knn::IndiceKNN indice(momentosReferencia, knn::Metrica::Manhattan);
+    const int k = max(1, parser.get<int>("k"));
+    for (const auto& vecino : indice.buscar(momentosFigura, k)) {
+        cout << "Distancia a " << indice.clase(vecino.indice) << ": " << vecino.distancia << endl;
+    }
+    string figuraClasificadaPorDistancia = indice.clasificar(momentosFigura, k);
+
     cout << "Clasificación por distancia: " << figuraClasificadaPorDistancia << endl;
 
     // Mostrar las imágenes
@@ -187,5 +158,6 @@ int main() {
     imshow("Imagen Preprocesada", imgPreprocesada);
 
     waitKey(0);
+    TRAZA_VOLCAR("traza.json");
     return 0;
 }
\ No newline at end of file
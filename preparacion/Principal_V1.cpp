@@ -1,14 +1,13 @@
 // Principal_V1.cpp
 
-// Definir ImageMatrix para que se interprete como cv::Mat
-#define ImageMatrix cv::Mat
-
 #include <opencv2/opencv.hpp>
 #include <iostream>
 #include <vector>
 #include <fstream>
 #include <sstream>
-#include "zernike.h"   // Ubicado en: /home/mateo/Aplicaciones/Librerias/opencv/pychrm/src/textures/zernike/zernike.h
+#include "momentos.hpp"
+#include "../comun/knn.hpp"
+#include "../comun/zernike.hpp"
 
 using namespace cv;
 using namespace std;
@@ -19,48 +18,28 @@ struct Figura {
     vector<double> momentos;
 };
 
+/// -------------------------------------------------------------------------
+/// Lado de la base precalculada de Zernike (0 = imagen original centrada en el centroide),
+/// carpeta donde se guardan las bases (vacía = solo en memoria) y umbral de binarización. Se
+/// configuran desde main y deben coincidir con los usados al generar el dataset (zernike_csv).
+int ladoBase = 0;
+string carpetaBases;
+double umbralZernike = 128;
+
 /// -------------------------------------------------------------------------
 /// Función: computeZernikeMomentsWrapper
-/// Función *wrapper* que invoca la función de la librería (mb_zernike2D) para calcular
-/// los momentos de Zernike a partir de una imagen. Se preprocesa la imagen (conversión a gris,
-/// umbralización) y se calcula un radio R para la normalización.
+/// Calcula los momentos de Zernike de una imagen con comun/zernike.hpp (misma definición y orden
+/// que mb_zernike2D de pychrm). Se preprocesa la imagen (conversión a gris, umbralización) y se
+/// usa como radio R la mitad del mínimo de ancho y alto. Con ladoBase > 0 la imagen se escala y
+/// los momentos salen de la base precalculada (centrada en la imagen, no en el centroide): el
+/// dataset debe haberse generado con el mismo lado.
 /// Parámetros:
 ///   - imagen: imagen de entrada (cv::Mat)
-///   - order: orden de los momentos (por ejemplo, 4)
+///   - order: orden máximo de los momentos (por ejemplo, 4); no tiene límite fijo
 /// Retorna:
-///   - vector<double> con los momentos de Zernike.
+///   - vector<double> con las magnitudes de los momentos de Zernike (zernike::numMomentos(order)).
 vector<double> computeZernikeMomentsWrapper(const Mat &imagen, int order) {
-    // Convertir la imagen a escala de grises
-    Mat gris;
-    if (imagen.channels() == 3)
-        cvtColor(imagen, gris, COLOR_BGR2GRAY);
-    else
-        gris = imagen.clone();
-    
-    // Umbralizar para obtener una imagen binaria.
-    // Ajusta THRESH_BINARY o THRESH_BINARY_INV según tus imágenes.
-    Mat binaria;
-    threshold(gris, binaria, 128, 255, THRESH_BINARY_INV);
-    
-    // Definir el radio R como la mitad del mínimo de ancho y alto
-    double R = min(binaria.cols, binaria.rows) / 2.0;
-    
-    // Reservar un buffer para los momentos (ajusta buffer_size según sea necesario)
-    const int buffer_size = 1000;
-    double *zvalues = new double[buffer_size];
-    long output_size = 0;
-    
-    // Llamar a la función de la librería.
-    // La firma es:
-    // void mb_zernike2D(const ImageMatrix &I, double D, double R, double *zvalues, long *output_size);
-    // Donde D es el orden (convertido a double).
-    mb_zernike2D(binaria, static_cast<double>(order), R, zvalues, &output_size);
-    
-    // Copiar los resultados a un vector y liberar el buffer
-    vector<double> momentos(zvalues, zvalues + output_size);
-    delete [] zvalues;
-    
-    return momentos;
+    return momentosZernike(imagen, order, ladoBase, carpetaBases, umbralZernike);
 }
 
 /// -------------------------------------------------------------------------
@@ -106,42 +85,58 @@ vector<Figura> cargarDatasetZernike(const string& archivoCSV) {
 }
 
 /// -------------------------------------------------------------------------
-/// Función: distanciaEuclidea
-/// Calcula la distancia euclídea entre dos vectores.
-double distanciaEuclidea(const vector<double>& a, const vector<double>& b) {
-    if (a.size() != b.size())
-        return 1e9;  // Evitar errores en caso de tamaños distintos
-
-    double suma = 0.0;
-    for (size_t i = 0; i < a.size(); i++) {
-        suma += pow(a[i] - b[i], 2);
+/// Función: crearIndice
+/// Construye el índice de vecinos más cercanos (distancia euclidiana) sobre el dataset.
+knn::IndiceKNN crearIndice(const vector<Figura>& dataset) {
+    vector<pair<string, vector<double>>> referencias;
+    referencias.reserve(dataset.size());
+    for (const auto& figura : dataset) {
+        referencias.push_back({figura.etiqueta, figura.momentos});
     }
-    return sqrt(suma);
+    return knn::IndiceKNN(referencias, knn::Metrica::Euclidea);
+}
+
+/// Construye el mismo índice directamente desde un dataset binario mapeado, sin pasar por un
+/// vector por figura.
+knn::IndiceKNN crearIndice(const dataset::DatasetMapeado& binario) {
+    vector<int> etiquetas(binario.etiquetas(), binario.etiquetas() + binario.filas());
+    return knn::IndiceKNN(binario.clases(), move(etiquetas), binario.porFilas(), binario.dimension(),
+                          knn::Metrica::Euclidea);
 }
 
 /// -------------------------------------------------------------------------
 /// Función: clasificarImagen
-/// Clasifica una imagen comparando sus momentos de Zernike con los del dataset.
-string clasificarImagen(const Mat& imagen, const vector<Figura>& dataset, int order = 4) {
+/// Clasifica una imagen comparando sus momentos de Zernike con los del dataset: votan sus k
+/// vecinos más cercanos (con k = 1, la figura más cercana).
+string clasificarImagen(const Mat& imagen, const knn::IndiceKNN& indice, int order = 4, int k = 1) {
     vector<double> momentosFigura = calcularMomentosZernike(imagen, order);
     if (momentosFigura.empty())
         return "No se pudo calcular";
+    if (static_cast<int>(momentosFigura.size()) != indice.dimensiones())
+        return "Desconocido";
 
-    string clasePredicha = "Desconocido";
-    double minDistancia = 1e9;
-    for (const auto& figura : dataset) {
-        double dist = distanciaEuclidea(momentosFigura, figura.momentos);
-        if (dist < minDistancia) {
-            minDistancia = dist;
-            clasePredicha = figura.etiqueta;
-        }
-    }
-    return clasePredicha;
+    return indice.clasificar(momentosFigura, k);
 }
 
 /// -------------------------------------------------------------------------
 /// Función principal
-int main() {
+int main(int argc, char** argv) {
+    const String keys =
+        "{help h  |                     | Muestra esta ayuda }"
+        "{dataset | dataset_zernike.csv | Momentos de Zernike de referencia: CSV o binario (.bin, ver convertir_dataset) }"
+        "{lado    | 0                   | Escala las imágenes a lado x lado y usa la base precalculada de Zernike (0 = imagen original) }"
+        "{bases   |                     | Carpeta donde guardar y reutilizar las bases precalculadas }"
+        "{umbral  | 128                 | Umbral de binarización (inverso) antes de los momentos }"
+        "{orden   | 4                   | Orden máximo de los momentos (el mismo del dataset) }";
+    CommandLineParser parser(argc, argv, keys);
+    if (parser.has("help")) {
+        parser.printMessage();
+        return 0;
+    }
+    ladoBase = max(0, parser.get<int>("lado"));
+    carpetaBases = parser.get<string>("bases");
+    umbralZernike = parser.get<double>("umbral");
+
     // 1. Ruta fija de la imagen a clasificar (modifícala según corresponda)
     string rutaImagen = "/home/mateo/Escritorio/U/Vision_Computador/Unidad_3/Practicas/Practica_3.1/preparacion/testing/ejemplo.png";
     Mat imagen = imread(rutaImagen, IMREAD_COLOR);
@@ -150,17 +145,24 @@ int main() {
         return -1;
     }
     
-    // 2. Cargar el dataset de momentos de Zernike desde el CSV
-    string rutaCSV = "dataset_zernike.csv";  // Asegúrate de que el CSV tenga el formato correcto
-    vector<Figura> dataset = cargarDatasetZernike(rutaCSV);
-    if (dataset.empty()) {
+    // 2. Cargar el dataset de momentos de Zernike (CSV o binario mapeado)
+    string rutaDataset = parser.get<string>("dataset");
+    knn::IndiceKNN indice;
+    if (dataset::esBinario(rutaDataset)) {
+        dataset::DatasetMapeado binario;
+        if (binario.abrir(rutaDataset))
+            indice = crearIndice(binario);
+    } else {
+        indice = crearIndice(cargarDatasetZernike(rutaDataset));
+    }
+    if (indice.size() == 0) {
         cout << "El dataset está vacío o no se pudo cargar." << endl;
         return -1;
     }
     
     // 3. Clasificar la imagen usando momentos de Zernike (orden 4, por ejemplo)
-    int order = 4;  // Puedes experimentar con otros órdenes
-    string resultado = clasificarImagen(imagen, dataset, order);
+    int order = max(0, parser.get<int>("orden"));  // Puedes experimentar con otros órdenes
+    string resultado = clasificarImagen(imagen, indice, order);
     cout << "La imagen se clasifica como: " << resultado << endl;
     
     // 4. Mostrar el resultado sobre la imagen original
@@ -0,0 +1,52 @@
+// Conversión entre los CSV de momentos (momentos.csv, momentos_hu.csv, figureshu.csv,
+// dataset_zernike.csv) y el formato binario de comun/dataset_binario.hpp.
+//
+//   ./convertir.bin --entrada=momentos_hu.csv --salida=momentos_hu.bin
+//   ./convertir.bin --entrada=figureshu.csv --ignorar=1 --salida=figureshu.bin
+//   ./convertir.bin --entrada=dataset_zernike.csv --cabecera --salida=dataset_zernike.bin
+//   ./convertir.bin --entrada=momentos_hu.bin --salida=momentos_hu.csv
+
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include "../comun/dataset_binario.hpp"
+
+using namespace std;
+using namespace cv;
+
+int main(int argc, char** argv) {
+    const String keys =
+        "{help h   |   | Muestra esta ayuda }"
+        "{entrada  |   | CSV o binario (.bin) de entrada }"
+        "{salida   |   | CSV o binario (.bin) de salida }"
+        "{cabecera |   | El CSV de entrada tiene una línea de cabecera (dataset_zernike.csv) }"
+        "{ignorar  | 0 | Columnas tras la clase que no son momentos (1 para el nombre de archivo de figureshu.csv) }";
+    CommandLineParser parser(argc, argv, keys);
+    if (parser.has("help") || !parser.has("entrada") || !parser.has("salida")) {
+        parser.printMessage();
+        return parser.has("help") ? 0 : -1;
+    }
+    string entrada = parser.get<string>("entrada");
+    string salida = parser.get<string>("salida");
+
+    // Leer la entrada en cualquiera de los dos formatos
+    vector<pair<string, vector<double>>> filas;
+    if (dataset::esBinario(entrada)) {
+        dataset::DatasetMapeado binario;
+        if (!binario.abrir(entrada))
+            return -1;
+        filas = binario.aPares();
+    } else {
+        filas = dataset::leerCSV(entrada, parser.has("cabecera"), max(0, parser.get<int>("ignorar")));
+    }
+    if (filas.empty()) {
+        cerr << "No hay filas en " << entrada << endl;
+        return -1;
+    }
+
+    bool ok = dataset::esBinario(salida) ? dataset::escribirBinario(salida, filas) : dataset::escribirCSV(salida, filas);
+    if (!ok)
+        return -1;
+    cout << filas.size() << " filas de dimensión " << filas[0].second.size() << ": " << entrada << " -> " << salida
+         << endl;
+    return 0;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+// Momentos de Hu del esqueleto de la figura, usados para generar figureshu.csv.
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+#include "../comun/esqueleto.hpp"   // Esqueletización (Zhang-Suen, sin ximgproc)
+#include "../comun/traza.hpp"
+
+// Función para calcular los Momentos de Hu después de la esqueletización
+inline void calculateHuMoments(const cv::Mat &image, std::vector<double> &huMoments)
+{
+    cv::Size targetSize(160, 160); // Tamaño objetivo
+    TRAZA_AMBITO("hu_esqueleto");
+    cv::Mat resizedImage;
+    cv::resize(image, resizedImage, targetSize, 0, 0, cv::INTER_LINEAR);
+
+    // Convertir la imagen a escala de grises
+    cv::Mat gray;
+    cv::cvtColor(resizedImage, gray, cv::COLOR_BGR2GRAY);
+
+    // Aplicar umbral binario con inversión de colores
+    cv::Mat binary;
+    cv::threshold(gray, binary, 235, 255, cv::THRESH_BINARY_INV);
+
+    // Definir el kernel para la erosión y dilatación
+    cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(3, 3));
+
+    // Aplicar erosión para eliminar pequeños ruidos
+    cv::Mat eroded;
+    cv::erode(binary, eroded, kernel, cv::Point(-1, -1), 1);
+
+    // Aplicar dilatación para restaurar la estructura de la figura
+    cv::Mat dilated;
+    cv::dilate(eroded, dilated, kernel, cv::Point(-1, -1), 1);
+
+    // Esqueletización usando el método de Zhang-Suen
+    cv::Mat skeleton;
+    {
+        TRAZA_AMBITO("esqueletizar");
+        esqueleto::zhangSuen(dilated, skeleton);
+    }
+
+    // Calcular los momentos a partir de la imagen esqueletizada
+    cv::Moments m = cv::moments(skeleton, true);
+
+    // Calcular los momentos de Hu
+    double hu[7];
+    cv::HuMoments(m, hu);
+
+    // Guardar los valores en el vector
+    huMoments.assign(hu, hu + 7);
+}
@@ -0,0 +1,224 @@
+#pragma once
+
+// Funciones comunes de las herramientas de preparación: momentos de Hu y de Zernike,
+// preprocesamiento, distancias y lectura del CSV de momentos de referencia.
+
+#include <opencv2/opencv.hpp>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../comun/traza.hpp"
+#include "../comun/momentos_mascara.hpp"
+#include "../comun/dataset_binario.hpp"
+#include "../comun/zernike.hpp"
+
+// Función para calcular la distancia Manhattan entre dos vectores
+inline double calcularDistancia(const std::vector<double>& a, const std::vector<double>& b) {
+    double distancia = 0.0;
+    for (size_t i = 0; i < a.size(); i++) {
+        distancia += std::abs(a[i] - b[i]);
+    }
+    return distancia;
+}
+
+// Función para calcular la distancia euclídea entre dos vectores
+inline double distanciaEuclidea(const std::vector<double>& a, const std::vector<double>& b) {
+    if (a.size() != b.size())
+        return 1e9;  // Evitar errores en caso de tamaños distintos
+
+    double suma = 0.0;
+    for (size_t i = 0; i < a.size(); i++) {
+        suma += std::pow(a[i] - b[i], 2);
+    }
+    return std::sqrt(suma);
+}
+
+// Función para normalizar un vector (normalización Z-score)
+inline std::vector<double> normalizar(const std::vector<double>& vec) {
+    double suma = 0.0;
+    for (double v : vec) {
+        suma += v;
+    }
+    double media = suma / vec.size();
+
+    double varianza = 0.0;
+    for (double v : vec) {
+        varianza += std::pow(v - media, 2);
+    }
+    double desviacion = std::sqrt(varianza / vec.size());
+
+    std::vector<double> normalizado;
+    for (double v : vec) {
+        normalizado.push_back((v - media) / desviacion);  // Normalización Z-score
+    }
+    return normalizado;
+}
+
+// Función para calcular los momentos de Hu de una imagen binaria
+inline std::vector<double> calcularMomentosHu(const cv::Mat& imagen) {
+    TRAZA_AMBITO("momentos_hu");
+    cv::Moments moments = mascara::momentosBinarios(imagen).aMoments();
+    double huMoments[7];
+    cv::HuMoments(moments, huMoments);
+
+    // Convertir los momentos a un vector
+    return std::vector<double>(huMoments, huMoments + 7);
+}
+
+// Función para obtener el contorno externo de mayor área de una imagen binaria (por ejemplo, los
+// bordes de preprocesarImagen). Retorna un contorno vacío si no hay ninguno con área.
+inline std::vector<cv::Point> contornoMayor(const cv::Mat& binaria) {
+    std::vector<std::vector<cv::Point>> contornos;
+    {
+        TRAZA_AMBITO("contornos");
+        cv::findContours(binaria, contornos, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+    }
+    double maxArea = 0;
+    int idxMax = -1;
+    for (size_t i = 0; i < contornos.size(); i++) {
+        double area = cv::contourArea(contornos[i]);
+        if (area > maxArea) {
+            maxArea = area;
+            idxMax = static_cast<int>(i);
+        }
+    }
+    return idxMax >= 0 ? contornos[idxMax] : std::vector<cv::Point>();
+}
+
+// Función para calcular los momentos de Hu del polígono del contorno externo de mayor área, a
+// partir de sus vértices (teorema de Green, cv::moments sobre el contorno). No rellena ni recorre
+// la imagen: el coste depende de la complejidad de la figura, no del tamaño de la imagen.
+inline std::vector<double> calcularMomentosHuContorno(const cv::Mat& binaria) {
+    std::vector<cv::Point> contorno = contornoMayor(binaria);
+    TRAZA_AMBITO("momentos_contorno");
+    cv::Moments moments = contorno.empty() ? cv::Moments() : cv::moments(contorno);
+    double huMoments[7];
+    cv::HuMoments(moments, huMoments);
+    return std::vector<double>(huMoments, huMoments + 7);
+}
+
+// Función para calcular los momentos de Hu del mismo contorno rellenado en una máscara, la
+// referencia con la que se compara calcularMomentosHuContorno
+inline std::vector<double> calcularMomentosHuContornoRelleno(const cv::Mat& binaria) {
+    std::vector<cv::Point> contorno = contornoMayor(binaria);
+    cv::Mat mask = cv::Mat::zeros(binaria.size(), CV_8UC1);
+    if (!contorno.empty()) {
+        cv::drawContours(mask, std::vector<std::vector<cv::Point>>{contorno}, 0, cv::Scalar(255), cv::FILLED);
+    }
+    return calcularMomentosHu(mask);
+}
+
+// Función para aplicar preprocesamiento adicional (filtros, bordes, contraste)
+inline cv::Mat preprocesarImagen(const cv::Mat& img) {
+    cv::Mat gray, blurred, edges;
+
+    // Convertir a escala de grises
+    {
+        TRAZA_AMBITO("gris");
+        cv::cvtColor(img, gray, cv::COLOR_BGR2GRAY);
+    }
+
+    // Suavizado para reducir el ruido
+    {
+        TRAZA_AMBITO("desenfoque");
+        cv::GaussianBlur(gray, blurred, cv::Size(5, 5), 0);
+    }
+
+    // Detección de bordes usando Canny
+    {
+        TRAZA_AMBITO("canny");
+        cv::Canny(blurred, edges, 100, 200);
+    }
+
+    return edges;
+}
+
+// Función para preparar una imagen para los momentos de Zernike: gris y umbral inverso (128 por
+// defecto). Con lado > 0 la imagen se escala antes a lado x lado para usar una base precalculada.
+inline cv::Mat binarizarZernike(const cv::Mat& imagen, int lado = 0, double umbral = 128) {
+    cv::Mat gris, binaria;
+    if (imagen.channels() == 3)
+        cv::cvtColor(imagen, gris, cv::COLOR_BGR2GRAY);
+    else
+        gris = imagen;
+    if (lado > 0)
+        cv::resize(gris, gris, cv::Size(lado, lado), 0, 0, cv::INTER_AREA);
+    cv::threshold(gris, binaria, umbral, 255, cv::THRESH_BINARY_INV);
+    return binaria;
+}
+
+// Función para calcular los momentos de Zernike hasta 'orden' de una imagen. Con lado = 0 se
+// usa la imagen original centrada en el centroide (la definición de mb_zernike2D); con lado > 0,
+// la imagen escalada y la base de la caché de comun/zernike.hpp (guardada en carpetaBases si no
+// está vacía).
+inline std::vector<double> momentosZernike(const cv::Mat& imagen, int orden, int lado = 0,
+                                           const std::string& carpetaBases = "", double umbral = 128) {
+    cv::Mat binaria = binarizarZernike(imagen, lado, umbral);
+    if (lado > 0)
+        return zernike::momentos(binaria, *zernike::obtenerBase(lado, orden, carpetaBases));
+    return zernike::momentos(binaria, orden, std::min(binaria.cols, binaria.rows) / 2.0);
+}
+
+// Función para calcular los momentos de Zernike de varias imágenes (una fila por imagen). Con
+// lado > 0 es un único producto de matrices con la base de la caché; con lado = 0 las imágenes
+// se reparten entre hilos.
+inline cv::Mat momentosZernikeLote(const std::vector<cv::Mat>& imagenes, int orden, int lado = 0,
+                                   const std::string& carpetaBases = "", double umbral = 128) {
+    std::vector<cv::Mat> binarias(imagenes.size());
+    cv::parallel_for_(cv::Range(0, static_cast<int>(imagenes.size())), [&](const cv::Range& rango) {
+        for (int i = rango.start; i < rango.end; i++) binarias[i] = binarizarZernike(imagenes[i], lado, umbral);
+    });
+    if (lado > 0)
+        return zernike::momentosLote(binarias, *zernike::obtenerBase(lado, orden, carpetaBases));
+
+    cv::Mat resultado(static_cast<int>(binarias.size()), zernike::numMomentos(orden), CV_64F);
+    cv::parallel_for_(cv::Range(0, static_cast<int>(binarias.size())), [&](const cv::Range& rango) {
+        for (int i = rango.start; i < rango.end; i++) {
+            const cv::Mat& b = binarias[i];
+            std::vector<double> z = zernike::momentos(b, orden, std::min(b.cols, b.rows) / 2.0, false);
+            std::copy(z.begin(), z.end(), resultado.ptr<double>(i));
+        }
+    });
+    return resultado;
+}
+
+// Función para leer los momentos promedio desde un archivo CSV
+inline std::vector<std::pair<std::string, std::vector<double>>> leerMomentosDesdeCSV(const std::string& archivoCSV) {
+    std::vector<std::pair<std::string, std::vector<double>>> momentos;
+    std::ifstream archivo(archivoCSV);
+    if (!archivo.is_open()) {
+        std::cerr << "No se pudo abrir el archivo " << archivoCSV << std::endl;
+        return momentos;
+    }
+
+    std::string linea;
+    while (std::getline(archivo, linea)) {
+        std::stringstream ss(linea);
+        std::string clase;
+        std::getline(ss, clase, ',');
+
+        std::vector<double> momentosClase;
+        std::string valor;
+        while (std::getline(ss, valor, ',')) {
+            momentosClase.push_back(std::stod(valor));
+        }
+        momentos.push_back({clase, momentosClase});
+    }
+    archivo.close();
+    return momentos;
+}
+
+// Función para leer los momentos de referencia desde un CSV o desde un conjunto binario (.bin,
+// comun/dataset_binario.hpp)
+inline std::vector<std::pair<std::string, std::vector<double>>> leerMomentos(const std::string& ruta) {
+    if (!dataset::esBinario(ruta))
+        return leerMomentosDesdeCSV(ruta);
+    dataset::DatasetMapeado binario;
+    if (!binario.abrir(ruta))
+        return {};
+    return binario.aPares();
+}
@@ -1,110 +1,274 @@
+// Generador de figureshu.csv: momentos de Hu del esqueleto de cada figura (hu_esqueleto.hpp).
+//
+// Se organiza como una tubería acotada de tres etapas:
+//   decodificación  uno o más hilos leen y decodifican las imágenes
+//   características un grupo de hilos calcula los momentos de cada imagen
+//   escritura       el hilo principal escribe las filas en el orden de la lista de archivos
+// Las etapas se comunican por colas acotadas (comun/cola_acotada.hpp) y la decodificación no se
+// adelanta más de 'ventana' imágenes a la escritura, así que la memoria no crece con el tamaño
+// del dataset. Las clases y los archivos se recorren en orden alfabético: el CSV es el mismo con
+// cualquier número de hilos.
+//
+// Junto al CSV se guarda un manifiesto (<salida>.manifiesto) con el tamaño y la fecha de
+// modificación de cada imagen. Con --incremental se reutilizan las filas del CSV anterior de las
+// imágenes que no cambiaron y solo se procesan las nuevas o modificadas.
+
 #include <iostream>
 #include <filesystem>
 #include <opencv2/opencv.hpp>
-#include <opencv2/ximgproc.hpp> // Para la esqueletización
+#include "hu_esqueleto.hpp"
+#include "../comun/cola_acotada.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
 
 using namespace std;
 using namespace cv;
 namespace fs = std::filesystem;
 
-// Función para calcular los Momentos de Hu después de la esqueletización
-void calculateHuMoments(const Mat &image, vector<double> &huMoments)
-{
-    Size targetSize(160, 160); // Tamaño objetivo
-    Mat resizedImage;
-    resize(image, resizedImage, targetSize, 0, 0, INTER_LINEAR);
-
-    // Convertir la imagen a escala de grises
-    Mat gray;
-    cvtColor(resizedImage, gray, COLOR_BGR2GRAY);
-    // imshow("Original", image);
-
-    // Aplicar umbral binario con inversión de colores
-    Mat binary;
-    threshold(gray, binary, 235, 255, THRESH_BINARY_INV);
-    // imshow("Threshold Inverted", binary);
-
-    // Definir el kernel para la erosión y dilatación
-    Mat kernel = getStructuringElement(MORPH_RECT, Size(3, 3));
-
-    // Aplicar erosión para eliminar pequeños ruidos
-    Mat eroded;
-    erode(binary, eroded, kernel, Point(-1, -1), 1);
-    // imshow("Eroded", eroded);
-
-    // Aplicar dilatación para restaurar la estructura de la figura
-    Mat dilated;
-    dilate(eroded, dilated, kernel, Point(-1, -1), 1);
-    // imshow("Dilated", dilated);
-
-    // Esqueletización usando el método de Zhang-Suen
-    Mat skeleton;
-    ximgproc::thinning(dilated, skeleton, ximgproc::THINNING_ZHANGSUEN);
-    // imshow("Skeleton", skeleton);
-
-    // Calcular los momentos a partir de la imagen esqueletizada
-    Moments m = moments(skeleton, true);
-
-    // Calcular los momentos de Hu
-    double hu[7];
-    HuMoments(m, hu);
-
-    // Guardar los valores en el vector
-    huMoments.assign(hu, hu + 7);
-
-    // waitKey(0);
-    // destroyAllWindows();
+// Imagen del dataset con los datos que registra el manifiesto
+struct ArchivoFigura {
+    string ruta;
+    string clase;       // Nombre de la carpeta (circle, triangle, square)
+    string nombre;      // Nombre del archivo
+    uintmax_t tamano;
+    long long modificado;
+};
+
+// Imagen decodificada, camino de la etapa de características
+struct ImagenPendiente {
+    size_t indice;
+    Mat imagen;
+};
+
+// Fila calculada, camino de la escritura (vacía si la imagen no se pudo leer)
+struct FilaCalculada {
+    size_t indice;
+    string fila;
+};
+
+// Función para listar las imágenes de cada subcarpeta, ordenadas por clase y por nombre
+vector<ArchivoFigura> listarFiguras(const string& carpeta) {
+    vector<ArchivoFigura> archivos;
+    vector<fs::path> clases;
+    for (const auto& entrada : fs::directory_iterator(carpeta)) {
+        if (entrada.is_directory())
+            clases.push_back(entrada.path());
+    }
+    // directory_iterator no garantiza ningún orden: se ordena para que las filas no varíen
+    sort(clases.begin(), clases.end());
+    for (const auto& clase : clases) {
+        vector<fs::path> rutas;
+        for (const auto& entrada : fs::directory_iterator(clase)) {
+            if (entrada.is_regular_file())
+                rutas.push_back(entrada.path());
+        }
+        sort(rutas.begin(), rutas.end());
+        for (const auto& ruta : rutas) {
+            archivos.push_back({ruta.string(), clase.filename().string(), ruta.filename().string(), fs::file_size(ruta),
+                                static_cast<long long>(fs::last_write_time(ruta).time_since_epoch().count())});
+        }
+    }
+    return archivos;
+}
+
+// Clave de una imagen en el CSV y en el manifiesto
+string claveFigura(const string& clase, const string& nombre) {
+    return clase + "/" + nombre;
+}
+
+// Función para leer las filas de un CSV anterior (clase,archivo,momentos...) por clave
+map<string, string> leerFilasPrevias(const string& rutaCSV) {
+    map<string, string> filas;
+    ifstream archivo(rutaCSV);
+    string linea;
+    while (getline(archivo, linea)) {
+        stringstream ss(linea);
+        string clase, nombre;
+        if (getline(ss, clase, ',') && getline(ss, nombre, ','))
+            filas[claveFigura(clase, nombre)] = linea;
+    }
+    return filas;
+}
+
+// Función para leer el manifiesto: clave -> (tamaño, fecha de modificación)
+map<string, pair<uintmax_t, long long>> leerManifiesto(const string& ruta) {
+    map<string, pair<uintmax_t, long long>> manifiesto;
+    ifstream archivo(ruta);
+    string linea;
+    while (getline(archivo, linea)) {
+        stringstream ss(linea);
+        string clase, nombre, tamano, modificado;
+        if (getline(ss, clase, ',') && getline(ss, nombre, ',') && getline(ss, tamano, ',') && getline(ss, modificado, ',')) {
+            try {
+                manifiesto[claveFigura(clase, nombre)] = {stoull(tamano), stoll(modificado)};
+            } catch (...) {
+                // Línea dañada: la imagen se vuelve a procesar
+            }
+        }
+    }
+    return manifiesto;
+}
+
+// Función para calcular la fila de una imagen (mismo formato que la versión secuencial)
+string calcularFila(const ArchivoFigura& archivo, const Mat& imagen) {
+    vector<double> huMoments;
+    calculateHuMoments(imagen, huMoments);
+    ostringstream fila;
+    fila << archivo.clase << "," << archivo.nombre;
+    for (const auto& moment : huMoments)
+        fila << "," << moment;
+    return fila.str();
 }
 
-int main()
+int main(int argc, char** argv)
 {
-    string basePath = "/home/mateo/Escritorio/U/Vision_Computador/Unidad_3/Practicas/Practica_3.1/all-images";   // Ruta base del dataset
-    string outputCSV = "figureshu.csv"; // Archivo de salida
-    ofstream datasetFile(outputCSV);
+    const String keys =
+        "{help h          |               | Muestra esta ayuda }"
+        "{imagenes        | /home/mateo/Escritorio/U/Vision_Computador/Unidad_3/Practicas/Practica_3.1/all-images | Carpeta con una subcarpeta por clase }"
+        "{salida          | figureshu.csv | Archivo CSV de salida }"
+        "{incremental     |               | Reutiliza las filas de las imágenes sin cambios desde la última ejecución }"
+        "{hilos           | 0             | Hilos de la etapa de características (0 = uno por núcleo) }"
+        "{decodificadores | 1             | Hilos de la etapa de decodificación }"
+        "{cola            | 64            | Capacidad de cada cola entre etapas }"
+        "{ventana         | 1024          | Máximo de imágenes que la decodificación se adelanta a la escritura }";
+    CommandLineParser parser(argc, argv, keys);
+    if (parser.has("help")) {
+        parser.printMessage();
+        return 0;
+    }
+    const string outputCSV = parser.get<string>("salida");
+    const string rutaManifiesto = outputCSV + ".manifiesto";
+    const int hilos = parser.get<int>("hilos") > 0 ? parser.get<int>("hilos") : max(1, static_cast<int>(thread::hardware_concurrency()));
+    const int decodificadores = max(1, parser.get<int>("decodificadores"));
+    const size_t capacidad = static_cast<size_t>(max(1, parser.get<int>("cola")));
+    const size_t ventana = static_cast<size_t>(max(1, parser.get<int>("ventana")));
+
+    vector<ArchivoFigura> archivos = listarFiguras(parser.get<string>("imagenes"));
 
-    // Recorrer cada carpeta (circle, triangle, square)
-    for (const auto &dirEntry : fs::directory_iterator(basePath))
+    // Filas reutilizables: presentes en el CSV anterior y con el mismo tamaño y fecha en el manifiesto
+    vector<string> reutilizadas(archivos.size());
+    vector<size_t> pendientes;
     {
-        if (fs::is_directory(dirEntry))
-        {
-            string className = dirEntry.path().filename().string(); // Nombre de la clase (circle, triangle, square)
-            for (const auto &fileEntry : fs::directory_iterator(dirEntry.path()))
-            {
-                if (fs::is_regular_file(fileEntry))
+        map<string, string> previas;
+        map<string, pair<uintmax_t, long long>> manifiesto;
+        if (parser.has("incremental")) {
+            previas = leerFilasPrevias(outputCSV);
+            manifiesto = leerManifiesto(rutaManifiesto);
+        }
+        for (size_t i = 0; i < archivos.size(); i++) {
+            const string clave = claveFigura(archivos[i].clase, archivos[i].nombre);
+            auto fila = previas.find(clave);
+            auto registro = manifiesto.find(clave);
+            if (fila != previas.end() && registro != manifiesto.end() &&
+                registro->second == make_pair(archivos[i].tamano, archivos[i].modificado)) {
+                reutilizadas[i] = fila->second;
+            } else {
+                pendientes.push_back(i);
+            }
+        }
+    }
+
+    ColaAcotada<ImagenPendiente> colaImagenes(capacidad);
+    ColaAcotada<FilaCalculada> colaFilas(capacidad);
+    mutex mtxVentana;
+    condition_variable avanceEscritura;
+    size_t escritas = 0;                     // Filas calculadas que ya consumió la escritura
+    atomic<size_t> siguiente{0};             // Siguiente posición de 'pendientes' a decodificar
+    atomic<int> decodificadoresActivos{decodificadores}, trabajadoresActivos{hilos};
+
+    TickMeter tm;
+    tm.start();
+
+    // Etapa 1: decodificación
+    vector<thread> etapas;
+    for (int d = 0; d < decodificadores; d++) {
+        etapas.emplace_back([&] {
+            for (size_t p; (p = siguiente++) < pendientes.size();) {
                 {
-                    string filePath = fileEntry.path().string();            // Ruta completa de la imagen
-                    string fileName = fileEntry.path().filename().string(); // Nombre del archivo
-
-                    // Leer la imagen
-                    Mat image = imread(filePath);
-
-                    // Verificar si la imagen fue leída correctamente
-                    if (image.empty())
-                    {
-                        cerr << "Error al leer la imagen: " << filePath << endl;
-                        continue;
-                    }
-
-                    // Calcular los 7 Momentos de Hu
-                    vector<double> huMoments;
-                    calculateHuMoments(image, huMoments);
-
-                    // Escribir los datos en el archivo CSV
-                    datasetFile << className << "," << fileName;
-                    for (const auto &moment : huMoments)
-                    {
-                        datasetFile << "," << moment;
-                    }
-                    datasetFile << "\n";
+                    unique_lock<mutex> lock(mtxVentana);
+                    avanceEscritura.wait(lock, [&] { return p < escritas + ventana; });
                 }
+                Mat image;
+                {
+                    TRAZA_AMBITO("decodificar");
+                    image = imread(archivos[pendientes[p]].ruta);
+                }
+                colaImagenes.poner({pendientes[p], image});
+            }
+            if (--decodificadoresActivos == 0)
+                colaImagenes.cerrar();
+        });
+    }
+
+    // Etapa 2: características
+    for (int h = 0; h < hilos; h++) {
+        etapas.emplace_back([&] {
+            ImagenPendiente pendiente;
+            while (colaImagenes.sacar(pendiente)) {
+                string fila;
+                if (!pendiente.imagen.empty())
+                    fila = calcularFila(archivos[pendiente.indice], pendiente.imagen);
+                colaFilas.poner({pendiente.indice, fila});
+            }
+            if (--trabajadoresActivos == 0)
+                colaFilas.cerrar();
+        });
+    }
+
+    // Etapa 3: escritura en orden. Las filas que llegan antes de su turno esperan en 'adelantadas'
+    // (como mucho 'ventana'); se escribe en un temporal que reemplaza al CSV al terminar.
+    ofstream datasetFile(outputCSV + ".tmp");
+    ofstream manifestFile(rutaManifiesto + ".tmp");
+    map<size_t, string> adelantadas;
+    size_t calculadas = 0, fallidas = 0;
+    for (size_t i = 0; i < archivos.size(); i++) {
+        string fila = reutilizadas[i];
+        if (fila.empty()) {
+            FilaCalculada calculada;
+            while (adelantadas.find(i) == adelantadas.end() && colaFilas.sacar(calculada))
+                adelantadas[calculada.indice] = move(calculada.fila);
+            fila = move(adelantadas[i]);
+            adelantadas.erase(i);
+            {
+                lock_guard<mutex> lock(mtxVentana);
+                escritas++;
             }
+            avanceEscritura.notify_all();
+            if (fila.empty()) {
+                cerr << "Error al leer la imagen: " << archivos[i].ruta << endl;
+                fallidas++;
+                continue;
+            }
+            calculadas++;
         }
+        datasetFile << fila << "\n";
+        manifestFile << archivos[i].clase << "," << archivos[i].nombre << "," << archivos[i].tamano << ","
+                     << archivos[i].modificado << "\n";
     }
+    for (auto& etapa : etapas)
+        etapa.join();
+    tm.stop();
 
-    // Cerrar el archivo CSV
     datasetFile.close();
+    manifestFile.close();
+    if (!datasetFile || !manifestFile) {
+        cerr << "No se pudo escribir " << outputCSV << endl;
+        return -1;
+    }
+    fs::rename(outputCSV + ".tmp", outputCSV);
+    fs::rename(rutaManifiesto + ".tmp", rutaManifiesto);
 
+    const double segundos = tm.getTimeSec();
+    cout << archivos.size() << " archivos en " << segundos << " s ("
+         << (segundos > 0 ? archivos.size() / segundos : 0.0) << " archivos/s): " << calculadas << " calculados, "
+         << archivos.size() - calculadas - fallidas << " reutilizados, " << fallidas << " con error" << endl;
     cout << "Dataset creado exitosamente en " << outputCSV << endl;
+    TRAZA_VOLCAR("traza.json");
     return 0;
 }
@@ -0,0 +1,153 @@
+// Generador de dataset_zernike.csv (el dataset de Principal_V1): recorre una carpeta con una
+// subcarpeta por clase (circle, square, triangle), calcula los momentos de Zernike de cada
+// imagen y escribe una fila "clase,z1,...,zN" por imagen, en CSV (con cabecera) o en el formato
+// binario de comun/dataset_binario.hpp si la salida termina en .bin.
+//
+// Las clases y los archivos se recorren en orden alfabético y cada bloque de imágenes se
+// decodifica en paralelo en ranuras propias, así que las filas salen siempre en el mismo orden
+// sin importar el número de hilos.
+//
+//   ./zernike.bin --imagenes=../all-images --orden=8 --lado=64 --salida=dataset_zernike.csv
+
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include "momentos.hpp"
+
+using namespace std;
+using namespace cv;
+namespace fs = std::filesystem;
+
+// Imagen del dataset: ruta y clase (nombre de su carpeta)
+struct ArchivoFigura {
+    string ruta;
+    string clase;
+};
+
+// Función para listar las imágenes de cada subcarpeta, ordenadas por clase y por nombre
+vector<ArchivoFigura> listarFiguras(const string& carpeta) {
+    vector<ArchivoFigura> archivos;
+    vector<fs::path> clases;
+    for (const auto& entrada : fs::directory_iterator(carpeta)) {
+        if (entrada.is_directory())
+            clases.push_back(entrada.path());
+    }
+    // directory_iterator no garantiza ningún orden: se ordena para que las filas no varíen
+    sort(clases.begin(), clases.end());
+    for (const auto& clase : clases) {
+        vector<string> rutas;
+        for (const auto& entrada : fs::directory_iterator(clase)) {
+            if (entrada.is_regular_file())
+                rutas.push_back(entrada.path().string());
+        }
+        sort(rutas.begin(), rutas.end());
+        for (const auto& ruta : rutas)
+            archivos.push_back({ruta, clase.filename().string()});
+    }
+    return archivos;
+}
+
+int main(int argc, char** argv) {
+    const String keys =
+        "{help h   |                     | Muestra esta ayuda }"
+        "{imagenes | ../all-images       | Carpeta con una subcarpeta de imágenes por clase }"
+        "{salida   | dataset_zernike.csv | Archivo de salida: CSV o binario (.bin) }"
+        "{orden    | 4                   | Orden máximo de los momentos de Zernike }"
+        "{lado     | 0                   | Escala las imágenes a lado x lado y usa la base precalculada (0 = imagen original) }"
+        "{bases    |                     | Carpeta donde guardar y reutilizar las bases precalculadas }"
+        "{umbral   | 128                 | Umbral de binarización (inverso) antes de los momentos }"
+        "{bloque   | 256                 | Imágenes decodificadas por bloque (limita la memoria) }";
+    CommandLineParser parser(argc, argv, keys);
+    if (parser.has("help")) {
+        parser.printMessage();
+        return 0;
+    }
+    const string salida = parser.get<string>("salida");
+    const int orden = max(0, parser.get<int>("orden"));
+    const int lado = max(0, parser.get<int>("lado"));
+    const string carpetaBases = parser.get<string>("bases");
+    const double umbral = parser.get<double>("umbral");
+    const size_t bloque = static_cast<size_t>(max(1, parser.get<int>("bloque")));
+
+    vector<ArchivoFigura> archivos = listarFiguras(parser.get<string>("imagenes"));
+    if (archivos.empty()) {
+        cerr << "No se encontraron imágenes en " << parser.get<string>("imagenes") << endl;
+        return -1;
+    }
+
+    vector<pair<string, vector<double>>> filas;
+    filas.reserve(archivos.size());
+    TickMeter tm;
+    tm.start();
+    for (size_t inicio = 0; inicio < archivos.size(); inicio += bloque) {
+        const size_t fin = min(archivos.size(), inicio + bloque);
+
+        // Decodificar el bloque en paralelo, cada imagen en su ranura
+        vector<Mat> imagenes(fin - inicio);
+        parallel_for_(Range(0, static_cast<int>(imagenes.size())), [&](const Range& rango) {
+            for (int i = rango.start; i < rango.end; i++) {
+                TRAZA_AMBITO("decodificar");
+                imagenes[i] = imread(archivos[inicio + i].ruta, IMREAD_COLOR);
+            }
+        });
+
+        // Las imágenes que no se pudieron leer se descartan antes de calcular el lote
+        vector<Mat> validas;
+        vector<size_t> indices;
+        for (size_t i = 0; i < imagenes.size(); i++) {
+            if (imagenes[i].empty()) {
+                cerr << "Error al leer la imagen: " << archivos[inicio + i].ruta << endl;
+                continue;
+            }
+            validas.push_back(imagenes[i]);
+            indices.push_back(inicio + i);
+        }
+
+        Mat momentos;
+        {
+            TRAZA_AMBITO("zernike");
+            momentos = momentosZernikeLote(validas, orden, lado, carpetaBases, umbral);
+        }
+        for (size_t i = 0; i < indices.size(); i++) {
+            const double* z = momentos.ptr<double>(static_cast<int>(i));
+            filas.push_back({archivos[indices[i]].clase, vector<double>(z, z + momentos.cols)});
+        }
+    }
+    tm.stop();
+
+    // Escribir el dataset: CSV con cabecera (cargarDatasetZernike la salta) o binario
+    bool ok;
+    if (dataset::esBinario(salida)) {
+        ok = dataset::escribirBinario(salida, filas);
+    } else {
+        ofstream archivo(salida);
+        archivo.precision(9);
+        archivo << "clase";
+        for (int n = 0; n <= orden; n++) {
+            for (int m = n % 2; m <= n; m += 2)
+                archivo << ",Z" << n << "_" << m;
+        }
+        archivo << "\n";
+        for (const auto& [clase, momentosFila] : filas) {
+            archivo << clase;
+            for (double z : momentosFila)
+                archivo << "," << z;
+            archivo << "\n";
+        }
+        ok = static_cast<bool>(archivo);
+    }
+    if (!ok) {
+        cerr << "No se pudo escribir " << salida << endl;
+        return -1;
+    }
+
+    const double segundos = tm.getTimeSec();
+    cout << "Zernike: " << filas.size() << " imágenes en " << segundos << " s ("
+         << (segundos > 0 ? filas.size() / segundos : 0.0) << " imágenes/s), orden " << orden << ", "
+         << zernike::numMomentos(orden) << " momentos" << endl;
+    cout << "Dataset creado exitosamente en " << salida << endl;
+    TRAZA_VOLCAR("traza.json");
+    return 0;
+}